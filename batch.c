@@ -0,0 +1,219 @@
+/*************************************************************************
+ * batch.c
+ *
+ * Implements batched multiplication (see batch.h). Every entry is
+ * multiplied by the same i-k-j kernel as multiply_accumulate, straight
+ * on the contiguous entries, with the bignum type's bignum_axpy as its
+ * inner loop where it has one. Square sizes from 4 to 64 call it
+ * through wrappers with the sizes fixed at compile time, so an
+ * optimizing build unrolls and schedules each one for its size; other
+ * shapes use it with the sizes as arguments.
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch.h"
+#include "memtrack.h"
+#include "parallel.h"
+
+// kernel multiplying one entry: c = a * b
+typedef void (*BATCH_KERNEL)(BIGNUM* a, BIGNUM* b, BIGNUM* c);
+
+/**
+ * NAME: kernel
+ * INPUT: BIGNUM* a, BIGNUM* b, BIGNUM* c, int rowSize,
+ *          int innerSize, int colSize
+ * USAGE: c = a * b for row-major rowSize by innerSize a and innerSize
+ *          by colSize b.
+ *
+ * NOTES: the loops of multiply_accumulate, on rows found by offset
+ *          rather than through row pointers.
+ */
+static inline void kernel(BIGNUM* a, BIGNUM* b, BIGNUM* c,
+                          int rowSize, int innerSize, int colSize)
+{
+    for (int i = 0; i < rowSize * colSize; i++)
+        bignum_from_int(0, &c[i]);
+    for (int i = 0; i < rowSize; i++)
+    {
+        BIGNUM* out = c + i * colSize;
+        for (int k = 0; k < innerSize; k++)
+        {
+            BIGNUM* x = &a[i * innerSize + k];
+            BIGNUM* row = b + k * colSize;
+#ifdef BIGNUM_AXPY
+            bignum_axpy(out, x, row, colSize);
+#else
+            BIGNUM product, sum;
+            for (int j = 0; j < colSize; j++)
+            {
+                // mult_bignums adds into its result, so start from zero.
+                bignum_from_int(0, &product);
+                mult_bignums(x, &row[j], &product);
+                add_bignums(&out[j], &product, &sum);
+                out[j] = sum;
+            }
+#endif
+        }
+    }
+}
+
+// kernel_N multiplies N by N entries.
+#define SQUARE_KERNEL(N) \
+    static void kernel_##N(BIGNUM* a, BIGNUM* b, BIGNUM* c) \
+    { \
+        kernel(a, b, c, N, N, N); \
+    }
+
+SQUARE_KERNEL(4)
+SQUARE_KERNEL(8)
+SQUARE_KERNEL(16)
+SQUARE_KERNEL(32)
+SQUARE_KERNEL(64)
+
+static const struct
+{
+    int size;
+    BATCH_KERNEL fn;
+}
+squareKernels[] =
+{
+    {4, kernel_4},
+    {8, kernel_8},
+    {16, kernel_16},
+    {32, kernel_32},
+    {64, kernel_64},
+};
+#define NUM_SQUARE_KERNELS (int) (sizeof(squareKernels) / sizeof(squareKernels[0]))
+
+/**
+ * NAME: batch_alloc
+ * INPUT: int count, int rowSize, int colSize, BATCH* b
+ * USAGE: allocates b as count matrices of rowSize by colSize. Entries
+ *          are left uninitialized.
+ *
+ * NOTES: the storage is counted by memtrack.
+ */
+void batch_alloc(int count, int rowSize, int colSize, BATCH* b)
+{
+    size_t bytes = (size_t) count * rowSize * colSize * sizeof(BIGNUM);
+    b->data = malloc(bytes);
+    memtrack_alloc(bytes);
+    b->count = count;
+    b->numRows = rowSize;
+    b->numCols = colSize;
+}
+
+/**
+ * NAME: batch_entry
+ * INPUT: BATCH* b, int e
+ * OUTPUT: BIGNUM*
+ * USAGE: the first cell of entry e.
+ */
+BIGNUM* batch_entry(BATCH* b, int e)
+{
+    return b->data + (size_t) e * b->numRows * b->numCols;
+}
+
+/**
+ * NAME: batch_load
+ * INPUT: BATCH* b, int e, MATRIX* m
+ * USAGE: copies m, which must have the batch's shape, into entry e.
+ */
+void batch_load(BATCH* b, int e, MATRIX* m)
+{
+    BIGNUM* entry = batch_entry(b, e);
+    for (int i = 0; i < b->numRows; i++)
+        memcpy(entry + i * b->numCols, m->matrix[i], b->numCols * sizeof(BIGNUM));
+}
+
+/**
+ * NAME: batch_store
+ * INPUT: BATCH* b, int e, MATRIX* m
+ * USAGE: initializes m to a copy of entry e.
+ *
+ * NOTES: assumes m is malloced.
+ */
+void batch_store(BATCH* b, int e, MATRIX* m)
+{
+    BIGNUM* entry = batch_entry(b, e);
+    alloc_matrix(b->numRows, b->numCols, m);
+    for (int i = 0; i < b->numRows; i++)
+        memcpy(m->matrix[i], entry + i * b->numCols, b->numCols * sizeof(BIGNUM));
+}
+
+// Arguments of the parallel multiplication.
+typedef struct
+{
+    BATCH* a;
+    BATCH* b;
+    BATCH* c;
+    BATCH_KERNEL fn;
+}
+BATCH_ARGS;
+
+/**
+ * NAME: mult_entries
+ * INPUT: int begin, int end, void* arg
+ * USAGE: parallel_for body multiplying entries [begin, end).
+ */
+static void mult_entries(int begin, int end, void* arg)
+{
+    BATCH_ARGS* args = arg;
+    for (int e = begin; e < end; e++)
+    {
+        BIGNUM* a = batch_entry(args->a, e);
+        BIGNUM* b = batch_entry(args->b, e);
+        BIGNUM* c = batch_entry(args->c, e);
+        if (args->fn != NULL)
+            args->fn(a, b, c);
+        else
+            kernel(a, b, c, args->a->numRows, args->a->numCols, args->b->numCols);
+    }
+}
+
+/**
+ * NAME: batch_mult
+ * INPUT: BATCH* a, BATCH* b, BATCH* c
+ * OUTPUT: bool
+ * USAGE: sets every entry of c to the product of the same entries of a
+ *          and b. Returns false if the shapes or counts do not fit.
+ *
+ * NOTES: c must already be allocated with a's count and rows and b's
+ *          columns, so it can be reused from one batch to the next.
+ */
+bool batch_mult(BATCH* a, BATCH* b, BATCH* c)
+{
+    if (a->numCols != b->numRows || a->count != b->count || c->count != a->count ||
+        c->numRows != a->numRows || c->numCols != b->numCols)
+    {
+        printf("Error: Batches cannot be multiplied\n");
+        return false;
+    }
+
+    BATCH_ARGS args = {a, b, c, NULL};
+    if (a->numRows == a->numCols && a->numCols == b->numCols)
+    {
+        for (int k = 0; k < NUM_SQUARE_KERNELS; k++)
+        {
+            if (squareKernels[k].size == a->numRows)
+                args.fn = squareKernels[k].fn;
+        }
+    }
+    parallel_for(a->count, mult_entries, &args);
+    return true;
+}
+
+/**
+ * NAME: batch_free
+ * INPUT: BATCH* b
+ * USAGE: frees the storage of b.
+ */
+void batch_free(BATCH* b)
+{
+    memtrack_release((size_t) b->count * b->numRows * b->numCols * sizeof(BIGNUM));
+    free(b->data);
+    b->data = NULL;
+}
@@ -0,0 +1,84 @@
+/****************************************************************************
+ * batch.h
+ *
+ * Computer Science 51
+ * Batched Multiplication
+ *
+ * Multiplies many small independent matrices of one shape at once.
+ * A batch keeps all of its matrices in one contiguous array, entry
+ * after entry, each row-major, so a product needs no allocation at all
+ * and the entries are spread over threads with parallel_for. Common
+ * square sizes get kernels specialized to their size.
+ ***************************************************************************/
+#ifndef _BATCH_H
+#define _BATCH_H
+
+#include <stdbool.h>
+
+#include "matrix.h"
+
+// count matrices of numRows by numCols. Cell (i, j) of entry e is
+// data[(e * numRows + i) * numCols + j].
+typedef struct
+{
+    BIGNUM* data;
+    int count;
+    int numRows;
+    int numCols;
+}
+BATCH;
+
+/**
+ * NAME: batch_alloc
+ * INPUT: int count, int rowSize, int colSize, BATCH* b
+ * USAGE: allocates b as count matrices of rowSize by colSize. Entries
+ *          are left uninitialized.
+ *
+ * NOTES: the storage is counted by memtrack.
+ */
+void batch_alloc(int count, int rowSize, int colSize, BATCH* b);
+
+/**
+ * NAME: batch_entry
+ * INPUT: BATCH* b, int e
+ * OUTPUT: BIGNUM*
+ * USAGE: the first cell of entry e.
+ */
+BIGNUM* batch_entry(BATCH* b, int e);
+
+/**
+ * NAME: batch_load
+ * INPUT: BATCH* b, int e, MATRIX* m
+ * USAGE: copies m, which must have the batch's shape, into entry e.
+ */
+void batch_load(BATCH* b, int e, MATRIX* m);
+
+/**
+ * NAME: batch_store
+ * INPUT: BATCH* b, int e, MATRIX* m
+ * USAGE: initializes m to a copy of entry e.
+ *
+ * NOTES: assumes m is malloced.
+ */
+void batch_store(BATCH* b, int e, MATRIX* m);
+
+/**
+ * NAME: batch_mult
+ * INPUT: BATCH* a, BATCH* b, BATCH* c
+ * OUTPUT: bool
+ * USAGE: sets every entry of c to the product of the same entries of a
+ *          and b. Returns false if the shapes or counts do not fit.
+ *
+ * NOTES: c must already be allocated with a's count and rows and b's
+ *          columns, so it can be reused from one batch to the next.
+ */
+bool batch_mult(BATCH* a, BATCH* b, BATCH* c);
+
+/**
+ * NAME: batch_free
+ * INPUT: BATCH* b
+ * USAGE: frees the storage of b.
+ */
+void batch_free(BATCH* b);
+
+#endif
@@ -0,0 +1,600 @@
+/*************************************************************************
+ * bench.c
+ *
+ * Regression benchmark suite. Runs every algorithm at a fixed set of
+ * sizes, plus the add_bignums/mult_bignums kernels and batches of small
+ * products (batch_mult against a loop of regular_mult), with repeated
+ * sampling. Results can be saved as a baseline file and later runs
+ * compared against it with Welch's t-test; a case that got slower by
+ * more than the threshold with significance is a regression, and the
+ * program then exits with status 1. With PERF_COUNTERS=1 each case also
+ * shows the cycles and instructions of a sample and their IPC (n/a
+ * where the hardware counters cannot be opened), and the per-phase
+ * table of perfcount.h follows.
+ *
+ * "bench" uses bignums and "intbench" uses 64bit ints.
+ * "make baseline" saves baselines, "make benchmark" compares against them.
+ *
+ * Usage: bench [--save FILE | --compare FILE] [--samples N]
+ *              [--threshold PERCENT] [--alpha P]
+ ************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "batch.h"
+#include "bignum.h"
+#include "gen.h"
+#include "matrix.h"
+#include "mult.h"
+#include "perfcount.h"
+#include "sparse.h"
+
+// most cases a baseline file can hold
+#define MAX_CASES 64
+
+// fixed seed so every run multiplies the same matrices
+#define BENCH_SEED 51
+
+// One benchmark result, as stored in a baseline file.
+typedef struct
+{
+    char type[16];
+    char name[32];
+    int size;
+    int samples;
+    double mean;
+    double stddev;
+}
+BENCH_RESULT;
+
+typedef void (*MULT_FN)(MATRIX*, MATRIX*, MATRIX*);
+
+static const struct
+{
+    const char* name;
+    MULT_FN fn;
+}
+algorithms[] =
+{
+    {"regular", regular_mult},
+    {"winograd", winograd_mult},
+    {"strassen", strassen_mult},
+    {"recursive", recursive_mult},
+    {"morton", strassen_morton_mult},
+    {"rect", rect_mult},
+    {"sparse", sparse_matrix_mult},
+};
+#define NUM_ALGORITHMS (int) (sizeof(algorithms) / sizeof(algorithms[0]))
+
+// matrix sizes for the algorithm cases
+static const int sizes[] = {8, 16, 32};
+#define NUM_SIZES (int) (sizeof(sizes) / sizeof(sizes[0]))
+
+// number of calls per sample for the kernel cases
+#define KERNEL_CALLS 2000
+
+// matrix sizes and entries per batch for the batch cases
+static const int batchSizes[] = {4, 8, 16};
+#define NUM_BATCH_SIZES (int) (sizeof(batchSizes) / sizeof(batchSizes[0]))
+#define BATCH_COUNT 64
+
+/* TIMING */
+
+/**
+ * NAME: now
+ * OUTPUT: double
+ * USAGE: monotonic wall clock in seconds.
+ */
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * NAME: summarize
+ * INPUT: double* times, int samples, BENCH_RESULT* r
+ * USAGE: stores the mean and sample standard deviation of times in r.
+ */
+static void summarize(double* times, int samples, BENCH_RESULT* r)
+{
+    double sum = 0.0;
+    for (int i = 0; i < samples; i++)
+        sum += times[i];
+    r->samples = samples;
+    r->mean = sum / samples;
+
+    double sq = 0.0;
+    for (int i = 0; i < samples; i++)
+        sq += (times[i] - r->mean) * (times[i] - r->mean);
+    r->stddev = (samples > 1) ? sqrt(sq / (samples - 1)) : 0.0;
+}
+
+/**
+ * NAME: bench_algorithm
+ * INPUT: MULT_FN fn, int n, int samples, double* times, PERF_PHASE* phase
+ * USAGE: times samples multiplications of two n by n matrices with fn,
+ *          measuring them as phase.
+ */
+static void bench_algorithm(MULT_FN fn, int n, int samples, double* times,
+                            PERF_PHASE* phase)
+{
+    gen_set_seed(BENCH_SEED);
+    MATRIX* m1 = malloc(sizeof(MATRIX));
+    MATRIX* m2 = malloc(sizeof(MATRIX));
+    initialize_matrix(n, n, m1);
+    initialize_matrix(n, n, m2);
+
+    // One untimed warm-up run, then the samples.
+    for (int s = -1; s < samples; s++)
+    {
+        MATRIX* m3 = malloc(sizeof(MATRIX));
+        if (s >= 0)
+            perf_begin(phase);
+        double before = now();
+        fn(m1, m2, m3);
+        double after = now();
+        if (s >= 0)
+            perf_end(phase);
+        free_matrix(m3);
+        if (s >= 0)
+            times[s] = after - before;
+    }
+
+    free_matrix(m1);
+    free_matrix(m2);
+}
+
+/**
+ * NAME: bench_kernel
+ * INPUT: bool mult, int samples, double* times, PERF_PHASE* phase
+ * USAGE: times KERNEL_CALLS calls of mult_bignums (if mult) or
+ *          add_bignums per sample, measuring them as phase.
+ */
+static void bench_kernel(bool mult, int samples, double* times, PERF_PHASE* phase)
+{
+    BIGNUM a, b, res;
+    bignum_from_int(987654321, &a);
+    bignum_from_int(-123456789, &b);
+
+    for (int s = -1; s < samples; s++)
+    {
+        if (s >= 0)
+            perf_begin(phase);
+        double before = now();
+        for (int i = 0; i < KERNEL_CALLS; i++)
+        {
+            // mult_bignums accumulates into res, so it must start at zero.
+            bignum_from_int(0, &res);
+            if (mult)
+                mult_bignums(&a, &b, &res);
+            else
+                add_bignums(&a, &b, &res);
+        }
+        double after = now();
+        if (s >= 0)
+            perf_end(phase);
+        if (s >= 0)
+            times[s] = after - before;
+    }
+}
+
+/**
+ * NAME: bench_batch
+ * INPUT: bool batched, int n, int samples, double* times, PERF_PHASE* phase
+ * USAGE: times BATCH_COUNT products of n by n matrices per sample, with
+ *          one batch_mult call (if batched) or one regular_mult call
+ *          each, measuring them as phase.
+ */
+static void bench_batch(bool batched, int n, int samples, double* times,
+                        PERF_PHASE* phase)
+{
+    gen_set_seed(BENCH_SEED);
+    MATRIX* m1[BATCH_COUNT];
+    MATRIX* m2[BATCH_COUNT];
+    BATCH a, b, c;
+    batch_alloc(BATCH_COUNT, n, n, &a);
+    batch_alloc(BATCH_COUNT, n, n, &b);
+    batch_alloc(BATCH_COUNT, n, n, &c);
+    for (int e = 0; e < BATCH_COUNT; e++)
+    {
+        m1[e] = malloc(sizeof(MATRIX));
+        m2[e] = malloc(sizeof(MATRIX));
+        initialize_matrix(n, n, m1[e]);
+        initialize_matrix(n, n, m2[e]);
+        batch_load(&a, e, m1[e]);
+        batch_load(&b, e, m2[e]);
+    }
+
+    // One untimed warm-up run, then the samples.
+    for (int s = -1; s < samples; s++)
+    {
+        if (s >= 0)
+            perf_begin(phase);
+        double before = now();
+        if (batched)
+            batch_mult(&a, &b, &c);
+        else
+        {
+            for (int e = 0; e < BATCH_COUNT; e++)
+            {
+                MATRIX* m3 = malloc(sizeof(MATRIX));
+                regular_mult(m1[e], m2[e], m3);
+                free_matrix(m3);
+            }
+        }
+        double after = now();
+        if (s >= 0)
+            perf_end(phase);
+        if (s >= 0)
+            times[s] = after - before;
+    }
+
+    for (int e = 0; e < BATCH_COUNT; e++)
+    {
+        free_matrix(m1[e]);
+        free_matrix(m2[e]);
+    }
+    batch_free(&a);
+    batch_free(&b);
+    batch_free(&c);
+}
+
+/**
+ * NAME: init_phase
+ * INPUT: PERF_PHASE* phase, char* name, size_t len, BENCH_RESULT* r
+ * USAGE: sets up phase to measure the case r, named in the len bytes
+ *          at name.
+ */
+static void init_phase(PERF_PHASE* phase, char* name, size_t len, BENCH_RESULT* r)
+{
+    PERF_PHASE blank = PERF_PHASE_INIT(NULL);
+    *phase = blank;
+    snprintf(name, len, "%s %d", r->name, r->size);
+    phase->name = name;
+}
+
+/**
+ * NAME: print_counters
+ * INPUT: PERF_PHASE* phase
+ * USAGE: prints the cycles and instructions of one sample of phase and
+ *          their IPC, or n/a for counters that could not be read.
+ */
+static void print_counters(PERF_PHASE* phase)
+{
+    long long cycles = phase->counts[0];
+    long long instr = phase->counts[1];
+    long calls = (phase->calls > 0) ? phase->calls : 1;
+    if (cycles >= 0)
+        printf(" %14lld", cycles / calls);
+    else
+        printf(" %14s", "n/a");
+    if (instr >= 0)
+        printf(" %14lld", instr / calls);
+    else
+        printf(" %14s", "n/a");
+    if (cycles > 0 && instr >= 0)
+        printf(" %6.2f", (double) instr / cycles);
+    else
+        printf(" %6s", "n/a");
+}
+
+/* STATISTICS */
+
+/**
+ * NAME: beta_fraction
+ * INPUT: double a, double b, double x
+ * OUTPUT: double
+ * USAGE: continued fraction for the incomplete beta function
+ *          (modified Lentz's method).
+ */
+static double beta_fraction(double a, double b, double x)
+{
+    const double tiny = 1e-300;
+    double c = 1.0;
+    double d = 1.0 - (a + b) * x / (a + 1.0);
+    if (fabs(d) < tiny)
+        d = tiny;
+    d = 1.0 / d;
+    double h = d;
+
+    for (int m = 1; m <= 200; m++)
+    {
+        // even step
+        double num = m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m));
+        d = 1.0 + num * d;
+        c = 1.0 + num / c;
+        if (fabs(d) < tiny)
+            d = tiny;
+        if (fabs(c) < tiny)
+            c = tiny;
+        d = 1.0 / d;
+        h *= d * c;
+
+        // odd step
+        num = -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1));
+        d = 1.0 + num * d;
+        c = 1.0 + num / c;
+        if (fabs(d) < tiny)
+            d = tiny;
+        if (fabs(c) < tiny)
+            c = tiny;
+        d = 1.0 / d;
+        double delta = d * c;
+        h *= delta;
+        if (fabs(delta - 1.0) < 1e-12)
+            break;
+    }
+    return h;
+}
+
+/**
+ * NAME: incomplete_beta
+ * INPUT: double a, double b, double x
+ * OUTPUT: double
+ * USAGE: regularized incomplete beta function I_x(a, b).
+ */
+static double incomplete_beta(double a, double b, double x)
+{
+    if (x <= 0.0)
+        return 0.0;
+    if (x >= 1.0)
+        return 1.0;
+
+    double front = exp(lgamma(a + b) - lgamma(a) - lgamma(b) +
+                       a * log(x) + b * log(1.0 - x));
+    if (x < (a + 1.0) / (a + b + 2.0))
+        return front * beta_fraction(a, b, x) / a;
+    return 1.0 - front * beta_fraction(b, a, 1.0 - x) / b;
+}
+
+/**
+ * NAME: welch_p_slower
+ * INPUT: BENCH_RESULT* base, BENCH_RESULT* cur
+ * OUTPUT: double
+ * USAGE: one-sided p-value of Welch's t-test for cur being slower
+ *          than base.
+ */
+static double welch_p_slower(BENCH_RESULT* base, BENCH_RESULT* cur)
+{
+    double vb = base->stddev * base->stddev / base->samples;
+    double vc = cur->stddev * cur->stddev / cur->samples;
+    double diff = cur->mean - base->mean;
+
+    // No spread at all: the difference is exact.
+    if (vb + vc == 0.0)
+        return (diff > 0.0) ? 0.0 : 1.0;
+
+    double t = diff / sqrt(vb + vc);
+    double df = (vb + vc) * (vb + vc) /
+                ((base->samples > 1 ? vb * vb / (base->samples - 1) : 0.0) +
+                 (cur->samples > 1 ? vc * vc / (cur->samples - 1) : 0.0));
+
+    // Two-sided tail of Student's t, halved for the side we care about.
+    double tail = 0.5 * incomplete_beta(df / 2.0, 0.5, df / (df + t * t));
+    return (t > 0.0) ? tail : 1.0 - tail;
+}
+
+/* BASELINE FILES */
+
+/**
+ * NAME: save_baseline
+ * INPUT: const char* path, BENCH_RESULT* results, int count
+ * OUTPUT: bool
+ * USAGE: writes results to path, one case per line.
+ */
+static bool save_baseline(const char* path, BENCH_RESULT* results, int count)
+{
+    FILE* f = fopen(path, "w");
+    if (f == NULL)
+    {
+        printf("Error: cannot write baseline %s\n", path);
+        return false;
+    }
+
+    fprintf(f, "# type name size samples mean stddev\n");
+    for (int i = 0; i < count; i++)
+        fprintf(f, "%s %s %d %d %.9f %.9f\n", results[i].type, results[i].name,
+                results[i].size, results[i].samples, results[i].mean,
+                results[i].stddev);
+    fclose(f);
+    return true;
+}
+
+/**
+ * NAME: load_baseline
+ * INPUT: const char* path, BENCH_RESULT* results
+ * OUTPUT: int
+ * USAGE: reads a baseline file into results and returns the number of
+ *          cases, or -1 if it cannot be read.
+ */
+static int load_baseline(const char* path, BENCH_RESULT* results)
+{
+    FILE* f = fopen(path, "r");
+    if (f == NULL)
+    {
+        printf("Error: cannot read baseline %s\n", path);
+        return -1;
+    }
+
+    int count = 0;
+    char line[256];
+    while (count < MAX_CASES && fgets(line, sizeof(line), f) != NULL)
+    {
+        BENCH_RESULT* r = &results[count];
+        if (line[0] != '#' &&
+            sscanf(line, "%15s %31s %d %d %lf %lf", r->type, r->name, &r->size,
+                   &r->samples, &r->mean, &r->stddev) == 6)
+            count++;
+    }
+    fclose(f);
+    return count;
+}
+
+/**
+ * NAME: find_result
+ * INPUT: BENCH_RESULT* results, int count, BENCH_RESULT* key
+ * OUTPUT: BENCH_RESULT*
+ * USAGE: finds the case in results with the same type, name and size
+ *          as key, or NULL.
+ */
+static BENCH_RESULT* find_result(BENCH_RESULT* results, int count, BENCH_RESULT* key)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (strcmp(results[i].type, key->type) == 0 &&
+            strcmp(results[i].name, key->name) == 0 &&
+            results[i].size == key->size)
+            return &results[i];
+    }
+    return NULL;
+}
+
+int main(int argc, char* argv[])
+{
+    const char* savePath = NULL;
+    const char* comparePath = NULL;
+    int samples = 5;
+    double threshold = 5.0;
+    double alpha = 0.01;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+            savePath = argv[++i];
+        else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc)
+            comparePath = argv[++i];
+        else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc)
+            samples = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+            threshold = atof(argv[++i]);
+        else if (strcmp(argv[i], "--alpha") == 0 && i + 1 < argc)
+            alpha = atof(argv[++i]);
+        else
+        {
+            printf("Usage: %s [--save FILE | --compare FILE] [--samples N] "
+                   "[--threshold PERCENT] [--alpha P]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (samples < 2)
+        samples = 2;
+    perf_init();
+
+    BENCH_RESULT results[MAX_CASES];
+    PERF_PHASE phases[MAX_CASES];
+    char phaseNames[MAX_CASES][48];
+    int count = 0;
+    double* times = malloc(samples * sizeof(double));
+
+    // Kernel cases.
+    for (int k = 0; k < 2; k++)
+    {
+        BENCH_RESULT* r = &results[count++];
+        snprintf(r->type, sizeof(r->type), "%s", bignum_type_name());
+        snprintf(r->name, sizeof(r->name), "%s", k ? "mult_bignums" : "add_bignums");
+        r->size = KERNEL_CALLS;
+        init_phase(&phases[count - 1], phaseNames[count - 1], sizeof(phaseNames[0]), r);
+        bench_kernel(k == 1, samples, times, &phases[count - 1]);
+        summarize(times, samples, r);
+    }
+
+    // Algorithm x size cases.
+    for (int a = 0; a < NUM_ALGORITHMS; a++)
+    {
+        for (int s = 0; s < NUM_SIZES; s++)
+        {
+            BENCH_RESULT* r = &results[count++];
+            snprintf(r->type, sizeof(r->type), "%s", bignum_type_name());
+            snprintf(r->name, sizeof(r->name), "%s", algorithms[a].name);
+            r->size = sizes[s];
+            init_phase(&phases[count - 1], phaseNames[count - 1], sizeof(phaseNames[0]), r);
+            bench_algorithm(algorithms[a].fn, sizes[s], samples, times, &phases[count - 1]);
+            summarize(times, samples, r);
+        }
+    }
+
+    // Batch cases: a loop of single products, then one batched call.
+    for (int k = 0; k < 2; k++)
+    {
+        for (int s = 0; s < NUM_BATCH_SIZES; s++)
+        {
+            BENCH_RESULT* r = &results[count++];
+            snprintf(r->type, sizeof(r->type), "%s", bignum_type_name());
+            snprintf(r->name, sizeof(r->name), "%s", k ? "batch" : "regular_loop");
+            r->size = batchSizes[s];
+            init_phase(&phases[count - 1], phaseNames[count - 1], sizeof(phaseNames[0]), r);
+            bench_batch(k == 1, batchSizes[s], samples, times, &phases[count - 1]);
+            summarize(times, samples, r);
+        }
+    }
+    free(times);
+
+    BENCH_RESULT baseline[MAX_CASES];
+    int baseCount = 0;
+    if (comparePath != NULL)
+    {
+        baseCount = load_baseline(comparePath, baseline);
+        if (baseCount < 0)
+            return 2;
+    }
+
+    // Report, comparing against the baseline when there is one.
+    int regressions = 0;
+    printf("%-8s %-14s %6s %12s %12s", "Type", "Case", "Size", "Mean (s)", "Stddev");
+    if (perf_counting())
+        printf(" %14s %14s %6s", "cycles", "instr", "IPC");
+    if (comparePath != NULL)
+        printf(" %12s %9s %9s  %s", "Baseline", "Change", "p-value", "Verdict");
+    printf("\n");
+
+    for (int i = 0; i < count; i++)
+    {
+        BENCH_RESULT* r = &results[i];
+        printf("%-8s %-14s %6d %12.6f %12.6f", r->type, r->name, r->size,
+               r->mean, r->stddev);
+        if (perf_counting())
+            print_counters(&phases[i]);
+
+        BENCH_RESULT* base = (comparePath != NULL) ?
+                             find_result(baseline, baseCount, r) : NULL;
+        if (base != NULL)
+        {
+            double change = 100.0 * (r->mean - base->mean) / base->mean;
+            double p = welch_p_slower(base, r);
+            const char* verdict = "ok";
+            if (change > threshold && p < alpha)
+            {
+                verdict = "REGRESSION";
+                regressions++;
+            }
+            else if (change < -threshold && 1.0 - p < alpha)
+                verdict = "improved";
+            printf(" %12.6f %+8.1f%% %9.4f  %s", base->mean, change, p, verdict);
+        }
+        else if (comparePath != NULL)
+            printf(" %12s %9s %9s  %s", "-", "-", "-", "new");
+        printf("\n");
+    }
+
+    perf_report();
+
+    if (savePath != NULL && !save_baseline(savePath, results, count))
+        return 2;
+
+    if (regressions > 0)
+    {
+        printf("\n%d regression(s) beyond %.1f%% (alpha %.3f)\n", regressions,
+               threshold, alpha);
+        return 1;
+    }
+    return 0;
+}
@@ -245,6 +245,153 @@ void negate_bignums(BIGNUM* b)
     b->neg = !( b->neg );
 }
 
+/**
+ * NAME: bignum_mod
+ * INPUT: BIGNUM b, long long p
+ * OUTPUT: long long
+ * USAGE: returns b mod p in the range [0, p).
+ *
+ * NOTES: p must be below 2^31 so products of residues fit in 64 bits.
+ */
+long long bignum_mod(BIGNUM* b, long long p)
+{
+    // Horner's rule from the most significant digit down.
+    long long r = 0;
+    for (int i = b->lastIndex; i >= 0; i--)
+        r = (r * BASE + b->coeffs[i]) % p;
+    
+    if (b->neg && r != 0)
+        r = p - r;
+    return r;
+}
+
+/**
+ * NAME: bignum_is_zero
+ * INPUT: BIGNUM b
+ * OUTPUT: bool
+ * USAGE: whether b is zero.
+ *
+ * NOTES: results are not always trimmed, so every digit up to
+ * lastIndex is checked, from the top, where a nonzero one usually is.
+ */
+bool bignum_is_zero(BIGNUM* b)
+{
+    for (int i = b->lastIndex; i >= 0; i--)
+    {
+        if (b->coeffs[i] != 0)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * NAME: bignum_compare
+ * INPUT: BIGNUM b1, BIGNUM b2
+ * OUTPUT: int
+ * USAGE: negative, zero or positive as b1 is below, equal to or above b2.
+ *
+ * NOTES: compares through b1 - b2, so untrimmed digits and a negative
+ * zero cannot mislead it.
+ */
+int bignum_compare(BIGNUM* b1, BIGNUM* b2)
+{
+    BIGNUM negated = *b2;
+    BIGNUM diff;
+    negate_bignums(&negated);
+    add_bignums(b1, &negated, &diff);
+    if (bignum_is_zero(&diff))
+        return 0;
+    return diff.neg ? -1 : 1;
+}
+
+/**
+ * NAME: bignum_to_double
+ * INPUT: BIGNUM b
+ * OUTPUT: double
+ * USAGE: b rounded to a double, e.g. to estimate magnitudes.
+ */
+double bignum_to_double(BIGNUM* b)
+{
+    double value = 0.0;
+    for (int i = b->lastIndex; i >= 0; i--)
+        value = value * BASE + b->coeffs[i];
+    return b->neg ? -value : value;
+}
+
+/**
+ * NAME: bignum_type_name
+ * OUTPUT: const char*
+ * USAGE: names this bignum implementation, e.g. for benchmark results.
+ */
+const char* bignum_type_name(void)
+{
+    return "bignum";
+}
+
+/**
+ * NAME: bignum_to_string
+ * INPUT: BIGNUM b, char* buf, int size
+ * OUTPUT: int
+ * USAGE: writes b in decimal (with a leading '-' if negative) to buf
+ *          and returns its length, or -1 if size bytes are not enough.
+ *
+ * NOTES: the result is not NUL-terminated.
+ */
+int bignum_to_string(BIGNUM* b, char* buf, int size)
+{
+    int len = 0;
+    if (size < b->lastIndex + 1 + b->neg)
+        return -1;
+    
+    if (b->neg)
+        buf[len++] = '-';
+    for (int i = b->lastIndex; i >= 0; i--)
+        buf[len++] = '0' + b->coeffs[i];
+    return len;
+}
+
+/**
+ * NAME: bignum_from_string
+ * INPUT: const char* s, int len, BIGNUM b
+ * OUTPUT: bool
+ * USAGE: parses the len characters at s as a decimal integer with an
+ *          optional sign into b. Returns false if they are not one or
+ *          the value does not fit.
+ */
+bool bignum_from_string(const char* s, int len, BIGNUM* b)
+{
+    bool neg = false;
+    if (len > 0 && (s[0] == '-' || s[0] == '+'))
+    {
+        neg = (s[0] == '-');
+        s++;
+        len--;
+    }
+    
+    // skip leading zeros
+    while (len > 1 && s[0] == '0')
+    {
+        s++;
+        len--;
+    }
+    if (len == 0 || len > BIGNUM_MAX_DIGITS)
+        return false;
+    
+    bignum_from_int(0, b);
+    for (int i = 0; i < len; i++)
+    {
+        char c = s[len - 1 - i];
+        if (c < '0' || c > '9')
+            return false;
+        b->coeffs[i] = c - '0';
+    }
+    b->lastIndex = len - 1;
+    
+    // zero is never negative
+    b->neg = neg && !(len == 1 && b->coeffs[0] == 0);
+    return true;
+}
+
  /**
  * NAME: print_bignum
  * INPUT: BIGNUM b
@@ -254,10 +401,7 @@ void negate_bignums(BIGNUM* b)
  */
 void print_bignum(BIGNUM* b)
 {
-    if (b->neg)
-        printf("-");
-    for (int i= (b->lastIndex); i >= 0; i--)
-    {
-        printf("%i", b->coeffs[i]);
-    }
+    // One write instead of a printf per digit.
+    char buf[LIMIT + 1];
+    fwrite(buf, 1, bignum_to_string(b, buf, sizeof(buf)), stdout);
 }
@@ -6,6 +6,21 @@
  *
  * Fundamental Data structures for project
  ***************************************************************************/
+
+// The other bignum types are chosen at compile time: every file of the
+// int64 programs is built with INT_BIGNUMS defined, every file of the
+// GF(p) programs with MODP_BIGNUMS and so on, so all of their code sees
+// their BIGNUM.
+#if defined(INT_BIGNUMS)
+#include "int_bignums/bignum.h"
+#elif defined(MODP_BIGNUMS)
+#include "modp_bignums/bignum.h"
+#elif defined(INT128_BIGNUMS)
+#include "int128_bignums/bignum.h"
+#elif defined(DOUBLE_BIGNUMS) || defined(FLOAT_BIGNUMS)
+#include "fp_bignums/bignum.h"
+#else
+
 #ifndef _BIGNUM_H
 #define _BIGNUM_H 
 #define LIMIT 100
@@ -31,6 +46,13 @@ typedef struct
 }
 BIGNUM;
 
+// Code that works on the decimal digits themselves (see planes.h) is
+// built only when this is defined, for these bignums and no others.
+#define BIGNUM_DIGITS
+
+// most digits a value may have; add_bignums needs one more for its carry
+#define BIGNUM_MAX_DIGITS (LIMIT - 1)
+
  /**
  * NAME: print_bignum
  * INPUT: BIGNUM b
@@ -78,5 +100,68 @@ void bignum_from_int(int i, BIGNUM* b);
  */
 void negate_bignums(BIGNUM* b);
 
+/**
+ * NAME: bignum_mod
+ * INPUT: BIGNUM b, long long p
+ * OUTPUT: long long
+ * USAGE: returns b mod p in the range [0, p).
+ *
+ * NOTES: p must be below 2^31 so products of residues fit in 64 bits.
+ */
+long long bignum_mod(BIGNUM* b, long long p);
+
+/**
+ * NAME: bignum_is_zero
+ * INPUT: BIGNUM b
+ * OUTPUT: bool
+ * USAGE: whether b is zero.
+ */
+bool bignum_is_zero(BIGNUM* b);
+
+/**
+ * NAME: bignum_compare
+ * INPUT: BIGNUM b1, BIGNUM b2
+ * OUTPUT: int
+ * USAGE: negative, zero or positive as b1 is below, equal to or above b2.
+ */
+int bignum_compare(BIGNUM* b1, BIGNUM* b2);
+
+/**
+ * NAME: bignum_to_double
+ * INPUT: BIGNUM b
+ * OUTPUT: double
+ * USAGE: b rounded to a double, e.g. to estimate magnitudes.
+ */
+double bignum_to_double(BIGNUM* b);
+
+/**
+ * NAME: bignum_type_name
+ * OUTPUT: const char*
+ * USAGE: names this bignum implementation, e.g. for benchmark results.
+ */
+const char* bignum_type_name(void);
+
+/**
+ * NAME: bignum_to_string
+ * INPUT: BIGNUM b, char* buf, int size
+ * OUTPUT: int
+ * USAGE: writes b in decimal (with a leading '-' if negative) to buf
+ *          and returns its length, or -1 if size bytes are not enough.
+ *
+ * NOTES: the result is not NUL-terminated.
+ */
+int bignum_to_string(BIGNUM* b, char* buf, int size);
+
+/**
+ * NAME: bignum_from_string
+ * INPUT: const char* s, int len, BIGNUM b
+ * OUTPUT: bool
+ * USAGE: parses the len characters at s as a decimal integer with an
+ *          optional sign into b. Returns false if they are not one or
+ *          the value does not fit.
+ */
+bool bignum_from_string(const char* s, int len, BIGNUM* b);
+
 #endif
 
+#endif
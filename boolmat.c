@@ -0,0 +1,327 @@
+/*************************************************************************
+ * boolmat.c
+ *
+ * Implements bit-packed boolean matrices (see boolmat.h).
+ *
+ * boolmat_mult is the Method of Four Russians. The rows of b are taken
+ * GROUP_BITS at a time; for each group a table holds the OR (or XOR)
+ * of every subset of those rows, built one row per entry from a
+ * smaller subset. Row i of the product then takes, for each group, the
+ * table entry picked by the GROUP_BITS bits of row i of a at those
+ * columns, so each group costs one row operation per row of a instead
+ * of GROUP_BITS. Rows of a are split over threads with parallel_for;
+ * each thread builds its own tables.
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "boolmat.h"
+#include "memtrack.h"
+#include "parallel.h"
+
+// rows of b combined by one Four Russians table
+#define GROUP_BITS 8
+#define GROUP_SIZE (1 << GROUP_BITS)
+
+/**
+ * NAME: row_bits
+ * INPUT: BOOLMAT* b, int i
+ * OUTPUT: unsigned long long*
+ * USAGE: the words of row i of b.
+ */
+static unsigned long long* row_bits(BOOLMAT* b, int i)
+{
+    return b->bits + (size_t) i * b->words;
+}
+
+/**
+ * NAME: boolmat_alloc
+ * INPUT: int rowSize, int colSize, BOOLMAT* b
+ * USAGE: allocates b as a rowSize by colSize matrix of zeros.
+ *
+ * NOTES: the storage is counted by memtrack.
+ */
+void boolmat_alloc(int rowSize, int colSize, BOOLMAT* b)
+{
+    b->words = (colSize + BOOL_WORD_BITS - 1) / BOOL_WORD_BITS;
+    b->numRows = rowSize;
+    b->numCols = colSize;
+    b->bits = calloc((size_t) rowSize * b->words, sizeof(unsigned long long));
+    memtrack_alloc((size_t) rowSize * b->words * sizeof(unsigned long long));
+}
+
+/**
+ * NAME: boolmat_get
+ * INPUT: BOOLMAT* b, int i, int j
+ * OUTPUT: bool
+ * USAGE: entry (i, j) of b.
+ */
+bool boolmat_get(BOOLMAT* b, int i, int j)
+{
+    return (row_bits(b, i)[j / BOOL_WORD_BITS] >> (j % BOOL_WORD_BITS)) & 1;
+}
+
+/**
+ * NAME: boolmat_set
+ * INPUT: BOOLMAT* b, int i, int j, bool value
+ * USAGE: sets entry (i, j) of b.
+ */
+void boolmat_set(BOOLMAT* b, int i, int j, bool value)
+{
+    unsigned long long mask = 1ULL << (j % BOOL_WORD_BITS);
+    if (value)
+        row_bits(b, i)[j / BOOL_WORD_BITS] |= mask;
+    else
+        row_bits(b, i)[j / BOOL_WORD_BITS] &= ~mask;
+}
+
+/**
+ * NAME: boolmat_from_matrix
+ * INPUT: MATRIX* m, BOOLMAT* b
+ * USAGE: allocates b with a 1 wherever m is nonzero.
+ */
+void boolmat_from_matrix(MATRIX* m, BOOLMAT* b)
+{
+    boolmat_alloc(m->numRows, m->numCols, b);
+    for (int i = 0; i < m->numRows; i++)
+    {
+        for (int j = 0; j < m->numCols; j++)
+        {
+            if (!bignum_is_zero(&m->matrix[i][j]))
+                boolmat_set(b, i, j, true);
+        }
+    }
+}
+
+/**
+ * NAME: boolmat_to_matrix
+ * INPUT: BOOLMAT* b, MATRIX* m
+ * USAGE: initializes m to b, with entries 0 and 1.
+ *
+ * NOTES: assumes m is malloced.
+ */
+void boolmat_to_matrix(BOOLMAT* b, MATRIX* m)
+{
+    alloc_matrix(b->numRows, b->numCols, m);
+    for (int i = 0; i < b->numRows; i++)
+    {
+        for (int j = 0; j < b->numCols; j++)
+            bignum_from_int(boolmat_get(b, i, j), &m->matrix[i][j]);
+    }
+}
+
+// Arguments of the parallel products.
+typedef struct
+{
+    BOOLMAT* a;
+    BOOLMAT* b;
+    BOOLMAT* res;
+    BOOL_RING ring;
+    MATRIX* counts;
+}
+BOOL_ARGS;
+
+/**
+ * NAME: combine_row
+ * INPUT: unsigned long long* dst, unsigned long long* src, int words,
+ *          BOOL_RING ring
+ * USAGE: dst |= src, or dst ^= src over GF(2).
+ */
+static void combine_row(unsigned long long* dst, unsigned long long* src, int words,
+                        BOOL_RING ring)
+{
+    if (ring == BOOL_GF2)
+    {
+        for (int w = 0; w < words; w++)
+            dst[w] ^= src[w];
+    }
+    else
+    {
+        for (int w = 0; w < words; w++)
+            dst[w] |= src[w];
+    }
+}
+
+/**
+ * NAME: four_russians_rows
+ * INPUT: int begin, int end, void* arg
+ * USAGE: parallel_for body computing rows [begin, end) of the product
+ *          with the Method of Four Russians.
+ */
+static void four_russians_rows(int begin, int end, void* arg)
+{
+    BOOL_ARGS* args = arg;
+    BOOLMAT* a = args->a;
+    BOOLMAT* b = args->b;
+    int words = b->words;
+    unsigned long long* table = malloc((size_t) GROUP_SIZE * words * sizeof(unsigned long long));
+
+    for (int first = 0; first < b->numRows; first += GROUP_BITS)
+    {
+        // table[x] combines the rows first + t of b for the bits t of
+        // x: x without its lowest bit, plus the row of that bit.
+        memset(table, 0, words * sizeof(unsigned long long));
+        for (int x = 1; x < GROUP_SIZE; x++)
+        {
+            int t = __builtin_ctz(x);
+            unsigned long long* entry = table + (size_t) x * words;
+            memcpy(entry, table + (size_t) (x & (x - 1)) * words,
+                   words * sizeof(unsigned long long));
+            if (first + t < b->numRows)
+                combine_row(entry, row_bits(b, first + t), words, args->ring);
+        }
+
+        // GROUP_BITS divides the word size, so a group never straddles
+        // two words of a.
+        int word = first / BOOL_WORD_BITS;
+        int shift = first % BOOL_WORD_BITS;
+        for (int i = begin; i < end; i++)
+        {
+            int x = (row_bits(a, i)[word] >> shift) & (GROUP_SIZE - 1);
+            if (x != 0)
+                combine_row(row_bits(args->res, i), table + (size_t) x * words, words,
+                            args->ring);
+        }
+    }
+    free(table);
+}
+
+/**
+ * NAME: boolmat_mult
+ * INPUT: BOOLMAT* a, BOOLMAT* b, BOOLMAT* res, BOOL_RING ring
+ * OUTPUT: bool
+ * USAGE: allocates res as a * b, summing with OR or over GF(2).
+ *          Returns false if they cannot be multiplied.
+ */
+bool boolmat_mult(BOOLMAT* a, BOOLMAT* b, BOOLMAT* res, BOOL_RING ring)
+{
+    if (a->numCols != b->numRows)
+    {
+        printf("Error: Matrices cannot be multiplied");
+        return false;
+    }
+
+    boolmat_alloc(a->numRows, b->numCols, res);
+    BOOL_ARGS args = {a, b, res, ring, NULL};
+    parallel_for(a->numRows, four_russians_rows, &args);
+    return true;
+}
+
+/**
+ * NAME: count_rows
+ * INPUT: int begin, int end, void* arg
+ * USAGE: parallel_for body computing rows [begin, end) of the counts:
+ *          each is the popcount of a row of a ANDed with a row of the
+ *          transpose of b.
+ */
+static void count_rows(int begin, int end, void* arg)
+{
+    BOOL_ARGS* args = arg;
+    BOOLMAT* a = args->a;
+    BOOLMAT* bt = args->b;
+    for (int i = begin; i < end; i++)
+    {
+        unsigned long long* x = row_bits(a, i);
+        for (int j = 0; j < bt->numRows; j++)
+        {
+            unsigned long long* y = row_bits(bt, j);
+            int count = 0;
+            for (int w = 0; w < a->words; w++)
+                count += __builtin_popcountll(x[w] & y[w]);
+            bignum_from_int(count, &args->counts->matrix[i][j]);
+        }
+    }
+}
+
+/**
+ * NAME: boolmat_count
+ * INPUT: BOOLMAT* a, BOOLMAT* b, MATRIX* res
+ * OUTPUT: bool
+ * USAGE: initializes res to the integer product of a and b: entry
+ *          (i, j) counts the k with a(i, k) and b(k, j), e.g. the paths
+ *          of length 2 from i to j. Returns false if they cannot be
+ *          multiplied.
+ *
+ * NOTES: assumes res is malloced.
+ */
+bool boolmat_count(BOOLMAT* a, BOOLMAT* b, MATRIX* res)
+{
+    if (a->numCols != b->numRows)
+    {
+        printf("Error: Matrices cannot be multiplied");
+        return false;
+    }
+
+    // Transpose b so both operands of each count are rows.
+    BOOLMAT bt;
+    boolmat_alloc(b->numCols, b->numRows, &bt);
+    for (int k = 0; k < b->numRows; k++)
+    {
+        for (int j = 0; j < b->numCols; j++)
+        {
+            if (boolmat_get(b, k, j))
+                boolmat_set(&bt, j, k, true);
+        }
+    }
+
+    alloc_matrix(a->numRows, b->numCols, res);
+    BOOL_ARGS args = {a, &bt, NULL, BOOL_OR, res};
+    parallel_for(a->numRows, count_rows, &args);
+    boolmat_free(&bt);
+    return true;
+}
+
+/**
+ * NAME: boolmat_closure
+ * INPUT: BOOLMAT* a, BOOLMAT* res
+ * OUTPUT: bool
+ * USAGE: allocates res as the reflexive transitive closure of the
+ *          square matrix a: res(i, j) is 1 if j can be reached from i.
+ *          Returns false (and allocates nothing) if a is not square.
+ */
+bool boolmat_closure(BOOLMAT* a, BOOLMAT* res)
+{
+    if (a->numRows != a->numCols)
+    {
+        printf("Error: Only square matrices have a closure\n");
+        return false;
+    }
+
+    // Start from a | I and square until nothing changes; after s
+    // squarings every path of up to 2^s steps is covered.
+    size_t bytes = (size_t) a->numRows * a->words * sizeof(unsigned long long);
+    boolmat_alloc(a->numRows, a->numCols, res);
+    memcpy(res->bits, a->bits, bytes);
+    for (int i = 0; i < a->numRows; i++)
+        boolmat_set(res, i, i, true);
+
+    while (true)
+    {
+        BOOLMAT square;
+        if (!boolmat_mult(res, res, &square, BOOL_OR))
+        {
+            boolmat_free(res);
+            return false;
+        }
+        bool same = memcmp(square.bits, res->bits, bytes) == 0;
+        boolmat_free(res);
+        *res = square;
+        if (same)
+            break;
+    }
+    return true;
+}
+
+/**
+ * NAME: boolmat_free
+ * INPUT: BOOLMAT* b
+ * USAGE: frees the storage of b.
+ */
+void boolmat_free(BOOLMAT* b)
+{
+    memtrack_release((size_t) b->numRows * b->words * sizeof(unsigned long long));
+    free(b->bits);
+    b->bits = NULL;
+}
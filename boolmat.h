@@ -0,0 +1,121 @@
+/****************************************************************************
+ * boolmat.h
+ *
+ * Computer Science 51
+ * Boolean Matrices
+ *
+ * Bit-packed 0/1 matrices for reachability and transitive closure,
+ * where only OR-of-AND is needed. Each row is packed 64 entries to a
+ * word (entry j of a row is bit j % 64 of word j / 64), so a matrix
+ * takes 1 bit per entry instead of a whole BIGNUM or long long.
+ * Products use the Method of Four Russians, and path counts use
+ * word-level AND and popcount.
+ ***************************************************************************/
+#ifndef _BOOLMAT_H
+#define _BOOLMAT_H
+
+#include <stdbool.h>
+
+#include "matrix.h"
+
+// entries packed into each word
+#define BOOL_WORD_BITS 64
+
+// A bit-packed boolean matrix. Bits past numCols in a row are zero.
+typedef struct
+{
+    unsigned long long* bits;
+    int words;
+    int numRows;
+    int numCols;
+}
+BOOLMAT;
+
+// what the sum of a product means
+typedef enum
+{
+    BOOL_OR,        // OR of ANDs: is there a path
+    BOOL_GF2        // XOR of ANDs: arithmetic over GF(2)
+}
+BOOL_RING;
+
+/**
+ * NAME: boolmat_alloc
+ * INPUT: int rowSize, int colSize, BOOLMAT* b
+ * USAGE: allocates b as a rowSize by colSize matrix of zeros.
+ *
+ * NOTES: the storage is counted by memtrack.
+ */
+void boolmat_alloc(int rowSize, int colSize, BOOLMAT* b);
+
+/**
+ * NAME: boolmat_get
+ * INPUT: BOOLMAT* b, int i, int j
+ * OUTPUT: bool
+ * USAGE: entry (i, j) of b.
+ */
+bool boolmat_get(BOOLMAT* b, int i, int j);
+
+/**
+ * NAME: boolmat_set
+ * INPUT: BOOLMAT* b, int i, int j, bool value
+ * USAGE: sets entry (i, j) of b.
+ */
+void boolmat_set(BOOLMAT* b, int i, int j, bool value);
+
+/**
+ * NAME: boolmat_from_matrix
+ * INPUT: MATRIX* m, BOOLMAT* b
+ * USAGE: allocates b with a 1 wherever m is nonzero.
+ */
+void boolmat_from_matrix(MATRIX* m, BOOLMAT* b);
+
+/**
+ * NAME: boolmat_to_matrix
+ * INPUT: BOOLMAT* b, MATRIX* m
+ * USAGE: initializes m to b, with entries 0 and 1.
+ *
+ * NOTES: assumes m is malloced.
+ */
+void boolmat_to_matrix(BOOLMAT* b, MATRIX* m);
+
+/**
+ * NAME: boolmat_mult
+ * INPUT: BOOLMAT* a, BOOLMAT* b, BOOLMAT* res, BOOL_RING ring
+ * OUTPUT: bool
+ * USAGE: allocates res as a * b, summing with OR or over GF(2).
+ *          Returns false if they cannot be multiplied.
+ */
+bool boolmat_mult(BOOLMAT* a, BOOLMAT* b, BOOLMAT* res, BOOL_RING ring);
+
+/**
+ * NAME: boolmat_count
+ * INPUT: BOOLMAT* a, BOOLMAT* b, MATRIX* res
+ * OUTPUT: bool
+ * USAGE: initializes res to the integer product of a and b: entry
+ *          (i, j) counts the k with a(i, k) and b(k, j), e.g. the paths
+ *          of length 2 from i to j. Returns false if they cannot be
+ *          multiplied.
+ *
+ * NOTES: assumes res is malloced.
+ */
+bool boolmat_count(BOOLMAT* a, BOOLMAT* b, MATRIX* res);
+
+/**
+ * NAME: boolmat_closure
+ * INPUT: BOOLMAT* a, BOOLMAT* res
+ * OUTPUT: bool
+ * USAGE: allocates res as the reflexive transitive closure of the
+ *          square matrix a: res(i, j) is 1 if j can be reached from i.
+ *          Returns false (and allocates nothing) if a is not square.
+ */
+bool boolmat_closure(BOOLMAT* a, BOOLMAT* res);
+
+/**
+ * NAME: boolmat_free
+ * INPUT: BOOLMAT* b
+ * USAGE: frees the storage of b.
+ */
+void boolmat_free(BOOLMAT* b);
+
+#endif
@@ -0,0 +1,191 @@
+/*************************************************************************
+ * bounds.c
+ *
+ * Implements exact type selection (see bounds.h). The bounds are worst
+ * cases over all entries of the given magnitudes, so they hold for any
+ * signs; the fast algorithms pay for their operand sums with a factor
+ * of 2 per level (Strassen, and rect_mult, which runs the same scheme).
+ ************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bounds.h"
+#include "mult.h"
+#include "parallel.h"
+
+// Relative slack added to a bound before it is compared with a type's
+// limit, covering the rounding of the entries and of the bound itself.
+#define BOUND_SLACK 1e-9
+
+// Exact types, narrowest first. The int64 and int128 limits are the
+// largest doubles below 2^63 and 2^127; the bignums hold 100 digits,
+// and one is kept to spare. The narrow products take int8 or int16
+// entries and accumulate in int32 or int64 (see narrow.h), so int64
+// holds their results.
+static const EXACT_TYPE exactTypes[] =
+{
+    {"int64", "intmatutil", 9223372036854774784.0, "int8", 127},
+    {"int64", "intmatutil", 9223372036854774784.0, "int16", 32767},
+    {"int64", "intmatutil", 9223372036854774784.0, NULL, 0},
+    {"int128", "int128matutil", 170141183460469212842221372237303250944.0, NULL, 0},
+    {"bignum", "matutil", 1e99, NULL, 0},
+};
+#define NUM_EXACT_TYPES (int) (sizeof(exactTypes) / sizeof(exactTypes[0]))
+
+// Arguments of the parallel scan.
+typedef struct
+{
+    MATRIX* m;
+    double* rowMax;
+}
+SCAN_ARGS;
+
+/**
+ * NAME: scan_rows
+ * INPUT: int begin, int end, void* arg
+ * USAGE: parallel_for body finding the largest magnitude in each of
+ *          rows [begin, end).
+ */
+static void scan_rows(int begin, int end, void* arg)
+{
+    SCAN_ARGS* args = arg;
+    for (int i = begin; i < end; i++)
+    {
+        double largest = 0.0;
+        for (int j = 0; j < args->m->numCols; j++)
+        {
+            double x = bignum_to_double(&args->m->matrix[i][j]);
+            if (x < 0)
+                x = -x;
+            if (x > largest)
+                largest = x;
+        }
+        args->rowMax[i] = largest;
+    }
+}
+
+/**
+ * NAME: matrix_max_abs
+ * INPUT: MATRIX* m
+ * OUTPUT: double
+ * USAGE: the largest magnitude of an entry of m, rounded to a double.
+ */
+double matrix_max_abs(MATRIX* m)
+{
+    double* rowMax = malloc(m->numRows * sizeof(double));
+    SCAN_ARGS args = {m, rowMax};
+    parallel_for(m->numRows, scan_rows, &args);
+
+    double largest = 0.0;
+    for (int i = 0; i < m->numRows; i++)
+        if (rowMax[i] > largest)
+            largest = rowMax[i];
+    free(rowMax);
+    return largest;
+}
+
+/**
+ * NAME: strassen_bound
+ * INPUT: int size, double maxA, double maxB
+ * OUTPUT: double
+ * USAGE: the bound for Strassen's algorithm on size by size matrices,
+ *          padded to a power of 2 and recursed on down to single cells.
+ *
+ * NOTES: at a level on n by n blocks the operand sums double the
+ *          entries, each of the 7 products is at most (n / 2) times the
+ *          doubled entries, and a quadrant of C gathers up to 4 of them.
+ *          Stopping the recursion earlier only lowers the bound.
+ */
+static double strassen_bound(int size, double maxA, double maxB)
+{
+    int n = 1;
+    while (n < size)
+        n *= 2;
+
+    double bound = 0.0;
+    for (; n > 1; n /= 2)
+    {
+        maxA *= 2;
+        maxB *= 2;
+        double level = 4.0 * (n / 2) * maxA * maxB;
+        if (level > bound)
+            bound = level;
+    }
+    if (maxA * maxB > bound)
+        bound = maxA * maxB;
+    if (maxA > bound)
+        bound = maxA;
+    return (maxB > bound) ? maxB : bound;
+}
+
+/**
+ * NAME: mult_bound
+ * INPUT: const char* alg, int rowSize, int innerSize, int colSize,
+ *          double maxA, double maxB, double* bound
+ * OUTPUT: bool
+ * USAGE: sets *bound to a bound on the magnitude of every value the
+ *          algorithm called alg (as matutil names them) forms on a
+ *          rowSize by innerSize matrix with entries at most maxA times
+ *          an innerSize by colSize one with entries at most maxB.
+ *          Returns false if alg is unknown.
+ */
+bool mult_bound(const char* alg, int rowSize, int innerSize, int colSize,
+                double maxA, double maxB, double* bound)
+{
+    if (strcmp(alg, "regular") == 0 || strcmp(alg, "recursive") == 0 ||
+        strcmp(alg, "sparse") == 0)
+    {
+        // Every partial sum is at most innerSize products.
+        *bound = innerSize * maxA * maxB;
+    }
+    else if (strcmp(alg, "winograd") == 0)
+    {
+        // Each entry starts at minus its row and column factors and
+        // gains innerSize / 2 products of sums, and the odd column.
+        double pairs = innerSize / 2;
+        *bound = pairs * (maxA * maxA + maxB * maxB) +
+                 pairs * (maxA + maxB) * (maxA + maxB) + maxA * maxB;
+    }
+    else if (strcmp(alg, "strassen") == 0 || strcmp(alg, "morton") == 0 ||
+             strcmp(alg, "planes") == 0)
+    {
+        int size = rowSize;
+        if (innerSize > size)
+            size = innerSize;
+        if (colSize > size)
+            size = colSize;
+        *bound = strassen_bound(size, maxA, maxB);
+    }
+    else if (strcmp(alg, "rect") == 0)
+        *bound = rect_bound(rowSize, innerSize, colSize, maxA, maxB);
+    else
+        return false;
+    return true;
+}
+
+/**
+ * NAME: exact_type_for
+ * INPUT: const char* alg, double bound, double maxEntry
+ * OUTPUT: const EXACT_TYPE*
+ * USAGE: the narrowest exact type holding every value up to bound, or
+ *          NULL if none does; for the classical algorithms, a narrow
+ *          product if every entry fits.
+ *
+ * NOTES: narrow_mult is the classical product, so it stands in for
+ *          "regular" and "recursive" only. "sparse" is left alone, as
+ *          its operands are sparse so that it skips the zeros.
+ */
+const EXACT_TYPE* exact_type_for(const char* alg, double bound, double maxEntry)
+{
+    bool classical = (strcmp(alg, "regular") == 0 || strcmp(alg, "recursive") == 0);
+    for (int t = 0; t < NUM_EXACT_TYPES; t++)
+    {
+        if (exactTypes[t].narrow != NULL &&
+            (!classical || maxEntry > exactTypes[t].entryLimit))
+            continue;
+        if (bound * (1 + BOUND_SLACK) <= exactTypes[t].limit)
+            return &exactTypes[t];
+    }
+    return NULL;
+}
@@ -0,0 +1,65 @@
+/****************************************************************************
+ * bounds.h
+ *
+ * Computer Science 51
+ * Exact Type Selection
+ *
+ * Bounds every value a product forms, the intermediate sums of the fast
+ * algorithms included, from the largest entries of its factors and its
+ * shape, and picks the narrowest exact element type that holds them
+ * all. The analysis reads each factor once, so it costs about as much
+ * as loading them.
+ ***************************************************************************/
+#ifndef _BOUNDS_H
+#define _BOUNDS_H
+
+#include <stdbool.h>
+
+#include "matrix.h"
+
+// An exact element type and the matutil program built with it. A type
+// with a narrow entry type multiplies with "narrow" rather than "mult".
+typedef struct
+{
+    const char* name;       // its bignum_type_name
+    const char* program;
+    double limit;           // values up to this are held exactly
+    const char* narrow;     // narrow.h entry type, or NULL
+    double entryLimit;      // largest entry magnitude it takes
+}
+EXACT_TYPE;
+
+/**
+ * NAME: matrix_max_abs
+ * INPUT: MATRIX* m
+ * OUTPUT: double
+ * USAGE: the largest magnitude of an entry of m, rounded to a double.
+ */
+double matrix_max_abs(MATRIX* m);
+
+/**
+ * NAME: mult_bound
+ * INPUT: const char* alg, int rowSize, int innerSize, int colSize,
+ *          double maxA, double maxB, double* bound
+ * OUTPUT: bool
+ * USAGE: sets *bound to a bound on the magnitude of every value the
+ *          algorithm called alg (as matutil names them) forms on a
+ *          rowSize by innerSize matrix with entries at most maxA times
+ *          an innerSize by colSize one with entries at most maxB.
+ *          Returns false if alg is unknown.
+ */
+bool mult_bound(const char* alg, int rowSize, int innerSize, int colSize,
+                double maxA, double maxB, double* bound);
+
+/**
+ * NAME: exact_type_for
+ * INPUT: const char* alg, double bound, double maxEntry
+ * OUTPUT: const EXACT_TYPE*
+ * USAGE: the narrowest exact type holding every value up to bound, or
+ *          NULL if none does. For the classical algorithms that is an
+ *          int8 or int16 narrow product when no entry of either factor
+ *          is above maxEntry in magnitude and those types can hold it.
+ */
+const EXACT_TYPE* exact_type_for(const char* alg, double bound, double maxEntry);
+
+#endif
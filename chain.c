@@ -0,0 +1,299 @@
+/*************************************************************************
+ * chain.c
+ *
+ * Implements matrix-chain multiplication (see chain.h). An algorithm's
+ * cost is a measured constant times its operation count on the shape:
+ * p * q * r for the classical algorithms, and n^log2(7) for Strassen's
+ * algorithm, with n the power of 2 it pads all three dimensions to, so
+ * padding a thin product out to a large square is priced in.
+ ************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "chain.h"
+#include "mult.h"
+
+// side of the square products timed by chain_calibrate
+#define CALIBRATE_SIZE 32
+
+// How an algorithm's operation count grows with the shape.
+typedef enum
+{
+    COST_CUBIC,         // p * q * r
+    COST_PADDED         // n^log2(7), n the padded power of 2
+}
+COST_KIND;
+
+// An algorithm the planner can choose, with its measured constant.
+typedef struct
+{
+    const char* name;
+    void (*fn)(MATRIX*, MATRIX*, MATRIX*);
+    COST_KIND kind;
+    double seconds;
+}
+CHAIN_ALG;
+
+static CHAIN_ALG algs[] =
+{
+    {"regular", regular_mult, COST_CUBIC, 0.0},
+    {"winograd", winograd_mult, COST_CUBIC, 0.0},
+    {"recursive", recursive_mult, COST_CUBIC, 0.0},
+    {"strassen", strassen_mult, COST_PADDED, 0.0},
+    {"morton", strassen_morton_mult, COST_PADDED, 0.0},
+};
+#define NUM_ALGS (int) (sizeof(algs) / sizeof(algs[0]))
+
+static bool calibrated = false;
+
+/**
+ * NAME: now
+ * OUTPUT: double
+ * USAGE: monotonic wall clock in seconds.
+ */
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * NAME: operations
+ * INPUT: COST_KIND kind, int p, int q, int r
+ * OUTPUT: double
+ * USAGE: operation count of a p by q times q by r product.
+ */
+static double operations(COST_KIND kind, int p, int q, int r)
+{
+    if (kind == COST_CUBIC)
+        return (double) p * q * r;
+
+    int n = 1;
+    while (n < p || n < q || n < r)
+        n *= 2;
+    return pow(n, log2(7.0));
+}
+
+/**
+ * NAME: chain_calibrate
+ * USAGE: times each algorithm once on a small product to set the cost
+ *          constants of the model. chain_plan does this the first time
+ *          if it has not been done.
+ */
+void chain_calibrate(void)
+{
+    MATRIX* m1 = malloc(sizeof(MATRIX));
+    MATRIX* m2 = malloc(sizeof(MATRIX));
+    initialize_matrix(CALIBRATE_SIZE, CALIBRATE_SIZE, m1);
+    initialize_matrix(CALIBRATE_SIZE, CALIBRATE_SIZE, m2);
+
+    for (int a = 0; a < NUM_ALGS; a++)
+    {
+        // Best of three, to keep a stray interruption out of the model.
+        double best = 0.0;
+        for (int run = 0; run < 3; run++)
+        {
+            MATRIX* res = malloc(sizeof(MATRIX));
+            double start = now();
+            algs[a].fn(m1, m2, res);
+            double elapsed = now() - start;
+            free_matrix(res);
+            if (run == 0 || elapsed < best)
+                best = elapsed;
+        }
+        algs[a].seconds = best / operations(algs[a].kind, CALIBRATE_SIZE,
+                                            CALIBRATE_SIZE, CALIBRATE_SIZE);
+    }
+
+    free_matrix(m1);
+    free_matrix(m2);
+    calibrated = true;
+}
+
+/**
+ * NAME: chain_plan
+ * INPUT: MATRIX** ms, int count, CHAIN_PLAN* plan
+ * OUTPUT: bool
+ * USAGE: plans the product ms[0] ms[1] ... ms[count - 1]. Returns false
+ *          (and makes no plan) if count is 0 or neighbouring shapes do
+ *          not match.
+ *
+ * NOTES: release plan with chain_free.
+ */
+bool chain_plan(MATRIX** ms, int count, CHAIN_PLAN* plan)
+{
+    if (count <= 0)
+    {
+        printf("Error: an empty chain has no product to plan\n");
+        return false;
+    }
+    for (int i = 0; i + 1 < count; i++)
+    {
+        if (ms[i]->numCols != ms[i + 1]->numRows)
+        {
+            printf("Error: matrices %d and %d cannot be multiplied\n", i + 1, i + 2);
+            return false;
+        }
+    }
+    if (!calibrated)
+        chain_calibrate();
+
+    // Matrix i is dims[i] by dims[i + 1].
+    plan->count = count;
+    plan->dims = malloc((count + 1) * sizeof(int));
+    for (int i = 0; i < count; i++)
+        plan->dims[i] = ms[i]->numRows;
+    plan->dims[count] = ms[count - 1]->numCols;
+    plan->split = calloc((size_t) count * count, sizeof(int));
+    plan->alg = calloc((size_t) count * count, sizeof(int));
+    double* cost = calloc((size_t) count * count, sizeof(double));
+    int* d = plan->dims;
+
+    // Subchains in order of length, each from its best cut.
+    for (int length = 2; length <= count; length++)
+    {
+        for (int i = 0; i + length <= count; i++)
+        {
+            int j = i + length - 1;
+            cost[i * count + j] = HUGE_VAL;
+            for (int k = i; k < j; k++)
+            {
+                for (int a = 0; a < NUM_ALGS; a++)
+                {
+                    double c = cost[i * count + k] + cost[(k + 1) * count + j] +
+                               algs[a].seconds * operations(algs[a].kind, d[i], d[k + 1], d[j + 1]);
+                    if (c < cost[i * count + j])
+                    {
+                        cost[i * count + j] = c;
+                        plan->split[i * count + j] = k;
+                        plan->alg[i * count + j] = a;
+                    }
+                }
+            }
+        }
+    }
+
+    plan->cost = cost[count - 1];
+    free(cost);
+    return true;
+}
+
+/**
+ * NAME: print_subchain
+ * INPUT: CHAIN_PLAN* plan, int i, int j
+ * USAGE: prints the parenthesization of the subchain i..j.
+ */
+static void print_subchain(CHAIN_PLAN* plan, int i, int j)
+{
+    if (i == j)
+    {
+        printf("A%d", i + 1);
+        return;
+    }
+    int k = plan->split[i * plan->count + j];
+    printf("(");
+    print_subchain(plan, i, k);
+    printf(" *%s ", algs[plan->alg[i * plan->count + j]].name);
+    print_subchain(plan, k + 1, j);
+    printf(")");
+}
+
+/**
+ * NAME: chain_print
+ * INPUT: CHAIN_PLAN* plan
+ * USAGE: prints the parenthesization, with the algorithm of each
+ *          product, and the estimated cost in seconds.
+ */
+void chain_print(CHAIN_PLAN* plan)
+{
+    printf("Plan: ");
+    print_subchain(plan, 0, plan->count - 1);
+    printf("\nEstimated time (in sec): %f\n", plan->cost);
+}
+
+/**
+ * NAME: run_subchain
+ * INPUT: MATRIX** ms, CHAIN_PLAN* plan, int i, int j
+ * OUTPUT: MATRIX*
+ * USAGE: the product of the subchain i..j: ms[i] itself if i == j,
+ *          otherwise a new matrix. Each half is freed as soon as it has
+ *          been used, so at most one intermediate per level is alive.
+ */
+static MATRIX* run_subchain(MATRIX** ms, CHAIN_PLAN* plan, int i, int j)
+{
+    if (i == j)
+        return ms[i];
+
+    int k = plan->split[i * plan->count + j];
+    MATRIX* left = run_subchain(ms, plan, i, k);
+    MATRIX* right = run_subchain(ms, plan, k + 1, j);
+    MATRIX* res = malloc(sizeof(MATRIX));
+    algs[plan->alg[i * plan->count + j]].fn(left, right, res);
+
+    if (i < k)
+        free_matrix(left);
+    if (k + 1 < j)
+        free_matrix(right);
+    return res;
+}
+
+/**
+ * NAME: chain_execute
+ * INPUT: MATRIX** ms, CHAIN_PLAN* plan, MATRIX* res
+ * USAGE: carries out plan on ms and stores the product in res.
+ *
+ * NOTES: assumes res is malloced. ms is left unchanged.
+ */
+void chain_execute(MATRIX** ms, CHAIN_PLAN* plan, MATRIX* res)
+{
+    if (plan->count == 1)
+    {
+        // A chain of one is a copy.
+        alloc_matrix(ms[0]->numRows, ms[0]->numCols, res);
+        for (int i = 0; i < res->numRows; i++)
+            memcpy(res->matrix[i], ms[0]->matrix[i], res->numCols * sizeof(BIGNUM));
+        return;
+    }
+
+    MATRIX* product = run_subchain(ms, plan, 0, plan->count - 1);
+    *res = *product;
+    free(product);
+}
+
+/**
+ * NAME: chain_free
+ * INPUT: CHAIN_PLAN* plan
+ * USAGE: frees the storage of plan.
+ */
+void chain_free(CHAIN_PLAN* plan)
+{
+    free(plan->dims);
+    free(plan->split);
+    free(plan->alg);
+}
+
+/**
+ * NAME: chain_mult
+ * INPUT: MATRIX** ms, int count, MATRIX* res
+ * OUTPUT: bool
+ * USAGE: plans and carries out the product ms[0] ... ms[count - 1],
+ *          storing it in res. Returns false if the shapes do not match.
+ *
+ * NOTES: assumes res is malloced.
+ */
+bool chain_mult(MATRIX** ms, int count, MATRIX* res)
+{
+    CHAIN_PLAN plan;
+    if (!chain_plan(ms, count, &plan))
+        return false;
+    chain_execute(ms, &plan, res);
+    chain_free(&plan);
+    return true;
+}
@@ -0,0 +1,90 @@
+/****************************************************************************
+ * chain.h
+ *
+ * Computer Science 51
+ * Matrix-Chain Multiplication
+ *
+ * Multiplies a chain A1 A2 ... An of matrices of varied shapes. The
+ * order of the products is chosen by the classic dynamic program over
+ * all parenthesizations, and each product gets its own algorithm, all
+ * priced by a cost model whose constants are measured on this machine
+ * (see chain_calibrate). Intermediate products are freed as soon as the
+ * product that uses them is done.
+ ***************************************************************************/
+#ifndef _CHAIN_H
+#define _CHAIN_H
+
+#include <stdbool.h>
+
+#include "matrix.h"
+
+// A plan for a chain of count matrices. For the subchain i..j (i < j),
+// split[i * count + j] is the k at which it is cut into i..k and
+// k+1..j, and alg[i * count + j] is the algorithm that multiplies the
+// two halves (an index into the algorithms chain_alg_name knows).
+typedef struct
+{
+    int count;
+    int* dims;
+    int* split;
+    int* alg;
+    double cost;
+}
+CHAIN_PLAN;
+
+/**
+ * NAME: chain_calibrate
+ * USAGE: times each algorithm once on a small product to set the cost
+ *          constants of the model. chain_plan does this the first time
+ *          if it has not been done.
+ */
+void chain_calibrate(void);
+
+/**
+ * NAME: chain_plan
+ * INPUT: MATRIX** ms, int count, CHAIN_PLAN* plan
+ * OUTPUT: bool
+ * USAGE: plans the product ms[0] ms[1] ... ms[count - 1]. Returns false
+ *          (and makes no plan) if count is 0 or neighbouring shapes do
+ *          not match.
+ *
+ * NOTES: release plan with chain_free.
+ */
+bool chain_plan(MATRIX** ms, int count, CHAIN_PLAN* plan);
+
+/**
+ * NAME: chain_print
+ * INPUT: CHAIN_PLAN* plan
+ * USAGE: prints the parenthesization, with the algorithm of each
+ *          product, and the estimated cost in seconds.
+ */
+void chain_print(CHAIN_PLAN* plan);
+
+/**
+ * NAME: chain_execute
+ * INPUT: MATRIX** ms, CHAIN_PLAN* plan, MATRIX* res
+ * USAGE: carries out plan on ms and stores the product in res.
+ *
+ * NOTES: assumes res is malloced. ms is left unchanged.
+ */
+void chain_execute(MATRIX** ms, CHAIN_PLAN* plan, MATRIX* res);
+
+/**
+ * NAME: chain_free
+ * INPUT: CHAIN_PLAN* plan
+ * USAGE: frees the storage of plan.
+ */
+void chain_free(CHAIN_PLAN* plan);
+
+/**
+ * NAME: chain_mult
+ * INPUT: MATRIX** ms, int count, MATRIX* res
+ * OUTPUT: bool
+ * USAGE: plans and carries out the product ms[0] ... ms[count - 1],
+ *          storing it in res. Returns false if the shapes do not match.
+ *
+ * NOTES: assumes res is malloced.
+ */
+bool chain_mult(MATRIX** ms, int count, MATRIX* res);
+
+#endif
@@ -0,0 +1,134 @@
+/****************************************************************************
+ * bignum.c
+ *
+ * Computer Science 51
+ * Bignum Functions
+ *
+ * Floating-point bignums (see bignum.h).
+ ***************************************************************************/
+
+#include "bignum.h"
+
+#ifdef FLOAT_BIGNUMS
+// significant digits that always read back the same float
+#define EXACT_DIGITS 9
+#else
+#define EXACT_DIGITS 17
+#endif
+
+/**
+ * Will add two bignums
+ * Needed for matrix mult algorithms
+ */
+void add_bignums(BIGNUM* b1, BIGNUM* b2, BIGNUM* res) 
+{
+    res->val = b1->val + b2->val;
+}
+
+/**
+ * Will mult two bignums. Sets res rather than adding to it.
+ * Needed for matrix mult algorithms
+ */
+void mult_bignums(BIGNUM* b1, BIGNUM* b2, BIGNUM* res)
+{
+    res->val = b1->val * b2->val;
+}
+
+/**
+ * Creates a bignum from an int.
+ */
+void bignum_from_int(int i, BIGNUM* b)
+{
+    b->val = i;
+}
+
+/**
+ * Will negate a Bignum 
+ */
+void negate_bignums(BIGNUM* b)
+{
+    b->val = -b->val;
+}
+
+/**
+ * Returns b, rounded to an integer, mod p in the range [0, p).
+ */
+long long bignum_mod(BIGNUM* b, long long p)
+{
+    double r = fmod(nearbyint(b->val), (double) p);
+    return (long long) ((r < 0) ? r + p : r);
+}
+
+/**
+ * Returns whether b is zero.
+ */
+bool bignum_is_zero(BIGNUM* b)
+{
+    return b->val == 0;
+}
+
+/**
+ * Returns a negative, zero or positive value as b1 is below, equal to
+ * or above b2.
+ */
+int bignum_compare(BIGNUM* b1, BIGNUM* b2)
+{
+    return (b1->val > b2->val) - (b1->val < b2->val);
+}
+
+/**
+ * Names this bignum implementation.
+ */
+const char* bignum_type_name(void)
+{
+#ifdef FLOAT_BIGNUMS
+    return "float";
+#else
+    return "double";
+#endif
+}
+
+/**
+ * Writes b in decimal, exactly enough to read back the same value, to
+ * buf (not NUL-terminated) and returns its length, or -1 if size bytes
+ * are not enough.
+ */
+int bignum_to_string(BIGNUM* b, char* buf, int size)
+{
+    char text[32];
+    int len = snprintf(text, sizeof(text), "%.*g", EXACT_DIGITS, (double) b->val);
+    if (len > size)
+        return -1;
+    memcpy(buf, text, len);
+    return len;
+}
+
+/**
+ * Parses len characters at s as a decimal number, in any form strtod
+ * takes, into b. Returns false if they are not one.
+ */
+bool bignum_from_string(const char* s, int len, BIGNUM* b)
+{
+    // strtod needs a terminated string.
+    char text[64];
+    if (len <= 0 || len >= (int) sizeof(text))
+        return false;
+    memcpy(text, s, len);
+    text[len] = '\0';
+
+    char* end;
+    double v = strtod(text, &end);
+    if (end != text + len)
+        return false;
+    b->val = (BIGNUM_REAL) v;
+    return true;
+}
+
+/**
+ * Will print bignum to stdout
+ */
+void print_bignum(BIGNUM* b)
+{
+    char buf[32];
+    fwrite(buf, 1, bignum_to_string(b, buf, sizeof(buf)), stdout);
+}
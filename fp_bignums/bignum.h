@@ -0,0 +1,144 @@
+/****************************************************************************
+ * bignum.h
+ *
+ * Computer Science 51
+ * Bignum Functions
+ *
+ * Floating-point "bignums": IEEE doubles, or floats if FLOAT_BIGNUMS is
+ * defined. Unlike the other types these round, so programs built on
+ * them see BIGNUM_UNIT_ROUNDOFF, the largest relative error of one
+ * operation, and strassen.c uses it to keep Strassen's rounding error
+ * within a tolerance (see rounding.h).
+ ***************************************************************************/
+#ifndef _BIGNUM_H
+#define _BIGNUM_H 
+
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef FLOAT_BIGNUMS
+typedef float BIGNUM_REAL;
+#define BIGNUM_UNIT_ROUNDOFF (FLT_EPSILON / 2)
+#define BIGNUM_MAX_DIGITS FLT_MAX_10_EXP
+#else
+typedef double BIGNUM_REAL;
+#define BIGNUM_UNIT_ROUNDOFF (DBL_EPSILON / 2)
+#define BIGNUM_MAX_DIGITS DBL_MAX_10_EXP
+#endif
+
+// Bignum structure 
+typedef struct
+{
+    BIGNUM_REAL val;
+}
+BIGNUM;
+
+/**
+ * Will print bignum to stdout
+ */
+void print_bignum(BIGNUM* b);
+
+/**
+ * Will add two bignums
+ * Needed for matrix mult algorithms
+ */
+void add_bignums(BIGNUM* b1, BIGNUM* b2, BIGNUM* res);
+
+/**
+ * Will mult two bignums. Sets res rather than adding to it.
+ * Needed for matrix mult algorithms
+ */
+void mult_bignums(BIGNUM* b1, BIGNUM* b2, BIGNUM* res);
+
+/**
+ * Creates a bignum from an int.
+ */
+void bignum_from_int(int i, BIGNUM* b);
+
+/**
+ * Will negate a Bignum 
+ */
+void negate_bignums(BIGNUM* b);
+
+/**
+ * Returns b, rounded to an integer, mod p in the range [0, p).
+ * p must be below 2^31.
+ */
+long long bignum_mod(BIGNUM* b, long long p);
+
+/**
+ * Returns whether b is zero.
+ */
+bool bignum_is_zero(BIGNUM* b);
+
+/**
+ * Returns a negative, zero or positive value as b1 is below, equal to
+ * or above b2.
+ */
+int bignum_compare(BIGNUM* b1, BIGNUM* b2);
+
+/**
+ * Names this bignum implementation.
+ */
+const char* bignum_type_name(void);
+
+/**
+ * Writes b in decimal, exactly enough to read back the same value, to
+ * buf (not NUL-terminated) and returns its length, or -1 if size bytes
+ * are not enough.
+ */
+int bignum_to_string(BIGNUM* b, char* buf, int size);
+
+/**
+ * Parses len characters at s as a decimal number, in any form strtod
+ * takes, into b. Returns false if they are not one.
+ */
+bool bignum_from_string(const char* s, int len, BIGNUM* b);
+
+/**
+ * Returns b as a double.
+ */
+static inline double bignum_to_double(BIGNUM* b)
+{
+    return b->val;
+}
+
+/**
+ * Multiplies b by 2^e, which is exact unless the result overflows or
+ * underflows. Winograd's algorithm uses it to balance its operands.
+ */
+static inline void bignum_scale(BIGNUM* b, int e)
+{
+    b->val = (BIGNUM_REAL) ldexp(b->val, e);
+}
+
+/**
+ * Adds x times row[j] to acc[j] for j in [0, n): the inner loop of the
+ * classical product, for multiply_accumulate and Strassen's leaves.
+ * Defined here so it can be inlined and vectorized, with fused
+ * multiply-adds where the target has them.
+ */
+#define BIGNUM_AXPY
+static inline void bignum_axpy(BIGNUM* restrict acc, BIGNUM* x, BIGNUM* restrict row, int n)
+{
+    BIGNUM_REAL a = x->val;
+    for (int j = 0; j < n; j++)
+    {
+#if defined(FLOAT_BIGNUMS) && defined(FP_FAST_FMAF)
+        acc[j].val = fmaf(a, row[j].val, acc[j].val);
+#elif !defined(FLOAT_BIGNUMS) && defined(FP_FAST_FMA)
+        acc[j].val = fma(a, row[j].val, acc[j].val);
+#else
+        acc[j].val += a * row[j].val;
+#endif
+    }
+}
+
+
+
+#endif
@@ -0,0 +1,290 @@
+/*************************************************************************
+ * gen.c
+ *
+ * Implements the workload generator. Cell (i, j) draws from counter
+ * positions (i * numCols + j) * DRAWS_PER_CELL onwards of the stream,
+ * and the low-rank factors from two further streams derived from the
+ * seed, so rows can be filled in any order on any thread.
+ ************************************************************************/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gen.h"
+#include "parallel.h"
+
+// counter positions reserved for each cell
+#define DRAWS_PER_CELL 32
+
+// decimal digits per chunk when building wide values
+#define CHUNK_DIGITS 4
+#define CHUNK_BASE 10000
+
+// seed used until gen_set_seed is called
+static unsigned long long baseSeed = 51;
+
+// number of matrices handed out by gen_defaults
+static unsigned long long streams = 0;
+
+/**
+ * NAME: gen_random
+ * INPUT: unsigned long long seed, unsigned long long counter
+ * OUTPUT: unsigned long long
+ * USAGE: the counter-th 64-bit random value of stream seed (SplitMix64
+ *          evaluated at an arbitrary position).
+ */
+unsigned long long gen_random(unsigned long long seed, unsigned long long counter)
+{
+    unsigned long long z = seed + (counter + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * NAME: gen_set_seed
+ * INPUT: unsigned long long seed
+ * USAGE: sets the seed initialize_matrix draws from. MATRIX_SEED in the
+ *          environment takes precedence, so runs can be reproduced.
+ */
+void gen_set_seed(unsigned long long seed)
+{
+    const char* env = getenv("MATRIX_SEED");
+    baseSeed = (env != NULL) ? strtoull(env, NULL, 10) : seed;
+    streams = 0;
+}
+
+/**
+ * NAME: env_int
+ * INPUT: const char* name, int fallback
+ * OUTPUT: int
+ * USAGE: reads an integer from the environment.
+ */
+static int env_int(const char* name, int fallback)
+{
+    const char* env = getenv(name);
+    return (env != NULL) ? atoi(env) : fallback;
+}
+
+/**
+ * NAME: gen_defaults
+ * INPUT: GEN_PARAMS* p
+ * USAGE: fills p with the default workload: uniform values below 10000,
+ *          overridden by MATRIX_DIST (uniform, signed, large, sparse,
+ *          identity, banded, lowrank), MATRIX_BOUND, MATRIX_DIGITS,
+ *          MATRIX_DENSITY, MATRIX_BAND and MATRIX_RANK.
+ *
+ * NOTES: each call gets a fresh seed derived from the gen_set_seed seed,
+ *          so successive matrices differ but the sequence is repeatable.
+ */
+void gen_defaults(GEN_PARAMS* p)
+{
+    static const char* names[] =
+        {"uniform", "signed", "large", "sparse", "identity", "banded", "lowrank"};
+
+    p->dist = GEN_UNIFORM;
+    const char* dist = getenv("MATRIX_DIST");
+    for (int d = 0; dist != NULL && d <= GEN_LOWRANK; d++)
+    {
+        if (strcmp(dist, names[d]) == 0)
+            p->dist = (GEN_DIST) d;
+    }
+
+    p->seed = gen_random(baseSeed, streams++);
+    p->bound = env_int("MATRIX_BOUND", 10000);
+    p->digits = env_int("MATRIX_DIGITS", 20);
+    p->band = env_int("MATRIX_BAND", 1);
+    p->rank = env_int("MATRIX_RANK", 2);
+    const char* density = getenv("MATRIX_DENSITY");
+    p->density = (density != NULL) ? atof(density) : 0.05;
+}
+
+/**
+ * NAME: signed_value
+ * INPUT: unsigned long long r, int bound
+ * OUTPUT: long long
+ * USAGE: maps a random word to (-bound, bound).
+ */
+static long long signed_value(unsigned long long r, int bound)
+{
+    long long mag = (long long) ((r >> 1) % (unsigned long long) bound);
+    return (r & 1) ? -mag : mag;
+}
+
+/**
+ * NAME: append_chunk
+ * INPUT: BIGNUM* b, int chunk, BIGNUM* scale
+ * USAGE: b = b * CHUNK_BASE + chunk, for non-negative b.
+ */
+static void append_chunk(BIGNUM* b, int chunk, BIGNUM* scale)
+{
+    BIGNUM shifted, digits;
+    bignum_from_int(0, &shifted);
+    mult_bignums(b, scale, &shifted);
+    bignum_from_int(chunk, &digits);
+    add_bignums(&shifted, &digits, b);
+}
+
+/**
+ * NAME: bignum_from_ll
+ * INPUT: long long v, BIGNUM* b
+ * USAGE: converts v into b through the bignum interface, so it works
+ *          for values outside int range with any bignum type.
+ */
+static void bignum_from_ll(long long v, BIGNUM* b)
+{
+    unsigned long long mag = (v < 0) ? -(unsigned long long) v : (unsigned long long) v;
+
+    // Split into base-10000 chunks, most significant first.
+    int chunks[8];
+    int count = 0;
+    do
+    {
+        chunks[count++] = (int) (mag % CHUNK_BASE);
+        mag /= CHUNK_BASE;
+    }
+    while (mag > 0);
+
+    BIGNUM scale;
+    bignum_from_int(CHUNK_BASE, &scale);
+    bignum_from_int(chunks[count - 1], b);
+    for (int c = count - 2; c >= 0; c--)
+        append_chunk(b, chunks[c], &scale);
+    if (v < 0)
+        negate_bignums(b);
+}
+
+/**
+ * NAME: gen_cell
+ * INPUT: GEN_PARAMS* p, int i, int j, int colSize, BIGNUM* b
+ * USAGE: computes cell (i, j) of the matrix described by p into b.
+ */
+static void gen_cell(GEN_PARAMS* p, int i, int j, int colSize, BIGNUM* b)
+{
+    unsigned long long counter = ((unsigned long long) i * colSize + j) * DRAWS_PER_CELL;
+    unsigned long long r = gen_random(p->seed, counter);
+
+    switch (p->dist)
+    {
+        case GEN_UNIFORM:
+            bignum_from_int((int) (r % (unsigned long long) p->bound), b);
+            break;
+
+        case GEN_SIGNED:
+            bignum_from_int((int) signed_value(r, p->bound), b);
+            break;
+
+        case GEN_SPARSE:
+            // top 53 bits as a uniform double in [0, 1)
+            if ((r >> 11) * (1.0 / 9007199254740992.0) < p->density)
+                bignum_from_int((int) signed_value(gen_random(p->seed, counter + 1), p->bound), b);
+            else
+                bignum_from_int(0, b);
+            break;
+
+        case GEN_IDENTITY:
+            bignum_from_int(i == j, b);
+            break;
+
+        case GEN_BANDED:
+            if (abs(i - j) <= p->band)
+                bignum_from_int((int) signed_value(r, p->bound), b);
+            else
+                bignum_from_int(0, b);
+            break;
+
+        case GEN_LOWRANK:
+        {
+            // Factor entries come from their own streams so every cell
+            // of a row or column sees the same factor.
+            unsigned long long uSeed = gen_random(p->seed, ~0ULL);
+            unsigned long long vSeed = gen_random(p->seed, ~1ULL);
+
+            // Each product is below 2^62, but rank of them may not fit a
+            // long long, so they are summed as bignums.
+            BIGNUM term, sum;
+            bignum_from_int(0, b);
+            for (int k = 0; k < p->rank; k++)
+            {
+                bignum_from_ll(signed_value(gen_random(uSeed, (unsigned long long) i * p->rank + k), p->bound) *
+                               signed_value(gen_random(vSeed, (unsigned long long) j * p->rank + k), p->bound),
+                               &term);
+                add_bignums(b, &term, &sum);
+                *b = sum;
+            }
+            break;
+        }
+
+        case GEN_LARGE:
+        {
+            // Leading chunk carries the leftover digits and is nonzero.
+            BIGNUM scale;
+            bignum_from_int(CHUNK_BASE, &scale);
+            int lead = (p->digits - 1) % CHUNK_DIGITS + 1;
+            int leadLow = 1;
+            for (int d = 1; d < lead; d++)
+                leadLow *= 10;
+            bignum_from_int(leadLow + (int) (r % (unsigned long long) (leadLow * 9)), b);
+
+            for (int c = 1; c <= (p->digits - 1) / CHUNK_DIGITS; c++)
+                append_chunk(b, (int) (gen_random(p->seed, counter + c) % CHUNK_BASE), &scale);
+            if (r >> 63)
+                negate_bignums(b);
+            break;
+        }
+    }
+}
+
+// Arguments of the parallel fill.
+typedef struct
+{
+    GEN_PARAMS* p;
+    MATRIX* m;
+}
+FILL_ARGS;
+
+/**
+ * NAME: fill_rows
+ * INPUT: int begin, int end, void* arg
+ * USAGE: parallel_for body generating rows [begin, end).
+ */
+static void fill_rows(int begin, int end, void* arg)
+{
+    FILL_ARGS* args = arg;
+    for (int i = begin; i < end; i++)
+        for (int j = 0; j < args->m->numCols; j++)
+            gen_cell(args->p, i, j, args->m->numCols, &args->m->matrix[i][j]);
+}
+
+/**
+ * NAME: generate_matrix
+ * INPUT: int rowSize, int colSize, GEN_PARAMS* p, MATRIX* m
+ * USAGE: initializes m to become a rowSize by colSize matrix drawn from
+ *          p, filling rows in parallel.
+ *
+ * NOTES: assumes m is malloced. GEN_LARGE values are limited to
+ *          BIGNUM_MAX_DIGITS digits, those the bignum type can hold.
+ */
+void generate_matrix(int rowSize, int colSize, GEN_PARAMS* p, MATRIX* m)
+{
+    alloc_matrix(rowSize, colSize, m);
+
+    // Keep the parameters in range so every cell is well defined.
+    GEN_PARAMS q = *p;
+    if (q.bound < 1)
+        q.bound = 1;
+    if (q.digits < 1)
+        q.digits = 1;
+    if (q.digits > CHUNK_DIGITS * (DRAWS_PER_CELL - 1))
+        q.digits = CHUNK_DIGITS * (DRAWS_PER_CELL - 1);
+#ifdef BIGNUM_MAX_DIGITS
+    // (GF(p) reduces values of any width, and has no limit.)
+    if (q.digits > BIGNUM_MAX_DIGITS)
+        q.digits = BIGNUM_MAX_DIGITS;
+#endif
+
+    FILL_ARGS args = {&q, m};
+    parallel_for(rowSize, fill_rows, &args);
+}
@@ -0,0 +1,84 @@
+/****************************************************************************
+ * gen.h
+ *
+ * Computer Science 51
+ * Workload Generator
+ *
+ * Seeded, reproducible random matrices. Every cell is a pure function of
+ * (seed, row, column), computed with a counter-based generator, so the
+ * output is the same on any libc and with any number of threads.
+ ***************************************************************************/
+#ifndef _GEN_H
+#define _GEN_H
+
+#include "matrix.h"
+
+// distributions generate_matrix can produce
+typedef enum
+{
+    GEN_UNIFORM,    // uniform in [0, bound)
+    GEN_SIGNED,     // uniform in (-bound, bound)
+    GEN_LARGE,      // random sign, exactly digits decimal digits
+    GEN_SPARSE,     // nonzero (signed, below bound) with probability density
+    GEN_IDENTITY,   // ones on the diagonal
+    GEN_BANDED,     // signed values where |i - j| <= band, zero elsewhere
+    GEN_LOWRANK     // product of two random signed factors of rank rank
+}
+GEN_DIST;
+
+// Parameters of a generated matrix. gen_defaults fills in the
+// distribution initialize_matrix uses.
+typedef struct
+{
+    GEN_DIST dist;
+    unsigned long long seed;
+    int bound;
+    int digits;
+    double density;
+    int band;
+    int rank;
+}
+GEN_PARAMS;
+
+/**
+ * NAME: gen_random
+ * INPUT: unsigned long long seed, unsigned long long counter
+ * OUTPUT: unsigned long long
+ * USAGE: the counter-th 64-bit random value of stream seed (SplitMix64
+ *          evaluated at an arbitrary position).
+ */
+unsigned long long gen_random(unsigned long long seed, unsigned long long counter);
+
+/**
+ * NAME: gen_set_seed
+ * INPUT: unsigned long long seed
+ * USAGE: sets the seed initialize_matrix draws from. MATRIX_SEED in the
+ *          environment takes precedence, so runs can be reproduced.
+ */
+void gen_set_seed(unsigned long long seed);
+
+/**
+ * NAME: gen_defaults
+ * INPUT: GEN_PARAMS* p
+ * USAGE: fills p with the default workload: uniform values below 10000,
+ *          overridden by MATRIX_DIST (uniform, signed, large, sparse,
+ *          identity, banded, lowrank), MATRIX_BOUND, MATRIX_DIGITS,
+ *          MATRIX_DENSITY, MATRIX_BAND and MATRIX_RANK.
+ *
+ * NOTES: each call gets a fresh seed derived from the gen_set_seed seed,
+ *          so successive matrices differ but the sequence is repeatable.
+ */
+void gen_defaults(GEN_PARAMS* p);
+
+/**
+ * NAME: generate_matrix
+ * INPUT: int rowSize, int colSize, GEN_PARAMS* p, MATRIX* m
+ * USAGE: initializes m to become a rowSize by colSize matrix drawn from
+ *          p, filling rows in parallel.
+ *
+ * NOTES: assumes m is malloced. GEN_LARGE values are limited to
+ *          BIGNUM_MAX_DIGITS digits, those the bignum type can hold.
+ */
+void generate_matrix(int rowSize, int colSize, GEN_PARAMS* p, MATRIX* m);
+
+#endif
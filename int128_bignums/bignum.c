@@ -0,0 +1,184 @@
+/****************************************************************************
+ * bignum.c
+ *
+ * Computer Science 51
+ * Bignum Functions
+ *
+ * 128-bit integers (see bignum.h). printf and strtol know nothing of
+ * __int128, so conversions to and from decimal are done here by hand.
+ ***************************************************************************/
+
+#include "bignum.h"
+
+// the largest magnitudes of positive and negative values
+#define INT128_MAX_MAG ((((unsigned __int128) 1) << 127) - 1)
+#define INT128_MIN_MAG (((unsigned __int128) 1) << 127)
+
+/**
+ * Will add two bignums
+ * Needed for matrix mult algorithms
+ */
+void add_bignums(BIGNUM* b1, BIGNUM* b2, BIGNUM* res)
+{
+    res->val = b1->val + b2->val;
+}
+
+/**
+ * Will mult two bignums
+ * Needed for matrix mult algorithms
+ */
+void mult_bignums(BIGNUM* b1, BIGNUM* b2, BIGNUM* res)
+{
+    // One 64 by 64 bit multiply when both fit, as in bignum_axpy.
+    long long x = (long long) b1->val;
+    long long y = (long long) b2->val;
+    if (x == b1->val && y == b2->val)
+        res->val = (__int128) x * y;
+    else
+        res->val = b1->val * b2->val;
+}
+
+/**
+ * Creates a bignum from an int.
+ */
+void bignum_from_int(int i, BIGNUM* b)
+{
+    b->val = i;
+}
+
+/**
+ * Will negate a Bignum
+ */
+void negate_bignums(BIGNUM* b)
+{
+    b->val = -b->val;
+}
+
+/**
+ * Returns b mod p in the range [0, p).
+ */
+long long bignum_mod(BIGNUM* b, long long p)
+{
+    long long r = (long long) (b->val % p);
+    return (r < 0) ? r + p : r;
+}
+
+/**
+ * Returns whether b is zero.
+ */
+bool bignum_is_zero(BIGNUM* b)
+{
+    return b->val == 0;
+}
+
+/**
+ * Returns a negative, zero or positive value as b1 is below, equal to
+ * or above b2.
+ */
+int bignum_compare(BIGNUM* b1, BIGNUM* b2)
+{
+    return (b1->val > b2->val) - (b1->val < b2->val);
+}
+
+/**
+ * Returns b as a double, rounded.
+ */
+double bignum_to_double(BIGNUM* b)
+{
+    return (double) b->val;
+}
+
+/**
+ * Names this bignum implementation.
+ */
+const char* bignum_type_name(void)
+{
+    return "int128";
+}
+
+/**
+ * Writes b in decimal to buf (not NUL-terminated) and returns its
+ * length, or -1 if size bytes are not enough.
+ */
+int bignum_to_string(BIGNUM* b, char* buf, int size)
+{
+    // Divisions of 128-bit values are slow, so peel off 19 digits at a
+    // time and convert those with 64-bit arithmetic. Digits are
+    // produced backwards, so build them at the end of a scratch buffer.
+    char digits[40];
+    int start = sizeof(digits);
+    unsigned __int128 mag = (b->val < 0) ? -(unsigned __int128) b->val
+                                         : (unsigned __int128) b->val;
+    const unsigned long long chunk = 10000000000000000000ULL;
+    while (mag >= chunk)
+    {
+        unsigned long long low = (unsigned long long) (mag % chunk);
+        mag /= chunk;
+        for (int d = 0; d < 19; d++)
+        {
+            digits[--start] = '0' + low % 10;
+            low /= 10;
+        }
+    }
+    unsigned long long high = (unsigned long long) mag;
+    do
+    {
+        digits[--start] = '0' + high % 10;
+        high /= 10;
+    }
+    while (high > 0);
+
+    int count = sizeof(digits) - start;
+    int len = count + (b->val < 0);
+    if (len > size)
+        return -1;
+
+    int pos = 0;
+    if (b->val < 0)
+        buf[pos++] = '-';
+    memcpy(buf + pos, digits + start, count);
+    return len;
+}
+
+/**
+ * Parses len characters at s as a decimal integer into b.
+ * Returns false if they are not one or the value overflows.
+ */
+bool bignum_from_string(const char* s, int len, BIGNUM* b)
+{
+    bool neg = false;
+    int i = 0;
+    if (len > 0 && (s[0] == '-' || s[0] == '+'))
+    {
+        neg = (s[0] == '-');
+        i++;
+    }
+    if (i == len)
+        return false;
+
+    // Accumulate the magnitude, allowing one more for the most negative
+    // value.
+    unsigned __int128 mag = 0;
+    unsigned __int128 limit = neg ? INT128_MIN_MAG : INT128_MAX_MAG;
+    for (; i < len; i++)
+    {
+        if (s[i] < '0' || s[i] > '9')
+            return false;
+        unsigned digit = s[i] - '0';
+        if (mag > (limit - digit) / 10)
+            return false;
+        mag = mag * 10 + digit;
+    }
+
+    b->val = neg ? (__int128) (0 - mag) : (__int128) mag;
+    return true;
+}
+
+/**
+ * Will print bignum to stdout
+ */
+void print_bignum(BIGNUM* b)
+{
+    char buf[48];
+    fwrite(buf, 1, bignum_to_string(b, buf, sizeof(buf)), stdout);
+}
@@ -0,0 +1,119 @@
+/****************************************************************************
+ * bignum.h
+ *
+ * Computer Science 51
+ * Bignum Functions
+ *
+ * 128-bit integers (GCC and clang's __int128), for exact products that
+ * overflow int64 by a few bits: 16 bytes a value where the bignums
+ * take 408, with add and multiply a couple of instructions each.
+ ***************************************************************************/
+#ifndef _BIGNUM_H
+#define _BIGNUM_H
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// Bignum structure
+typedef struct
+{
+    __int128 val;
+}
+BIGNUM;
+
+// most decimal digits of a value that always fits
+#define BIGNUM_MAX_DIGITS 38
+
+/**
+ * Will print bignum to stdout
+ */
+void print_bignum(BIGNUM* b);
+
+/**
+ * Will add two bignums
+ * Needed for matrix mult algorithms
+ */
+void add_bignums(BIGNUM* b1, BIGNUM* b2, BIGNUM* res);
+
+/**
+ * Will mult two bignums
+ * Needed for matrix mult algorithms
+ */
+void mult_bignums(BIGNUM* b1, BIGNUM* b2, BIGNUM* res);
+
+/**
+ * Creates a bignum from an int.
+ */
+void bignum_from_int(int i, BIGNUM* b);
+
+/**
+ * Will negate a Bignum
+ */
+void negate_bignums(BIGNUM* b);
+
+/**
+ * Returns b mod p in the range [0, p).
+ * p must be below 2^31.
+ */
+long long bignum_mod(BIGNUM* b, long long p);
+
+/**
+ * Returns whether b is zero.
+ */
+bool bignum_is_zero(BIGNUM* b);
+
+/**
+ * Returns a negative, zero or positive value as b1 is below, equal to
+ * or above b2.
+ */
+int bignum_compare(BIGNUM* b1, BIGNUM* b2);
+
+/**
+ * Returns b as a double, rounded.
+ */
+double bignum_to_double(BIGNUM* b);
+
+/**
+ * Names this bignum implementation.
+ */
+const char* bignum_type_name(void);
+
+/**
+ * Writes b in decimal to buf (not NUL-terminated) and returns its
+ * length, or -1 if size bytes are not enough.
+ */
+int bignum_to_string(BIGNUM* b, char* buf, int size);
+
+/**
+ * Parses len characters at s as a decimal integer into b.
+ * Returns false if they are not one or the value overflows.
+ */
+bool bignum_from_string(const char* s, int len, BIGNUM* b);
+
+/**
+ * Adds x times row[j] to acc[j] for j in [0, n): the inner loop of the
+ * classical product, for multiply_accumulate and Strassen's leaves.
+ * Inputs usually fit in 64 bits even when sums do not, and two of them
+ * multiply into 128 bits with one instruction where a full 128 by 128
+ * bit product takes three, so the loop widens them when they fit.
+ */
+#define BIGNUM_AXPY
+static inline void bignum_axpy(BIGNUM* restrict acc, BIGNUM* x, BIGNUM* restrict row, int n)
+{
+    __int128 a = x->val;
+    long long narrowA = (long long) a;
+    for (int j = 0; j < n; j++)
+    {
+        long long narrowB = (long long) row[j].val;
+        if (narrowA == a && narrowB == row[j].val)
+            acc[j].val += (__int128) narrowA * narrowB;
+        else
+            acc[j].val += a * row[j].val;
+    }
+}
+
+#endif
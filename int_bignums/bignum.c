@@ -41,10 +41,130 @@ void negate_bignums(BIGNUM* b)
   b->val = b->val * (-1);
 }
 
+/**
+ * Returns b mod p in the range [0, p).
+ */
+long long bignum_mod(BIGNUM* b, long long p)
+{
+    long long r = b->val % p;
+    return (r < 0) ? r + p : r;
+}
+
+/**
+ * Returns whether b is zero.
+ */
+bool bignum_is_zero(BIGNUM* b)
+{
+    return b->val == 0;
+}
+
+/**
+ * Returns a negative, zero or positive value as b1 is below, equal to
+ * or above b2.
+ */
+int bignum_compare(BIGNUM* b1, BIGNUM* b2)
+{
+    return (b1->val > b2->val) - (b1->val < b2->val);
+}
+
+/**
+ * Returns b as a double, rounded.
+ */
+double bignum_to_double(BIGNUM* b)
+{
+    return (double) b->val;
+}
+
+/**
+ * Names this bignum implementation.
+ */
+const char* bignum_type_name(void)
+{
+    return "int64";
+}
+
+/**
+ * Writes b in decimal to buf (not NUL-terminated) and returns its
+ * length, or -1 if size bytes are not enough.
+ */
+int bignum_to_string(BIGNUM* b, char* buf, int size)
+{
+    static const char pairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    
+    // Digits are produced backwards, two per division, so build them at
+    // the end of a scratch buffer.
+    char digits[24];
+    int start = sizeof(digits);
+    unsigned long long mag = (b->val < 0) ? -(unsigned long long) b->val
+                                          : (unsigned long long) b->val;
+    while (mag >= 100)
+    {
+        int pair = (int) (mag % 100) * 2;
+        mag /= 100;
+        digits[--start] = pairs[pair + 1];
+        digits[--start] = pairs[pair];
+    }
+    if (mag >= 10)
+    {
+        digits[--start] = pairs[mag * 2 + 1];
+        digits[--start] = pairs[mag * 2];
+    }
+    else
+        digits[--start] = '0' + mag;
+    
+    int count = sizeof(digits) - start;
+    int len = count + (b->val < 0);
+    if (len > size)
+        return -1;
+    
+    int pos = 0;
+    if (b->val < 0)
+        buf[pos++] = '-';
+    memcpy(buf + pos, digits + start, count);
+    return len;
+}
+
+/**
+ * Parses len characters at s as a decimal integer into b.
+ * Returns false if they are not one or the value overflows.
+ */
+bool bignum_from_string(const char* s, int len, BIGNUM* b)
+{
+    bool neg = false;
+    int i = 0;
+    if (len > 0 && (s[0] == '-' || s[0] == '+'))
+    {
+        neg = (s[0] == '-');
+        i++;
+    }
+    if (i == len)
+        return false;
+    
+    // Accumulate the magnitude, allowing one more for LLONG_MIN.
+    unsigned long long mag = 0;
+    unsigned long long limit = neg ? 9223372036854775808ULL : 9223372036854775807ULL;
+    for (; i < len; i++)
+    {
+        if (s[i] < '0' || s[i] > '9')
+            return false;
+        unsigned long long digit = s[i] - '0';
+        if (mag > (limit - digit) / 10)
+            return false;
+        mag = mag * 10 + digit;
+    }
+    
+    b->val = neg ? (long long) (0 - mag) : (long long) mag;
+    return true;
+}
+
 /**
  * Will print bignum to stdout
  */
 void print_bignum(BIGNUM* b)
 {
-    printf("%lld", b->val);
+    char buf[24];
+    fwrite(buf, 1, bignum_to_string(b, buf, sizeof(buf)), stdout);
 }
@@ -24,6 +24,9 @@ typedef struct
 }
 BIGNUM;
 
+// most decimal digits of a value that always fits
+#define BIGNUM_MAX_DIGITS 18
+
 /**
 * NAME: print_bignum
 * INPUT: MATRIX* m1, MATRIX* m2, MATRIX* res
@@ -55,6 +58,45 @@ void bignum_from_int(int i, BIGNUM* b);
  */
 void negate_bignums(BIGNUM* b);
 
+/**
+ * Returns b mod p in the range [0, p).
+ * p must be below 2^31.
+ */
+long long bignum_mod(BIGNUM* b, long long p);
+
+/**
+ * Returns whether b is zero.
+ */
+bool bignum_is_zero(BIGNUM* b);
+
+/**
+ * Returns a negative, zero or positive value as b1 is below, equal to
+ * or above b2.
+ */
+int bignum_compare(BIGNUM* b1, BIGNUM* b2);
+
+/**
+ * Returns b as a double, rounded.
+ */
+double bignum_to_double(BIGNUM* b);
+
+/**
+ * Names this bignum implementation.
+ */
+const char* bignum_type_name(void);
+
+/**
+ * Writes b in decimal to buf (not NUL-terminated) and returns its
+ * length, or -1 if size bytes are not enough.
+ */
+int bignum_to_string(BIGNUM* b, char* buf, int size);
+
+/**
+ * Parses len characters at s as a decimal integer into b.
+ * Returns false if they are not one or the value overflows.
+ */
+bool bignum_from_string(const char* s, int len, BIGNUM* b);
+
 
 
 #endif
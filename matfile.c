@@ -0,0 +1,396 @@
+/*************************************************************************
+ * matfile.c
+ *
+ * Implements reading and writing of binary matrix files (see matfile.h).
+ * Native files are mapped with mmap and exposed as a MATRIX whose row
+ * pointers point into the mapping, so opening a file costs one row
+ * pointer per row no matter how large the payload is.
+ ************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "matfile.h"
+
+// longest decimal value written to or read from a file
+#define MATFILE_MAX_DIGITS 4096
+
+/**
+ * NAME: fill_header
+ * INPUT: MATFILE_HEADER* h, int rowSize, int colSize, MATFILE_ELEM type
+ * USAGE: fills in everything but the variable-length section.
+ */
+static void fill_header(MATFILE_HEADER* h, int rowSize, int colSize, MATFILE_ELEM type)
+{
+    memset(h, 0, sizeof(*h));
+    memcpy(h->magic, MATFILE_MAGIC, sizeof(MATFILE_MAGIC));
+    h->version = MATFILE_VERSION;
+    h->elemType = type;
+    snprintf(h->bignumType, sizeof(h->bignumType), "%s", bignum_type_name());
+    h->numRows = rowSize;
+    h->numCols = colSize;
+    h->elemSize = (type == MATFILE_NATIVE) ? sizeof(BIGNUM) : sizeof(uint64_t);
+    h->stride = h->elemSize * colSize;
+    h->payloadOffset = MATFILE_ALIGN;
+}
+
+/**
+ * NAME: map_rows
+ * INPUT: MATFILE* f, MATRIX* m
+ * USAGE: points the rows of m into the native payload of the mapped f.
+ */
+static void map_rows(MATFILE* f, MATRIX* m)
+{
+    int rowSize = (int) f->header.numRows;
+    char* payload = (char*) f->base + f->header.payloadOffset;
+
+    m->matrix = (BIGNUM**) malloc(rowSize * sizeof(BIGNUM*));
+    for (int i = 0; i < rowSize; i++)
+        m->matrix[i] = (BIGNUM*) (payload + (size_t) i * f->header.stride);
+    m->numRows = rowSize;
+    m->numCols = (int) f->header.numCols;
+}
+
+/**
+ * NAME: matfile_write
+ * INPUT: const char* path, MATRIX* m, MATFILE_ELEM type
+ * OUTPUT: bool
+ * USAGE: writes m to path in the given element type.
+ */
+bool matfile_write(const char* path, MATRIX* m, MATFILE_ELEM type)
+{
+    FILE* out = fopen(path, "wb");
+    if (out == NULL)
+    {
+        printf("Error: cannot create %s\n", path);
+        return false;
+    }
+
+    MATFILE_HEADER h;
+    fill_header(&h, m->numRows, m->numCols, type);
+
+    // Decimal files need the length of every value before the payload.
+    int* lengths = NULL;
+    char digits[MATFILE_MAX_DIGITS];
+    if (type == MATFILE_DECIMAL)
+    {
+        lengths = malloc((size_t) m->numRows * m->numCols * sizeof(int));
+        h.varOffset = h.payloadOffset + h.stride * m->numRows;
+        for (int i = 0; i < m->numRows; i++)
+        {
+            for (int j = 0; j < m->numCols; j++)
+            {
+                int len = bignum_to_string(&m->matrix[i][j], digits, sizeof(digits));
+                if (len < 0)
+                {
+                    printf("Error: value at (%d, %d) is too long\n", i, j);
+                    free(lengths);
+                    fclose(out);
+                    return false;
+                }
+                lengths[(size_t) i * m->numCols + j] = len;
+                h.varSize += sizeof(uint32_t) + len;
+            }
+        }
+    }
+
+    // Header, then zeros up to the aligned payload.
+    fwrite(&h, sizeof(h), 1, out);
+    for (size_t pad = sizeof(h); pad < h.payloadOffset; pad++)
+        fputc(0, out);
+
+    if (type == MATFILE_NATIVE)
+    {
+        for (int i = 0; i < m->numRows; i++)
+            fwrite(m->matrix[i], sizeof(BIGNUM), m->numCols, out);
+    }
+    else
+    {
+        uint64_t offset = 0;
+        for (size_t c = 0; c < (size_t) m->numRows * m->numCols; c++)
+        {
+            fwrite(&offset, sizeof(offset), 1, out);
+            offset += sizeof(uint32_t) + lengths[c];
+        }
+        for (int i = 0; i < m->numRows; i++)
+        {
+            for (int j = 0; j < m->numCols; j++)
+            {
+                uint32_t len = bignum_to_string(&m->matrix[i][j], digits, sizeof(digits));
+                fwrite(&len, sizeof(len), 1, out);
+                fwrite(digits, 1, len, out);
+            }
+        }
+        free(lengths);
+    }
+
+    bool ok = !ferror(out);
+    if (fclose(out) != 0 || !ok)
+    {
+        printf("Error: failed writing %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * NAME: check_header
+ * INPUT: MATFILE_HEADER* h, size_t length, const char* path
+ * OUTPUT: bool
+ * USAGE: checks that h describes a file of length bytes this program
+ *          can read.
+ */
+static bool check_header(MATFILE_HEADER* h, size_t length, const char* path)
+{
+    if (memcmp(h->magic, MATFILE_MAGIC, sizeof(MATFILE_MAGIC)) != 0 ||
+        h->version != MATFILE_VERSION)
+    {
+        printf("Error: %s is not a matrix file\n", path);
+        return false;
+    }
+    if (h->elemType == MATFILE_NATIVE &&
+        (h->elemSize != sizeof(BIGNUM) ||
+         strncmp(h->bignumType, bignum_type_name(), sizeof(h->bignumType)) != 0))
+    {
+        printf("Error: %s holds native %s values, this program uses %s\n",
+               path, h->bignumType, bignum_type_name());
+        return false;
+    }
+    if (h->elemType == MATFILE_DECIMAL && h->elemSize != sizeof(uint64_t))
+    {
+        printf("Error: %s has a bad element size\n", path);
+        return false;
+    }
+    if (h->elemType != MATFILE_NATIVE && h->elemType != MATFILE_DECIMAL)
+    {
+        printf("Error: %s has unknown element type %u\n", path, h->elemType);
+        return false;
+    }
+    if (h->numRows > INT_MAX || h->numCols > INT_MAX)
+    {
+        printf("Error: %s is too large\n", path);
+        return false;
+    }
+
+    // Every size comes from the file, so no sum or product of them may
+    // overflow: compare by dividing and subtracting instead.
+    if (h->numCols > h->stride / h->elemSize ||
+        h->payloadOffset > length ||
+        (h->numRows > 0 && h->stride > (length - h->payloadOffset) / h->numRows) ||
+        h->varOffset > length ||
+        h->varSize > length - h->varOffset)
+    {
+        printf("Error: %s is truncated\n", path);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * NAME: matfile_read_header
+ * INPUT: int fd, const char* path, MATFILE_HEADER* h
+ * OUTPUT: bool
+ * USAGE: reads and checks the header of the matrix file open as fd, for
+ *          callers that read the payload themselves.
+ */
+bool matfile_read_header(int fd, const char* path, MATFILE_HEADER* h)
+{
+    struct stat st;
+    if (fstat(fd, &st) != 0 || pread(fd, h, sizeof(*h), 0) != sizeof(*h))
+    {
+        printf("Error: cannot read %s\n", path);
+        return false;
+    }
+    return check_header(h, st.st_size, path);
+}
+
+/**
+ * NAME: matfile_write_header
+ * INPUT: int fd, int rowSize, int colSize, MATFILE_HEADER* h
+ * OUTPUT: bool
+ * USAGE: writes the header of a native rowSize by colSize matrix to fd
+ *          and sizes the file for its payload, which is left unwritten.
+ */
+bool matfile_write_header(int fd, int rowSize, int colSize, MATFILE_HEADER* h)
+{
+    fill_header(h, rowSize, colSize, MATFILE_NATIVE);
+    return ftruncate(fd, h->payloadOffset + h->stride * rowSize) == 0 &&
+           pwrite(fd, h, sizeof(*h), 0) == sizeof(*h);
+}
+
+/**
+ * NAME: parse_decimal
+ * INPUT: MATFILE* f, MATRIX* m, const char* path
+ * OUTPUT: bool
+ * USAGE: allocates m and parses the decimal payload of the mapped f.
+ *          On failure m is left unallocated.
+ */
+static bool parse_decimal(MATFILE* f, MATRIX* m, const char* path)
+{
+    MATFILE_HEADER* h = &f->header;
+    char* payload = (char*) f->base + h->payloadOffset;
+    char* var = (char*) f->base + h->varOffset;
+
+    // Parse into a scratch matrix so a bad file leaves m untouched.
+    MATRIX* tmp = malloc(sizeof(MATRIX));
+    alloc_matrix((int) h->numRows, (int) h->numCols, tmp);
+    for (int i = 0; i < tmp->numRows; i++)
+    {
+        uint64_t* offsets = (uint64_t*) (payload + (size_t) i * h->stride);
+        for (int j = 0; j < tmp->numCols; j++)
+        {
+            // offsets[j] comes from the file; keep every bound a
+            // subtraction so a huge offset cannot wrap around.
+            uint32_t len = 0;
+            bool fits = h->varSize >= sizeof(len) && offsets[j] <= h->varSize - sizeof(len);
+            if (fits)
+            {
+                memcpy(&len, var + offsets[j], sizeof(len));
+                fits = len <= h->varSize - sizeof(len) - offsets[j];
+            }
+
+            if (!fits ||
+                !bignum_from_string(var + offsets[j] + sizeof(len), len, &tmp->matrix[i][j]))
+            {
+                printf("Error: bad value at (%d, %d) in %s\n", i, j, path);
+                free_matrix(tmp);
+                return false;
+            }
+        }
+    }
+
+    *m = *tmp;
+    free(tmp);
+    return true;
+}
+
+/**
+ * NAME: matfile_open
+ * INPUT: const char* path, bool writable, MATFILE* f, MATRIX* m
+ * OUTPUT: bool
+ * USAGE: opens the matrix at path as m. Native files are mapped and m
+ *          becomes a view of the file: with writable, changes to m go
+ *          to the file, otherwise they stay private to the process.
+ *          Decimal files are parsed into newly allocated storage.
+ *
+ * NOTES: assumes m is malloced. m must be released with matfile_close,
+ *          not free_matrix.
+ */
+bool matfile_open(const char* path, bool writable, MATFILE* f, MATRIX* m)
+{
+    int fd = open(path, writable ? O_RDWR : O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(MATFILE_HEADER))
+    {
+        printf("Error: cannot open %s\n", path);
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+
+    // Private mappings are copy-on-write, so algorithms that modify
+    // their inputs in place (subtract_matrices negates) still work.
+    f->length = st.st_size;
+    f->shared = writable;
+    f->base = mmap(NULL, f->length, PROT_READ | PROT_WRITE,
+                   writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (f->base == MAP_FAILED)
+    {
+        printf("Error: cannot map %s\n", path);
+        f->base = NULL;
+        return false;
+    }
+
+    memcpy(&f->header, f->base, sizeof(f->header));
+    if (!check_header(&f->header, f->length, path))
+    {
+        munmap(f->base, f->length);
+        f->base = NULL;
+        return false;
+    }
+
+    if (f->header.elemType == MATFILE_NATIVE)
+    {
+        map_rows(f, m);
+        return true;
+    }
+
+    // Decimal values are parsed into memory; the mapping is not kept.
+    bool ok = parse_decimal(f, m, path);
+    munmap(f->base, f->length);
+    f->base = NULL;
+    return ok;
+}
+
+/**
+ * NAME: matfile_create
+ * INPUT: const char* path, int rowSize, int colSize, MATFILE* f, MATRIX* m
+ * OUTPUT: bool
+ * USAGE: creates a native file for a rowSize by colSize matrix of zeros
+ *          and maps it writable as m, so results can be written straight
+ *          into the file.
+ *
+ * NOTES: assumes m is malloced. m must be released with matfile_close,
+ *          not free_matrix.
+ */
+bool matfile_create(const char* path, int rowSize, int colSize, MATFILE* f, MATRIX* m)
+{
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || !matfile_write_header(fd, rowSize, colSize, &f->header))
+    {
+        printf("Error: cannot create %s\n", path);
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+
+    f->length = f->header.payloadOffset + f->header.stride * rowSize;
+    f->shared = true;
+    f->base = mmap(NULL, f->length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (f->base == MAP_FAILED)
+    {
+        printf("Error: cannot map %s\n", path);
+        f->base = NULL;
+        return false;
+    }
+
+    map_rows(f, m);
+    for (int i = 0; i < rowSize; i++)
+        for (int j = 0; j < colSize; j++)
+            bignum_from_int(0, &m->matrix[i][j]);
+    return true;
+}
+
+/**
+ * NAME: matfile_close
+ * INPUT: MATFILE* f, MATRIX* m
+ * USAGE: releases a matrix opened with matfile_open or matfile_create,
+ *          flushing a writable mapping to disk. Frees m like free_matrix.
+ */
+void matfile_close(MATFILE* f, MATRIX* m)
+{
+    // Parsed matrices live in ordinary memory.
+    if (f->base == NULL)
+    {
+        free_matrix(m);
+        return;
+    }
+
+    if (f->shared)
+        msync(f->base, f->length, MS_SYNC);
+    munmap(f->base, f->length);
+    f->base = NULL;
+    free(m->matrix);
+    free(m);
+}
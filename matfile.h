@@ -0,0 +1,136 @@
+/****************************************************************************
+ * matfile.h
+ *
+ * Computer Science 51
+ * Binary Matrix Files
+ *
+ * On-disk matrix format. A file is a MATFILE_HEADER followed, at the
+ * page-aligned payloadOffset, by numRows rows of numCols cells, each
+ * row stride bytes apart. There are two element types:
+ *
+ *   MATFILE_NATIVE   cells are BIGNUM structs exactly as in memory
+ *                    (elemSize == sizeof(BIGNUM)), so the file can be
+ *                    mmapped straight into a MATRIX with no parsing or
+ *                    copying. Only readable by the same bignum type
+ *                    (recorded in bignumType).
+ *
+ *   MATFILE_DECIMAL  cells are 64-bit offsets into a variable-length
+ *                    section at varOffset, where each value is stored
+ *                    as a 32-bit length and that many ASCII characters
+ *                    of its decimal form. Portable between bignum types;
+ *                    loading it parses every value.
+ *
+ * All integers are stored in the byte order of the writing machine.
+ ***************************************************************************/
+#ifndef _MATFILE_H
+#define _MATFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "matrix.h"
+
+#define MATFILE_MAGIC "CS51MAT"
+#define MATFILE_VERSION 2
+
+// payloadOffset is a multiple of this, so mapped rows are page aligned
+#define MATFILE_ALIGN 4096
+
+typedef enum
+{
+    MATFILE_NATIVE = 1,
+    MATFILE_DECIMAL = 2
+}
+MATFILE_ELEM;
+
+// First 128 bytes of every matrix file.
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t elemType;
+    char bignumType[24];
+    uint64_t numRows;
+    uint64_t numCols;
+    uint64_t elemSize;
+    uint64_t stride;
+    uint64_t payloadOffset;
+    uint64_t varOffset;
+    uint64_t varSize;
+    char reserved[32];
+}
+MATFILE_HEADER;
+
+// An open matrix file. base is NULL when the matrix was parsed into
+// ordinary memory rather than mapped.
+typedef struct
+{
+    void* base;
+    size_t length;
+    bool shared;
+    MATFILE_HEADER header;
+}
+MATFILE;
+
+/**
+ * NAME: matfile_write
+ * INPUT: const char* path, MATRIX* m, MATFILE_ELEM type
+ * OUTPUT: bool
+ * USAGE: writes m to path in the given element type.
+ */
+bool matfile_write(const char* path, MATRIX* m, MATFILE_ELEM type);
+
+/**
+ * NAME: matfile_open
+ * INPUT: const char* path, bool writable, MATFILE* f, MATRIX* m
+ * OUTPUT: bool
+ * USAGE: opens the matrix at path as m. Native files are mapped and m
+ *          becomes a view of the file: with writable, changes to m go
+ *          to the file, otherwise they stay private to the process.
+ *          Decimal files are parsed into newly allocated storage.
+ *
+ * NOTES: assumes m is malloced. m must be released with matfile_close,
+ *          not free_matrix.
+ */
+bool matfile_open(const char* path, bool writable, MATFILE* f, MATRIX* m);
+
+/**
+ * NAME: matfile_create
+ * INPUT: const char* path, int rowSize, int colSize, MATFILE* f, MATRIX* m
+ * OUTPUT: bool
+ * USAGE: creates a native file for a rowSize by colSize matrix of zeros
+ *          and maps it writable as m, so results can be written straight
+ *          into the file.
+ *
+ * NOTES: assumes m is malloced. m must be released with matfile_close,
+ *          not free_matrix.
+ */
+bool matfile_create(const char* path, int rowSize, int colSize, MATFILE* f, MATRIX* m);
+
+/**
+ * NAME: matfile_read_header
+ * INPUT: int fd, const char* path, MATFILE_HEADER* h
+ * OUTPUT: bool
+ * USAGE: reads and checks the header of the matrix file open as fd, for
+ *          callers that read the payload themselves.
+ */
+bool matfile_read_header(int fd, const char* path, MATFILE_HEADER* h);
+
+/**
+ * NAME: matfile_write_header
+ * INPUT: int fd, int rowSize, int colSize, MATFILE_HEADER* h
+ * OUTPUT: bool
+ * USAGE: writes the header of a native rowSize by colSize matrix to fd
+ *          and sizes the file for its payload, which is left unwritten.
+ */
+bool matfile_write_header(int fd, int rowSize, int colSize, MATFILE_HEADER* h);
+
+/**
+ * NAME: matfile_close
+ * INPUT: MATFILE* f, MATRIX* m
+ * USAGE: releases a matrix opened with matfile_open or matfile_create,
+ *          flushing a writable mapping to disk. Frees m like free_matrix.
+ */
+void matfile_close(MATFILE* f, MATRIX* m);
+
+#endif
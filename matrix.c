@@ -11,7 +11,30 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "gen.h"
 #include "matrix.h"
+#include "memtrack.h"
+#include "textio.h"
+
+/**
+ * NAME: alloc_matrix
+ * INPUT: int rowSize, int colSize, MATRIX* m
+ * USAGE: allocates storage for m as a rowSize by colSize matrix.
+ *          Entries are left uninitialized.
+ *
+ * NOTES: assumes m is malloced. The storage is counted by memtrack.
+ */
+void alloc_matrix(int rowSize, int colSize, MATRIX* m)
+{
+    m->matrix = (BIGNUM**) malloc(rowSize * sizeof(BIGNUM*));
+    for(int i = 0; i < rowSize; i++)
+        m->matrix[i] = (BIGNUM*) malloc(colSize * sizeof(BIGNUM));
+    memtrack_alloc(rowSize * (sizeof(BIGNUM*) + colSize * sizeof(BIGNUM)));
+      
+    // Fill in information
+    m->numRows = rowSize;
+    m->numCols = colSize;
+}
 
 /**
  * NAME: zero_matrix
@@ -23,45 +46,29 @@
  */
 void zero_matrix(int rowSize, int colSize, MATRIX* m)
 {
-    m->matrix = (BIGNUM**) malloc(rowSize * sizeof(BIGNUM*));
+    alloc_matrix(rowSize, colSize, m);
     for(int i = 0; i < rowSize; i++)
     {
-        m->matrix[i] = (BIGNUM*) malloc(colSize * sizeof(BIGNUM));
         for(int j = 0; j < colSize; j++)
             bignum_from_int(0, &m->matrix[i][j]);
     }
-      
-    // Fill in information
-    m->numRows = rowSize;
-    m->numCols = colSize;
 }
 
 /**
  * NAME: initialize_matrix
  * INPUT: int rowSize, int colSize, MATRIX* m
  * USAGE: initializes m to become a rowSize by colSize matrix.
- *          fills all values with random values <= 10000.
+ *          fills all values with random values < 10000, or from the
+ *          workload selected by MATRIX_DIST (see gen.h).
  *
- * NOTES: assumes m is malloced.
+ * NOTES: assumes m is malloced. Seed with gen_set_seed.
  */
 void initialize_matrix(int rowSize, int colSize, MATRIX* m)
 {
-   // Allocate memory for the matrix and initialize values to random.
-    m->matrix = (BIGNUM**) malloc(rowSize * sizeof(BIGNUM*));
-    for(int i = 0; i < rowSize; i++)
-    {
-        m->matrix[i] = (BIGNUM*) malloc(colSize * sizeof(BIGNUM));
-        for(int j=0; j<colSize; j++)
-        {
-            int value = rand()%10000;
-            bignum_from_int(value,&m->matrix[i][j]);
-        }
-    }   
-        
-    // Fill in information
-    m->numCols = colSize;
-    m->numRows = rowSize;
-    
+    // Draw from the default workload.
+    GEN_PARAMS p;
+    gen_defaults(&p);
+    generate_matrix(rowSize, colSize, &p, m);
 }
 
 /**
@@ -71,18 +78,9 @@ void initialize_matrix(int rowSize, int colSize, MATRIX* m)
  */
 void print_matrix(MATRIX* m)
 {
-    int a = m->numRows;
-    int b = m->numCols;
-    for(int i = 0; i < a; i++)
-    {    
-        printf("\n");
-        for(int j = 0; j < b; j++)
-        {
-            print_bignum(&(m->matrix[i][j]));
-            printf("\t");
-        }
-    }
-    printf("\n");
+    // Formatting row by row and writing whole rows is much faster than
+    // printing every value (and digit) separately.
+    textio_write_matrix(stdout, m, TEXT_PRINT);
 }
 
 /**
@@ -98,6 +96,7 @@ void free_matrix(MATRIX* m)
     // Deallocate the matrix values.
     for(int i = 0; i < numRows; i++)
         free(m->matrix[i]);
+    memtrack_release(numRows * (sizeof(BIGNUM*) + m->numCols * sizeof(BIGNUM)));
     
     // Free the stored matrix
     free(m->matrix);
@@ -105,6 +104,38 @@ void free_matrix(MATRIX* m)
 }
     
 
+/**
+ * NAME: view_matrix
+ * INPUT: MATRIX* m, int row, int col, int rowSize, int colSize, MATRIX* v
+ * USAGE: makes v the rowSize by colSize block of m starting at (row, col).
+ *          v shares m's storage, so nothing is copied and writes to v
+ *          change m.
+ *
+ * NOTES: assumes v is malloced. Release v with free_view, not
+ *          free_matrix, and before m.
+ */
+void view_matrix(MATRIX* m, int row, int col, int rowSize, int colSize, MATRIX* v)
+{
+    // Only the row pointers are new; they point into m's rows.
+    v->matrix = (BIGNUM**) malloc(rowSize * sizeof(BIGNUM*));
+    for (int i = 0; i < rowSize; i++)
+        v->matrix[i] = m->matrix[row + i] + col;
+    v->numRows = rowSize;
+    v->numCols = colSize;
+}
+
+/**
+ * NAME: free_view
+ * INPUT: MATRIX* v
+ * USAGE: frees a view made by view_matrix, leaving the matrix it
+ *          points into alone.
+ */
+void free_view(MATRIX* v)
+{
+    free(v->matrix);
+    free(v);
+}
+
 /* HELPER FUNCTIONS */
 
 /**
@@ -115,10 +146,9 @@ void free_matrix(MATRIX* m)
  * NOTES: res must already be initialized.
  */
 void add_matrices(MATRIX* m1, MATRIX* m2, MATRIX* res){
-    int len = m1->numRows;
-    for(int i=0; i<len; i++)
+    for(int i=0; i<m1->numRows; i++)
     {
-        for(int j=0; j<len; j++)
+        for(int j=0; j<m1->numCols; j++)
             add_bignums(&m1->matrix[i][j], &m2->matrix[i][j], &res->matrix[i][j]);
     }
 }
@@ -131,10 +161,9 @@ void add_matrices(MATRIX* m1, MATRIX* m2, MATRIX* res){
  * NOTS: res must already be initialized.
  */
 void subtract_matrices(MATRIX* m1, MATRIX* m2, MATRIX* res){
-    int len = m1->numRows;
-    for(int i=0; i<len; i++)
+    for(int i=0; i<m1->numRows; i++)
     {
-        for(int j=0; j<len; j++)
+        for(int j=0; j<m1->numCols; j++)
         {
             negate_bignums(&m2->matrix[i][j]);
             add_bignums(&m1->matrix[i][j], &m2->matrix[i][j], &res->matrix[i][j]);
@@ -143,6 +172,41 @@ void subtract_matrices(MATRIX* m1, MATRIX* m2, MATRIX* res){
     }
 }
 
+/**
+ * NAME: multiply_accumulate
+ * INPUT: MATRIX* m1, MATRIX* m2, MATRIX* res
+ * USAGE: adds m1 times m2 to res with the classical algorithm. The leaf
+ *          kernel of the recursive algorithms.
+ *
+ * NOTES: res must already be initialized. The loops run i-k-j, so the
+ *          inner loop walks rows of m2 and res; bignum types that define
+ *          BIGNUM_AXPY supply that loop themselves.
+ */
+void multiply_accumulate(MATRIX* m1, MATRIX* m2, MATRIX* res)
+{
+    for (int i = 0; i < m1->numRows; i++)
+    {
+        for (int k = 0; k < m1->numCols; k++)
+        {
+            BIGNUM* a = &m1->matrix[i][k];
+            BIGNUM* row = m2->matrix[k];
+#ifdef BIGNUM_AXPY
+            bignum_axpy(res->matrix[i], a, row, m2->numCols);
+#else
+            BIGNUM product, sum;
+            for (int j = 0; j < m2->numCols; j++)
+            {
+                // mult_bignums adds into its result, so start from zero.
+                bignum_from_int(0, &product);
+                mult_bignums(a, &row[j], &product);
+                add_bignums(&res->matrix[i][j], &product, &sum);
+                res->matrix[i][j] = sum;
+            }
+#endif
+        }
+    }
+}
+
 /*
  * Borrowed from CS50 Staff Code from fall 2012 pset5
  * Helper function to calculate time
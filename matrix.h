@@ -6,7 +6,9 @@
  *
  * Fundamental Data structures for project
  ***************************************************************************/
- 
+#ifndef _MATRIX_H
+#define _MATRIX_H
+
 #include "bignum.h" 
 #include <stdint.h>
 #include <sys/resource.h>
@@ -26,6 +28,16 @@ typedef struct
 }
 MATRIX;
 
+/**
+ * NAME: alloc_matrix
+ * INPUT: int rowSize, int colSize, MATRIX* m
+ * USAGE: allocates storage for m as a rowSize by colSize matrix.
+ *          Entries are left uninitialized.
+ *
+ * NOTES: assumes m is malloced. The storage is counted by memtrack.
+ */
+void alloc_matrix(int rowSize, int colSize, MATRIX* m);
+
 /**
  * NAME: zero_matrix
  * INPUT: int rowSize, int colSize, MATRIX* m
@@ -40,9 +52,10 @@ void zero_matrix(int rowSize, int colSize, MATRIX* m);
  * NAME: initialize_matrix
  * INPUT: int rowSize, int colSize, MATRIX* m
  * USAGE: initializes m to become a rowSize by colSize matrix.
- *          fills all values with random values <= 10000.
+ *          fills all values with random values < 10000, or from the
+ *          workload selected by MATRIX_DIST (see gen.h).
  *
- * NOTES: assumes m is malloced.
+ * NOTES: assumes m is malloced. Seed with gen_set_seed.
  */
 void initialize_matrix(int rowSize, int colSize, MATRIX* m);
 
@@ -62,6 +75,26 @@ void print_matrix(MATRIX* m);
  */
 void free_matrix(MATRIX* m);
 
+/**
+ * NAME: view_matrix
+ * INPUT: MATRIX* m, int row, int col, int rowSize, int colSize, MATRIX* v
+ * USAGE: makes v the rowSize by colSize block of m starting at (row, col).
+ *          v shares m's storage, so nothing is copied and writes to v
+ *          change m.
+ *
+ * NOTES: assumes v is malloced. Release v with free_view, not
+ *          free_matrix, and before m.
+ */
+void view_matrix(MATRIX* m, int row, int col, int rowSize, int colSize, MATRIX* v);
+
+/**
+ * NAME: free_view
+ * INPUT: MATRIX* v
+ * USAGE: frees a view made by view_matrix, leaving the matrix it
+ *          points into alone.
+ */
+void free_view(MATRIX* v);
+
 /* HELPER FUNCTIONS */
 
 /**
@@ -82,10 +115,21 @@ void add_matrices(MATRIX* m1, MATRIX* m2, MATRIX* res);
  */
 void subtract_matrices(MATRIX* m1, MATRIX* m2, MATRIX* res);
 
+/**
+ * NAME: multiply_accumulate
+ * INPUT: MATRIX* m1, MATRIX* m2, MATRIX* res
+ * USAGE: adds m1 times m2 to res with the classical algorithm. The leaf
+ *          kernel of the recursive algorithms.
+ *
+ * NOTES: res must already be initialized. The loops run i-k-j, so the
+ *          inner loop walks rows of m2 and res.
+ */
+void multiply_accumulate(MATRIX* m1, MATRIX* m2, MATRIX* res);
+
 /*
 *Borrowed from CS50 Staff Code from fall 2012 pset5
 *Helper function to calculate time
 */
 double calculate(const struct rusage* b, const struct rusage* a);
 
-
+#endif
@@ -0,0 +1,679 @@
+/*************************************************************************
+ * matutil.c
+ *
+ * Command-line tool for binary matrix files (see matfile.h).
+ * "matutil" uses bignums and "intmatutil" uses 64bit ints.
+ *
+ * Usage:
+ *   matutil gen ROWS COLS FILE [native|decimal]
+ *   matutil print FILE
+ *   matutil convert IN OUT native|decimal
+ *   matutil mult ALG A B C [native|decimal]
+ *   matutil auto ALG A B C
+ *   matutil ooc ALG A B C [TILE]
+ *   matutil pow A K C [native|decimal]
+ *   matutil chain C A1 A2 [A3 ...]
+ *   matutil bool A B C [or|gf2|count]
+ *   matutil closure A C
+ *   matutil semiring RING ALG A B C
+ *   matutil narrow A B C [int8|int16]
+ *   matutil pool A B C
+ *   matutil import TEXT FILE [native|decimal]
+ *   matutil export FILE TEXT [csv|tsv]
+ *
+ * ALG is regular, winograd, strassen, recursive, morton (Strassen on
+ * the Morton layout), planes (the same in digit planes), rect
+ * (Strassen without padding to one square, see rect_mult in mult.h) or
+ * sparse (CSR, see sparse.h). gen uses the workload generator, so
+ * MATRIX_DIST, MATRIX_SEED etc. apply. Native files are opened without
+ * copying. auto bounds every value ALG would form on A and B and runs
+ * mult in the matutil of the narrowest exact type that holds them (see
+ * bounds.h), writing C in decimal. ooc multiplies native files tile by
+ * tile without loading them (see ooc.h). pow raises A to the power K
+ * (see matrix_pow in mult.h). chain multiplies A1 A2 ... in the order
+ * and with the algorithms chain.h plans. bool and closure treat
+ * nonzeros as 1 and work bit-packed (see boolmat.h). semiring
+ * multiplies over RING, plus-times, min-plus or max-plus, with ALG
+ * regular or blocked, or any ALG for plus-times (see semiring.h).
+ * narrow multiplies with int8 or int16 entries, by default the
+ * narrowest that holds A and B (see narrow.h). pool multiplies with A,
+ * B and C held in pooled storage, sized by their digits (see
+ * poolmat.h). import and export convert from and to CSV/TSV text (see
+ * textio.h).
+ ************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "boolmat.h"
+#include "bounds.h"
+#include "chain.h"
+#include "gen.h"
+#include "matfile.h"
+#include "matrix.h"
+#include "mult.h"
+#include "narrow.h"
+#include "ooc.h"
+#include "poolmat.h"
+#include "semiring.h"
+#include "sparse.h"
+#include "textio.h"
+#include "verify.h"
+
+/**
+ * NAME: parse_elem
+ * INPUT: const char* s, MATFILE_ELEM* type
+ * OUTPUT: bool
+ * USAGE: parses an element type name; NULL means native.
+ */
+static bool parse_elem(const char* s, MATFILE_ELEM* type)
+{
+    if (s == NULL || strcmp(s, "native") == 0)
+        *type = MATFILE_NATIVE;
+    else if (strcmp(s, "decimal") == 0)
+        *type = MATFILE_DECIMAL;
+    else
+    {
+        printf("Error: unknown element type %s\n", s);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * NAME: parse_alg
+ * INPUT: const char* s
+ * OUTPUT: OOC_MULT
+ * USAGE: finds the algorithm called s, or NULL.
+ */
+static OOC_MULT parse_alg(const char* s)
+{
+    if (strcmp(s, "regular") == 0)
+        return regular_mult;
+    if (strcmp(s, "winograd") == 0)
+        return winograd_mult;
+    if (strcmp(s, "strassen") == 0)
+        return strassen_mult;
+    if (strcmp(s, "recursive") == 0)
+        return recursive_mult;
+    if (strcmp(s, "morton") == 0)
+        return strassen_morton_mult;
+    if (strcmp(s, "planes") == 0)
+        return strassen_planes_mult;
+    if (strcmp(s, "rect") == 0)
+        return rect_mult;
+    if (strcmp(s, "sparse") == 0)
+        return sparse_matrix_mult;
+    return NULL;
+}
+
+/**
+ * NAME: run_program
+ * INPUT: const char* self, const char* program, char* args[]
+ * OUTPUT: int
+ * USAGE: replaces this process with program, found in the directory of
+ *          self (this program's argv[0]) or else on the PATH. Returns
+ *          the exit status for failing to.
+ */
+static int run_program(const char* self, const char* program, char* args[])
+{
+    fflush(stdout);
+    const char* slash = strrchr(self, '/');
+    if (slash == NULL)
+    {
+        execvp(program, args);
+        printf("Error: cannot run %s\n", program);
+        return 1;
+    }
+
+    int dirLength = (int) (slash - self) + 1;
+    char* path = malloc(dirLength + strlen(program) + 1);
+    if (path == NULL)
+    {
+        printf("Error: cannot run %s\n", program);
+        return 1;
+    }
+    sprintf(path, "%.*s%s", dirLength, self, program);
+    execv(path, args);
+    printf("Error: cannot run %s\n", path);
+    free(path);
+    return 1;
+}
+
+/**
+ * NAME: usage
+ * INPUT: const char* prog
+ * OUTPUT: int
+ * USAGE: prints the usage message and returns the exit status for it.
+ */
+static int usage(const char* prog)
+{
+    printf("Usage: %s gen ROWS COLS FILE [native|decimal]\n"
+           "       %s print FILE\n"
+           "       %s convert IN OUT native|decimal\n"
+           "       %s mult ALG A B C [native|decimal]\n"
+           "       %s auto ALG A B C\n"
+           "       %s ooc ALG A B C [TILE]\n"
+           "       %s pow A K C [native|decimal]\n"
+           "       %s chain C A1 A2 [A3 ...]\n"
+           "       %s bool A B C [or|gf2|count]\n"
+           "       %s closure A C\n"
+           "       %s semiring RING ALG A B C\n"
+           "       %s narrow A B C [int8|int16] [native|decimal]\n"
+           "       %s pool A B C\n"
+           "       %s import TEXT FILE [native|decimal]\n"
+           "       %s export FILE TEXT [csv|tsv]\n"
+           "ALG is regular, winograd, strassen, recursive, morton, planes, rect or sparse.\n",
+           prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog, prog,
+           prog, prog);
+    return 2;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+        return usage(argv[0]);
+    gen_set_seed(time(NULL));
+
+    MATFILE_ELEM type;
+    if (strcmp(argv[1], "gen") == 0 && argc >= 5)
+    {
+        if (!parse_elem(argc > 5 ? argv[5] : NULL, &type))
+            return 2;
+        MATRIX* m = malloc(sizeof(MATRIX));
+        initialize_matrix(atoi(argv[2]), atoi(argv[3]), m);
+        bool ok = matfile_write(argv[4], m, type);
+        free_matrix(m);
+        return ok ? 0 : 1;
+    }
+
+    if (strcmp(argv[1], "print") == 0)
+    {
+        MATFILE f;
+        MATRIX* m = malloc(sizeof(MATRIX));
+        if (!matfile_open(argv[2], false, &f, m))
+            return 1;
+        print_matrix(m);
+        matfile_close(&f, m);
+        return 0;
+    }
+
+    if (strcmp(argv[1], "convert") == 0 && argc >= 5)
+    {
+        if (!parse_elem(argv[4], &type))
+            return 2;
+        MATFILE f;
+        MATRIX* m = malloc(sizeof(MATRIX));
+        if (!matfile_open(argv[2], false, &f, m))
+            return 1;
+        bool ok = matfile_write(argv[3], m, type);
+        matfile_close(&f, m);
+        return ok ? 0 : 1;
+    }
+
+    if (strcmp(argv[1], "mult") == 0 && argc >= 6)
+    {
+        OOC_MULT mult = parse_alg(argv[2]);
+        if (mult == NULL || !parse_elem(argc > 6 ? argv[6] : NULL, &type))
+            return usage(argv[0]);
+
+        MATFILE f1, f2;
+        MATRIX* m1 = malloc(sizeof(MATRIX));
+        MATRIX* m2 = malloc(sizeof(MATRIX));
+        if (!matfile_open(argv[3], false, &f1, m1) ||
+            !matfile_open(argv[4], false, &f2, m2))
+            return 1;
+        if (m1->numCols != m2->numRows)
+        {
+            printf("Error: Matrices cannot be multiplied\n");
+            return 1;
+        }
+
+        // Calculate time while multiplying.
+        struct rusage before, after;
+        MATRIX* m3 = malloc(sizeof(MATRIX));
+        getrusage(RUSAGE_SELF, &before);
+        mult(m1, m2, m3);
+        getrusage(RUSAGE_SELF, &after);
+        printf("Time Spent (in sec): %f\n", calculate(&before, &after));
+        verify_from_env(m1, m2, m3);
+
+        bool ok = matfile_write(argv[5], m3, type);
+        matfile_close(&f1, m1);
+        matfile_close(&f2, m2);
+        free_matrix(m3);
+        return ok ? 0 : 1;
+    }
+
+    if (strcmp(argv[1], "auto") == 0 && argc >= 6)
+    {
+        if (parse_alg(argv[2]) == NULL)
+            return usage(argv[0]);
+        MATFILE f1, f2;
+        MATRIX* m1 = malloc(sizeof(MATRIX));
+        MATRIX* m2 = malloc(sizeof(MATRIX));
+        if (!matfile_open(argv[3], false, &f1, m1) ||
+            !matfile_open(argv[4], false, &f2, m2))
+            return 1;
+        if (m1->numCols != m2->numRows)
+        {
+            printf("Error: Matrices cannot be multiplied\n");
+            return 1;
+        }
+
+        double bound;
+        double maxA = matrix_max_abs(m1);
+        double maxB = matrix_max_abs(m2);
+        mult_bound(argv[2], m1->numRows, m1->numCols, m2->numCols, maxA, maxB, &bound);
+        const EXACT_TYPE* exact = exact_type_for(argv[2], bound, (maxA > maxB) ? maxA : maxB);
+        if (exact == NULL)
+        {
+            printf("Error: values up to %.3g do not fit any exact type\n", bound);
+            return 1;
+        }
+        if (exact->narrow != NULL)
+            printf("Values up to %.3g: %s, from %s entries\n", bound, exact->name, exact->narrow);
+        else
+            printf("Values up to %.3g: %s\n", bound, exact->name);
+
+        // Native files hold one type's values; decimal ones any type's.
+        MATFILE* files[2] = {&f1, &f2};
+        for (int i = 0; i < 2; i++)
+        {
+            MATFILE_HEADER* h = &files[i]->header;
+            if (h->elemType == MATFILE_NATIVE &&
+                strncmp(h->bignumType, exact->name, sizeof(h->bignumType)) != 0)
+            {
+                printf("Error: %s holds native %s values; convert it to decimal\n",
+                       argv[3 + i], h->bignumType);
+                return 1;
+            }
+        }
+        matfile_close(&f1, m1);
+        matfile_close(&f2, m2);
+
+        // The classical product of small entries is narrow's.
+        char* args[] = {(char*) exact->program, "mult", argv[2], argv[3], argv[4],
+                        argv[5], "decimal", NULL};
+        char* narrowArgs[] = {(char*) exact->program, "narrow", argv[3], argv[4],
+                              argv[5], (char*) exact->narrow, "decimal", NULL};
+        return run_program(argv[0], exact->program,
+                           (exact->narrow != NULL) ? narrowArgs : args);
+    }
+
+    if (strcmp(argv[1], "pow") == 0 && argc >= 5)
+    {
+        if (!parse_elem(argc > 5 ? argv[5] : NULL, &type))
+            return 2;
+        MATFILE f;
+        MATRIX* m = malloc(sizeof(MATRIX));
+        if (!matfile_open(argv[2], false, &f, m))
+            return 1;
+        if (m->numRows != m->numCols || atoi(argv[3]) < 0)
+        {
+            printf("Error: %s is not square or %s is negative\n", argv[2], argv[3]);
+            return 1;
+        }
+
+        // Calculate time while raising to the power.
+        struct rusage before, after;
+        MATRIX* p = malloc(sizeof(MATRIX));
+        getrusage(RUSAGE_SELF, &before);
+        matrix_pow(m, atoi(argv[3]), p);
+        getrusage(RUSAGE_SELF, &after);
+        printf("Time Spent (in sec): %f\n", calculate(&before, &after));
+
+        // A^k is checked as the chain A A ... A, one pass of r per factor.
+        if (verify_rounds() > 0)
+        {
+            int k = atoi(argv[3]);
+            MATRIX** factors = malloc((k + 1) * sizeof(MATRIX*));
+            for (int i = 0; i < k; i++)
+                factors[i] = m;
+            verify_chain_from_env(factors, k, p);
+            free(factors);
+        }
+
+        bool ok = matfile_write(argv[4], p, type);
+        matfile_close(&f, m);
+        free_matrix(p);
+        return ok ? 0 : 1;
+    }
+
+    if (strcmp(argv[1], "chain") == 0 && argc >= 5)
+    {
+        int count = argc - 3;
+        MATFILE* files = malloc(count * sizeof(MATFILE));
+        MATRIX** ms = malloc(count * sizeof(MATRIX*));
+        for (int i = 0; i < count; i++)
+        {
+            ms[i] = malloc(sizeof(MATRIX));
+            if (!matfile_open(argv[3 + i], false, &files[i], ms[i]))
+                return 1;
+        }
+
+        CHAIN_PLAN plan;
+        if (!chain_plan(ms, count, &plan))
+            return 1;
+        chain_print(&plan);
+
+        // Calculate time while multiplying.
+        struct rusage before, after;
+        MATRIX* res = malloc(sizeof(MATRIX));
+        getrusage(RUSAGE_SELF, &before);
+        chain_execute(ms, &plan, res);
+        getrusage(RUSAGE_SELF, &after);
+        printf("Time Spent (in sec): %f\n", calculate(&before, &after));
+        verify_chain_from_env(ms, count, res);
+
+        bool ok = matfile_write(argv[2], res, MATFILE_NATIVE);
+        chain_free(&plan);
+        for (int i = 0; i < count; i++)
+            matfile_close(&files[i], ms[i]);
+        free(files);
+        free(ms);
+        free_matrix(res);
+        return ok ? 0 : 1;
+    }
+
+    if (strcmp(argv[1], "bool") == 0 && argc >= 5)
+    {
+        const char* ring = (argc > 5) ? argv[5] : "or";
+        if (strcmp(ring, "or") != 0 && strcmp(ring, "gf2") != 0 && strcmp(ring, "count") != 0)
+            return usage(argv[0]);
+
+        MATFILE f1, f2;
+        MATRIX* m1 = malloc(sizeof(MATRIX));
+        MATRIX* m2 = malloc(sizeof(MATRIX));
+        if (!matfile_open(argv[2], false, &f1, m1) ||
+            !matfile_open(argv[3], false, &f2, m2))
+            return 1;
+        BOOLMAT a, b, c;
+        boolmat_from_matrix(m1, &a);
+        boolmat_from_matrix(m2, &b);
+        matfile_close(&f1, m1);
+        matfile_close(&f2, m2);
+
+        // Calculate time while multiplying.
+        struct rusage before, after;
+        MATRIX* m3 = malloc(sizeof(MATRIX));
+        bool count = strcmp(ring, "count") == 0;
+        bool ok;
+        getrusage(RUSAGE_SELF, &before);
+        if (count)
+            ok = boolmat_count(&a, &b, m3);
+        else
+            ok = boolmat_mult(&a, &b, &c, strcmp(ring, "gf2") == 0 ? BOOL_GF2 : BOOL_OR);
+        getrusage(RUSAGE_SELF, &after);
+        if (ok && !count)
+        {
+            boolmat_to_matrix(&c, m3);
+            boolmat_free(&c);
+        }
+        boolmat_free(&a);
+        boolmat_free(&b);
+        if (!ok)
+            return 1;
+        printf("Time Spent (in sec): %f\n", calculate(&before, &after));
+
+        ok = matfile_write(argv[4], m3, MATFILE_NATIVE);
+        free_matrix(m3);
+        return ok ? 0 : 1;
+    }
+
+    if (strcmp(argv[1], "closure") == 0 && argc >= 4)
+    {
+        MATFILE f;
+        MATRIX* m = malloc(sizeof(MATRIX));
+        if (!matfile_open(argv[2], false, &f, m))
+            return 1;
+        if (m->numRows != m->numCols)
+        {
+            printf("Error: %s is not square\n", argv[2]);
+            return 1;
+        }
+        BOOLMAT a, c;
+        boolmat_from_matrix(m, &a);
+        matfile_close(&f, m);
+
+        // Calculate time while closing.
+        struct rusage before, after;
+        getrusage(RUSAGE_SELF, &before);
+        bool closed = boolmat_closure(&a, &c);
+        getrusage(RUSAGE_SELF, &after);
+        if (!closed)
+        {
+            boolmat_free(&a);
+            return 1;
+        }
+        printf("Time Spent (in sec): %f\n", calculate(&before, &after));
+
+        MATRIX* res = malloc(sizeof(MATRIX));
+        boolmat_to_matrix(&c, res);
+        bool ok = matfile_write(argv[3], res, MATFILE_NATIVE);
+        boolmat_free(&a);
+        boolmat_free(&c);
+        free_matrix(res);
+        return ok ? 0 : 1;
+    }
+
+    if (strcmp(argv[1], "semiring") == 0 && argc >= 7)
+    {
+        SEMIRING ring;
+        if (!semiring_parse(argv[2], &ring))
+            return usage(argv[0]);
+
+        MATFILE f1, f2;
+        MATRIX* m1 = malloc(sizeof(MATRIX));
+        MATRIX* m2 = malloc(sizeof(MATRIX));
+        if (!matfile_open(argv[4], false, &f1, m1) ||
+            !matfile_open(argv[5], false, &f2, m2))
+            return 1;
+
+        // Calculate time while multiplying.
+        struct rusage before, after;
+        MATRIX* m3 = malloc(sizeof(MATRIX));
+        getrusage(RUSAGE_SELF, &before);
+        bool ok = semiring_mult(argv[3], ring, m1, m2, m3);
+        getrusage(RUSAGE_SELF, &after);
+        matfile_close(&f1, m1);
+        matfile_close(&f2, m2);
+        if (!ok)
+            return 1;
+        printf("Time Spent (in sec): %f\n", calculate(&before, &after));
+
+        ok = matfile_write(argv[6], m3, MATFILE_NATIVE);
+        free_matrix(m3);
+        return ok ? 0 : 1;
+    }
+
+    if (strcmp(argv[1], "narrow") == 0 && argc >= 5)
+    {
+        const char* name = (argc > 5) ? argv[5] : NULL;
+        if (name != NULL && strcmp(name, "int8") != 0 && strcmp(name, "int16") != 0)
+            return usage(argv[0]);
+        if (!parse_elem(argc > 6 ? argv[6] : NULL, &type))
+            return 2;
+
+        MATFILE f1, f2;
+        MATRIX* m1 = malloc(sizeof(MATRIX));
+        MATRIX* m2 = malloc(sizeof(MATRIX));
+        if (!matfile_open(argv[2], false, &f1, m1) ||
+            !matfile_open(argv[3], false, &f2, m2))
+            return 1;
+
+        // Try int8 first unless a type was named.
+        NARROWMAT a, b;
+        NARROW_TYPE narrowType = (name == NULL || strcmp(name, "int8") == 0) ? NARROW_INT8 : NARROW_INT16;
+        bool fits = false;
+        while (!fits)
+        {
+            fits = narrow_from_matrix(m1, narrowType, &a);
+            if (fits && !narrow_from_matrix(m2, narrowType, &b))
+            {
+                narrow_free(&a);
+                fits = false;
+            }
+            if (fits || name != NULL || narrowType == NARROW_INT16)
+                break;
+            narrowType = NARROW_INT16;
+        }
+        if (!fits)
+        {
+            printf("Error: entries do not fit in %s\n", narrow_type_name(narrowType));
+            return 1;
+        }
+        printf("%s entries, %s accumulators\n", narrow_type_name(narrowType),
+               narrow_accumulator(&a, &b) == NARROW_ACC32 ? "int32" : "int64");
+
+        // Calculate time while multiplying.
+        struct rusage before, after;
+        MATRIX* m3 = malloc(sizeof(MATRIX));
+        getrusage(RUSAGE_SELF, &before);
+        bool ok = narrow_mult(&a, &b, m3);
+        getrusage(RUSAGE_SELF, &after);
+        narrow_free(&a);
+        narrow_free(&b);
+        if (!ok)
+            return 1;
+        printf("Time Spent (in sec): %f\n", calculate(&before, &after));
+        verify_from_env(m1, m2, m3);
+        matfile_close(&f1, m1);
+        matfile_close(&f2, m2);
+
+        ok = matfile_write(argv[4], m3, type);
+        free_matrix(m3);
+        return ok ? 0 : 1;
+    }
+
+    if (strcmp(argv[1], "pool") == 0 && argc >= 5)
+    {
+        MATFILE f1, f2;
+        MATRIX* m1 = malloc(sizeof(MATRIX));
+        MATRIX* m2 = malloc(sizeof(MATRIX));
+        if (!matfile_open(argv[2], false, &f1, m1) ||
+            !matfile_open(argv[3], false, &f2, m2))
+            return 1;
+        POOLMAT a, b, c;
+        bool ok = poolmat_from_matrix(m1, &a);
+        if (ok && !poolmat_from_matrix(m2, &b))
+        {
+            poolmat_free(&a);
+            ok = false;
+        }
+        size_t cells = (size_t) m1->numRows * m1->numCols + (size_t) m2->numRows * m2->numCols;
+        if (!ok)
+            return 1;
+        printf("Operands: %.1f MB pooled, %.1f MB as BIGNUMs\n",
+               (poolmat_bytes(&a) + poolmat_bytes(&b)) / 1048576.0,
+               cells * sizeof(BIGNUM) / 1048576.0);
+
+        // Calculate time while multiplying.
+        struct rusage before, after;
+        getrusage(RUSAGE_SELF, &before);
+        ok = poolmat_mult(&a, &b, &c);
+        getrusage(RUSAGE_SELF, &after);
+        poolmat_free(&a);
+        poolmat_free(&b);
+        if (!ok)
+            return 1;
+        printf("Time Spent (in sec): %f\n", calculate(&before, &after));
+        printf("Product: %.1f MB pooled\n", poolmat_bytes(&c) / 1048576.0);
+
+        // The product is only unpacked to be written.
+        MATRIX* m3 = malloc(sizeof(MATRIX));
+        poolmat_to_matrix(&c, m3);
+        poolmat_free(&c);
+        verify_from_env(m1, m2, m3);
+        matfile_close(&f1, m1);
+        matfile_close(&f2, m2);
+        ok = matfile_write(argv[4], m3, MATFILE_NATIVE);
+        free_matrix(m3);
+        return ok ? 0 : 1;
+    }
+
+    if (strcmp(argv[1], "import") == 0 && argc >= 4)
+    {
+        if (!parse_elem(argc > 4 ? argv[4] : NULL, &type))
+            return 2;
+        MATRIX* m = malloc(sizeof(MATRIX));
+        if (!textio_read_matrix(argv[2], m))
+            return 1;
+        bool ok = matfile_write(argv[3], m, type);
+        free_matrix(m);
+        return ok ? 0 : 1;
+    }
+
+    if (strcmp(argv[1], "export") == 0 && argc >= 4)
+    {
+        TEXT_FORMAT format = TEXT_CSV;
+        if (argc > 4 && strcmp(argv[4], "tsv") == 0)
+            format = TEXT_TSV;
+        else if (argc > 4 && strcmp(argv[4], "csv") != 0)
+            return usage(argv[0]);
+
+        MATFILE f;
+        MATRIX* m = malloc(sizeof(MATRIX));
+        if (!matfile_open(argv[2], false, &f, m))
+            return 1;
+        FILE* out = fopen(argv[3], "w");
+        bool ok = out != NULL && textio_write_matrix(out, m, format);
+        if (out == NULL || fclose(out) != 0 || !ok)
+        {
+            printf("Error: failed writing %s\n", argv[3]);
+            ok = false;
+        }
+        matfile_close(&f, m);
+        return ok ? 0 : 1;
+    }
+
+    if (strcmp(argv[1], "ooc") == 0 && argc >= 6)
+    {
+        OOC_MULT mult = parse_alg(argv[2]);
+        if (mult == NULL)
+            return usage(argv[0]);
+
+        // Calculate time for the whole multiplication, I/O included.
+        OOC_STATS stats;
+        struct rusage before, after;
+        getrusage(RUSAGE_SELF, &before);
+        bool ok = ooc_mult(argv[3], argv[4], argv[5], (argc > 6) ? atoi(argv[6]) : 0,
+                           mult, &stats);
+        getrusage(RUSAGE_SELF, &after);
+        if (!ok)
+            return 1;
+
+        printf("Time Spent (in sec): %f\n", calculate(&before, &after));
+        printf("Tile size: %d, steps: %lld\n", stats.tile, stats.steps);
+        printf("Read: %.1f MB, reused: %.1f MB, written: %.1f MB\n",
+               stats.bytesRead / 1048576.0, stats.bytesReused / 1048576.0,
+               stats.bytesWritten / 1048576.0);
+        printf("Waiting for I/O (in sec): %f\n", stats.stallTime);
+
+        // The operands were never loaded whole; map all three to check.
+        if (verify_rounds() > 0)
+        {
+            MATFILE f1, f2, f3;
+            MATRIX* m1 = malloc(sizeof(MATRIX));
+            MATRIX* m2 = malloc(sizeof(MATRIX));
+            MATRIX* m3 = malloc(sizeof(MATRIX));
+            if (!matfile_open(argv[3], false, &f1, m1) ||
+                !matfile_open(argv[4], false, &f2, m2) ||
+                !matfile_open(argv[5], false, &f3, m3))
+                return 1;
+            verify_from_env(m1, m2, m3);
+            matfile_close(&f1, m1);
+            matfile_close(&f2, m2);
+            matfile_close(&f3, m3);
+        }
+        return 0;
+    }
+
+    return usage(argv[0]);
+}
@@ -0,0 +1,134 @@
+/*************************************************************************
+ * memtrack.c
+ *
+ * Implements the matrix memory accounting. Allocation sites call
+ * memtrack_alloc/memtrack_release with the byte counts they pass to
+ * malloc/free; the recursive algorithms describe where they are with a
+ * small stack of (depth, phase) contexts.
+ ************************************************************************/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include "memtrack.h"
+
+static const char* phaseNames[MEM_NUM_PHASES] =
+    {"top", "split", "products", "combine"};
+
+static size_t live = 0;
+static size_t peak = 0;
+static size_t allocated = 0;
+
+// peak live bytes seen while each (depth, phase) was innermost
+static size_t peaks[MEMTRACK_MAX_DEPTH][MEM_NUM_PHASES];
+
+// context stack; entry 0 is the top level
+static int depths[MEMTRACK_MAX_DEPTH + 1];
+static MEM_PHASE stackPhases[MEMTRACK_MAX_DEPTH + 1];
+static int top = 0;
+
+/**
+ * NAME: memtrack_alloc
+ * INPUT: size_t bytes
+ * USAGE: records that bytes were allocated in the current context.
+ */
+void memtrack_alloc(size_t bytes)
+{
+    live += bytes;
+    allocated += bytes;
+    if (live > peak)
+        peak = live;
+
+    int depth = depths[top];
+    if (depth >= MEMTRACK_MAX_DEPTH)
+        depth = MEMTRACK_MAX_DEPTH - 1;
+    if (live > peaks[depth][stackPhases[top]])
+        peaks[depth][stackPhases[top]] = live;
+}
+
+/**
+ * NAME: memtrack_release
+ * INPUT: size_t bytes
+ * USAGE: records that bytes were freed.
+ */
+void memtrack_release(size_t bytes)
+{
+    live -= bytes;
+}
+
+/**
+ * NAME: memtrack_push
+ * INPUT: int depth, MEM_PHASE phase
+ * USAGE: enters a recursion level; allocations are attributed to it
+ *          until the matching memtrack_pop.
+ */
+void memtrack_push(int depth, MEM_PHASE phase)
+{
+    // Levels past the stack share its last slot.
+    if (top < MEMTRACK_MAX_DEPTH)
+        top++;
+    depths[top] = depth;
+    stackPhases[top] = phase;
+}
+
+/**
+ * NAME: memtrack_phase
+ * INPUT: MEM_PHASE phase
+ * USAGE: changes the phase of the innermost level.
+ */
+void memtrack_phase(MEM_PHASE phase)
+{
+    stackPhases[top] = phase;
+}
+
+/**
+ * NAME: memtrack_pop
+ * USAGE: leaves the innermost recursion level.
+ */
+void memtrack_pop(void)
+{
+    if (top > 0)
+        top--;
+}
+
+/**
+ * NAME: memtrack_report
+ * USAGE: if MEMTRACK is set, prints live and peak bytes, the peak per
+ *          depth and phase, and the peak RSS reported by the OS.
+ */
+void memtrack_report(void)
+{
+    const char* env = getenv("MEMTRACK");
+    if (env == NULL || env[0] == '\0' || strcmp(env, "0") == 0)
+        return;
+
+    printf("\nMatrix memory: %zu bytes live, %zu bytes peak, %zu bytes allocated in total\n",
+           live, peak, allocated);
+
+    printf("%-6s", "Depth");
+    for (int p = 0; p < MEM_NUM_PHASES; p++)
+        printf(" %14s", phaseNames[p]);
+    printf("\n");
+    for (int d = 0; d < MEMTRACK_MAX_DEPTH; d++)
+    {
+        // Skip levels the algorithm never reached.
+        bool used = false;
+        for (int p = 0; p < MEM_NUM_PHASES; p++)
+            used = used || peaks[d][p] > 0;
+        if (!used)
+            continue;
+
+        printf("%-6d", d);
+        for (int p = 0; p < MEM_NUM_PHASES; p++)
+            printf(" %14zu", peaks[d][p]);
+        printf("\n");
+    }
+
+    // ru_maxrss is in kilobytes on Linux.
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("Peak RSS (OS): %ld KB\n", usage.ru_maxrss);
+}
@@ -0,0 +1,72 @@
+/****************************************************************************
+ * memtrack.h
+ *
+ * Computer Science 51
+ * Memory Tracking
+ *
+ * Counts live and peak bytes of matrix storage, broken down by Strassen
+ * recursion depth and phase. The report is printed when MEMTRACK is set
+ * in the environment.
+ ***************************************************************************/
+#ifndef _MEMTRACK_H
+#define _MEMTRACK_H
+
+#include <stddef.h>
+
+// deepest recursion level the report breaks down
+#define MEMTRACK_MAX_DEPTH 32
+
+// phases allocations are attributed to
+typedef enum
+{
+    MEM_TOP,        // outside any recursion (inputs, padding, results)
+    MEM_SPLIT,      // quadrants and temporaries of a Strassen node
+    MEM_PRODUCTS,   // operand sums and the 7 recursive products
+    MEM_COMBINE,    // assembling the result quadrants
+    MEM_NUM_PHASES
+}
+MEM_PHASE;
+
+/**
+ * NAME: memtrack_alloc
+ * INPUT: size_t bytes
+ * USAGE: records that bytes were allocated in the current context.
+ */
+void memtrack_alloc(size_t bytes);
+
+/**
+ * NAME: memtrack_release
+ * INPUT: size_t bytes
+ * USAGE: records that bytes were freed.
+ */
+void memtrack_release(size_t bytes);
+
+/**
+ * NAME: memtrack_push
+ * INPUT: int depth, MEM_PHASE phase
+ * USAGE: enters a recursion level; allocations are attributed to it
+ *          until the matching memtrack_pop.
+ */
+void memtrack_push(int depth, MEM_PHASE phase);
+
+/**
+ * NAME: memtrack_phase
+ * INPUT: MEM_PHASE phase
+ * USAGE: changes the phase of the innermost level.
+ */
+void memtrack_phase(MEM_PHASE phase);
+
+/**
+ * NAME: memtrack_pop
+ * USAGE: leaves the innermost recursion level.
+ */
+void memtrack_pop(void);
+
+/**
+ * NAME: memtrack_report
+ * USAGE: if MEMTRACK is set, prints live and peak bytes, the peak per
+ *          depth and phase, and the peak RSS reported by the OS.
+ */
+void memtrack_report(void);
+
+#endif
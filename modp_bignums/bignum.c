@@ -0,0 +1,326 @@
+/****************************************************************************
+ * bignum.c
+ *
+ * Computer Science 51
+ * Bignum Functions
+ *
+ * GF(p) elements with lazy reduction (see bignum.h). Barrett's method
+ * is used rather than Montgomery's because it keeps values in their
+ * usual form, so conversions, comparisons and files need no change of
+ * representation; with p below 2^32 it costs one 64 by 64 bit high
+ * multiply, one low multiply and at most two subtractions. Larger p,
+ * up to 2^62, have products of up to 124 bits, which are reduced the
+ * same way with 128-bit arithmetic.
+ ***************************************************************************/
+
+#include "bignum.h"
+
+// modulus used unless BIGNUM_MODULUS or bignum_set_modulus picks another
+#define DEFAULT_MODULUS 2147483647ULL
+
+// the modulus p; floor(2^64 / p), Barrett's reciprocal; and the largest
+// p * 2^k below 2^63, the multiple of p that values are kept below
+// between reductions
+static unsigned long long modulus = DEFAULT_MODULUS;
+static unsigned long long reciprocal = ~0ULL / DEFAULT_MODULUS;
+static unsigned long long lazyBound = DEFAULT_MODULUS << 32;
+
+// the bits of p, and floor(2^(2 * bits) / p), the reciprocal for
+// products of residues, which only need it once p passes 2^32
+static int bits = 31;
+static unsigned long long wideReciprocal = (1ULL << 62) / DEFAULT_MODULUS;
+
+// bignum_type_name, which includes the modulus
+static char typeName[24] = "mod2147483647";
+
+/**
+ * Returns x mod p, for any 64 bit x.
+ */
+static inline unsigned long long reduce(unsigned long long x)
+{
+    // q is floor(x / p) or up to 2 less.
+    unsigned long long q = (unsigned long long) (((unsigned __int128) x * reciprocal) >> 64);
+    unsigned long long r = x - q * modulus;
+    while (r >= modulus)
+        r -= modulus;
+    return r;
+}
+
+/**
+ * Returns x mod p, for any x below 2^(2 * bits), e.g. a product of
+ * two residues.
+ */
+static inline unsigned long long reduce_wide(unsigned __int128 x)
+{
+    // x >> (bits - 1) and wideReciprocal are below 2^(bits + 1), so
+    // their product fits, and q is floor(x / p) or up to 2 less.
+    unsigned long long top = (unsigned long long) (x >> (bits - 1));
+    unsigned long long q = (unsigned long long) (((unsigned __int128) top * wideReciprocal) >> (bits + 1));
+    unsigned long long r = (unsigned long long) (x - (unsigned __int128) q * modulus);
+    while (r >= modulus)
+        r -= modulus;
+    return r;
+}
+
+/**
+ * Returns a * b mod n.
+ */
+static unsigned long long mult_mod(unsigned long long a, unsigned long long b, unsigned long long n)
+{
+    return (unsigned long long) ((unsigned __int128) a * b % n);
+}
+
+/**
+ * Returns whether p is a prime, by Miller and Rabin's test with the
+ * primes up to 37 as bases, which is exact for every p below 2^64.
+ */
+static bool is_prime(long long p)
+{
+    static const int bases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+    int count = sizeof(bases) / sizeof(bases[0]);
+    if (p < 2)
+        return false;
+    unsigned long long n = p;
+    for (int i = 0; i < count; i++)
+    {
+        if (n % bases[i] == 0)
+            return n == (unsigned long long) bases[i];
+    }
+
+    // n - 1 = d * 2^s with d odd
+    unsigned long long d = n - 1;
+    int s = 0;
+    for (; d % 2 == 0; d /= 2)
+        s++;
+
+    for (int i = 0; i < count; i++)
+    {
+        // x = bases[i]^d mod n, by repeated squaring
+        unsigned long long x = 1;
+        unsigned long long a = bases[i];
+        for (unsigned long long e = d; e > 0; e >>= 1)
+        {
+            if (e & 1)
+                x = mult_mod(x, a, n);
+            a = mult_mod(a, a, n);
+        }
+
+        // n is composite unless x is 1 or squaring it reaches n - 1
+        // within s - 1 steps.
+        bool passes = (x == 1 || x == n - 1);
+        for (int k = 1; k < s && !passes; k++)
+        {
+            x = mult_mod(x, x, n);
+            passes = (x == n - 1);
+        }
+        if (!passes)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Returns the modulus p.
+ */
+long long bignum_modulus(void)
+{
+    return (long long) modulus;
+}
+
+/**
+ * Makes p the modulus of every element from now on. Returns false,
+ * leaving the modulus alone, unless p is a prime below 2^62.
+ */
+bool bignum_set_modulus(long long p)
+{
+    if (p >= (1LL << 62) || !is_prime(p))
+        return false;
+    modulus = p;
+    bits = 64 - __builtin_clzll(modulus);
+    reciprocal = ~0ULL / modulus;
+    wideReciprocal = (unsigned long long) (((unsigned __int128) 1 << (2 * bits)) / modulus);
+    // Below 2^63, so the sum of two values cannot wrap; p * 2^32 for
+    // the default modulus, and at least 2p for any.
+    lazyBound = modulus << (63 - bits);
+    snprintf(typeName, sizeof(typeName), "mod%lld", p);
+    return true;
+}
+
+/**
+ * Picks the modulus named by BIGNUM_MODULUS, if any, before main runs,
+ * so every element of the program is made under it.
+ */
+__attribute__((constructor))
+static void modulus_from_env(void)
+{
+    const char* env = getenv("BIGNUM_MODULUS");
+    if (env != NULL && !bignum_set_modulus(atoll(env)))
+    {
+        fprintf(stderr, "Error: BIGNUM_MODULUS %s is not a prime below 2^62\n", env);
+        exit(1);
+    }
+}
+
+/**
+ * Will add two elements, without reducing mod p.
+ */
+void add_bignums(BIGNUM* b1, BIGNUM* b2, BIGNUM* res) 
+{
+    // Both are below lazyBound < 2^63, so the sum cannot wrap, and
+    // taking lazyBound, a multiple of p, off keeps it congruent.
+    unsigned long long sum = b1->val + b2->val;
+    res->val = (sum >= lazyBound) ? sum - lazyBound : sum;
+}
+
+/**
+ * Will mult two elements mod p. Sets res rather than adding to it.
+ */
+void mult_bignums(BIGNUM* b1, BIGNUM* b2, BIGNUM* res)
+{
+    // Unreduced sums only need reducing first if the product could
+    // pass 64 bits; even residues' can once p passes 2^32.
+    unsigned long long x = b1->val;
+    unsigned long long y = b2->val;
+    if ((x | y) >> 32)
+    {
+        x = reduce(x);
+        y = reduce(y);
+        if (bits > 32)
+        {
+            res->val = reduce_wide((unsigned __int128) x * y);
+            return;
+        }
+    }
+    res->val = reduce(x * y);
+}
+
+/**
+ * Creates the element i mod p.
+ */
+void bignum_from_int(int i, BIGNUM* b)
+{
+    long long r = i % (long long) modulus;
+    if (r < 0)
+        r += (long long) modulus;
+    b->val = (unsigned long long) r;
+}
+
+/**
+ * Will negate an element, without reducing mod p.
+ */
+void negate_bignums(BIGNUM* b)
+{
+    // Negating twice gives back the same value, which subtract_matrices
+    // relies on as it negates its input in place and back.
+    b->val = (b->val != 0) ? lazyBound - b->val : 0;
+}
+
+/**
+ * Returns the element, in [0, p), mod q in the range [0, q).
+ */
+long long bignum_mod(BIGNUM* b, long long q)
+{
+    return (long long) (reduce(b->val) % (unsigned long long) q);
+}
+
+/**
+ * Returns whether b is zero mod p.
+ */
+bool bignum_is_zero(BIGNUM* b)
+{
+    return reduce(b->val) == 0;
+}
+
+/**
+ * Returns a negative, zero or positive value as b1 is below, equal to
+ * or above b2, comparing elements as integers in [0, p).
+ */
+int bignum_compare(BIGNUM* b1, BIGNUM* b2)
+{
+    unsigned long long x = reduce(b1->val);
+    unsigned long long y = reduce(b2->val);
+    return (x > y) - (x < y);
+}
+
+/**
+ * Returns the element, in [0, p), as a double.
+ */
+double bignum_to_double(BIGNUM* b)
+{
+    return (double) reduce(b->val);
+}
+
+/**
+ * Names this bignum implementation, with its modulus.
+ */
+const char* bignum_type_name(void)
+{
+    return typeName;
+}
+
+/**
+ * Writes b in decimal, in [0, p), to buf (not NUL-terminated) and
+ * returns its length, or -1 if size bytes are not enough.
+ */
+int bignum_to_string(BIGNUM* b, char* buf, int size)
+{
+    // Digits are produced backwards, so build them at the end of a
+    // scratch buffer.
+    char digits[20];
+    int start = sizeof(digits);
+    unsigned long long v = reduce(b->val);
+    do
+    {
+        digits[--start] = '0' + v % 10;
+        v /= 10;
+    }
+    while (v > 0);
+
+    int len = sizeof(digits) - start;
+    if (len > size)
+        return -1;
+    memcpy(buf, digits + start, len);
+    return len;
+}
+
+/**
+ * Parses len characters at s as a decimal integer, of any length and
+ * sign, into b mod p. Returns false if they are not one.
+ */
+bool bignum_from_string(const char* s, int len, BIGNUM* b)
+{
+    bool neg = false;
+    int i = 0;
+    if (len > 0 && (s[0] == '-' || s[0] == '+'))
+    {
+        neg = (s[0] == '-');
+        i++;
+    }
+    if (i == len)
+        return false;
+
+    // Horner's rule mod p; the partial value stays below p, so ten
+    // times it passes 64 bits only if p passes 2^32.
+    unsigned long long v = 0;
+    for (; i < len; i++)
+    {
+        if (s[i] < '0' || s[i] > '9')
+            return false;
+        if (bits > 32)
+            v = reduce_wide((unsigned __int128) v * 10 + (s[i] - '0'));
+        else
+            v = reduce(v * 10 + (s[i] - '0'));
+    }
+
+    b->val = (neg && v != 0) ? modulus - v : v;
+    return true;
+}
+
+/**
+ * Will print the element to stdout
+ */
+void print_bignum(BIGNUM* b)
+{
+    char buf[20];
+    fwrite(buf, 1, bignum_to_string(b, buf, sizeof(buf)), stdout);
+}
@@ -0,0 +1,119 @@
+/****************************************************************************
+ * bignum.h
+ *
+ * Computer Science 51
+ * Bignum Functions
+ *
+ * Elements of the prime field GF(p) in one word, for exact products
+ * that never grow. p is 2147483647 (2^31 - 1) unless BIGNUM_MODULUS
+ * names another prime below 2^62, or bignum_set_modulus picks one.
+ *
+ * Values are only reduced mod p when they must be: a BIGNUM holds any
+ * value below the largest p * 2^k under 2^63 (p * 2^32 for the default
+ * p) that is congruent to the element, so sums and differences (all of
+ * Strassen's add_matrices and subtract_matrices) cost one add and one
+ * compare. Products reduce with Barrett's method.
+ ***************************************************************************/
+#ifndef _BIGNUM_H
+#define _BIGNUM_H 
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// GF(p) has no order compatible with its arithmetic: bignum_compare
+// orders residues, and sums wrap around mod p. Code that needs ordered
+// values (min-plus and max-plus, see semiring.h) refuses these bignums
+// when this is defined.
+#define BIGNUM_UNORDERED
+
+// Bignum structure 
+typedef struct
+{
+    // some value below p * 2^k < 2^63 congruent to the element
+    unsigned long long val;
+}
+BIGNUM;
+
+/**
+ * Will print the element to stdout, in [0, p).
+ */
+void print_bignum(BIGNUM* b);
+
+/**
+ * Will add two elements, without reducing mod p.
+ */
+void add_bignums(BIGNUM* b1, BIGNUM* b2, BIGNUM* res);
+
+/**
+ * Will mult two elements mod p. Sets res rather than adding to it.
+ */
+void mult_bignums(BIGNUM* b1, BIGNUM* b2, BIGNUM* res);
+
+/**
+ * Creates the element i mod p.
+ */
+void bignum_from_int(int i, BIGNUM* b);
+
+/**
+ * Will negate an element, without reducing mod p.
+ */
+void negate_bignums(BIGNUM* b);
+
+/**
+ * Returns the element, in [0, p), mod q in the range [0, q).
+ */
+long long bignum_mod(BIGNUM* b, long long q);
+
+/**
+ * Returns whether b is zero mod p.
+ */
+bool bignum_is_zero(BIGNUM* b);
+
+/**
+ * Returns a negative, zero or positive value as b1 is below, equal to
+ * or above b2, comparing elements as integers in [0, p).
+ */
+int bignum_compare(BIGNUM* b1, BIGNUM* b2);
+
+/**
+ * Returns the element, in [0, p), as a double.
+ */
+double bignum_to_double(BIGNUM* b);
+
+/**
+ * Names this bignum implementation, with its modulus, so matrix files
+ * of different fields are told apart.
+ */
+const char* bignum_type_name(void);
+
+/**
+ * Writes b in decimal, in [0, p), to buf (not NUL-terminated) and
+ * returns its length, or -1 if size bytes are not enough.
+ */
+int bignum_to_string(BIGNUM* b, char* buf, int size);
+
+/**
+ * Parses len characters at s as a decimal integer, of any length and
+ * sign, into b mod p. Returns false if they are not one.
+ */
+bool bignum_from_string(const char* s, int len, BIGNUM* b);
+
+/**
+ * Returns the modulus p.
+ */
+long long bignum_modulus(void);
+
+/**
+ * Makes p the modulus of every element from now on. Returns false,
+ * leaving the modulus alone, unless p is a prime below 2^62.
+ *
+ * Elements made under the old modulus are meaningless under the new.
+ */
+bool bignum_set_modulus(long long p);
+
+
+
+#endif
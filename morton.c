@@ -0,0 +1,165 @@
+/*************************************************************************
+ * morton.c
+ *
+ * Implements the Morton layout (see morton.h). Conversions copy whole
+ * tile rows at a time, one row of tiles per parallel_for iteration, so
+ * they cost about as much as copying the matrix.
+ ************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "memtrack.h"
+#include "morton.h"
+#include "parallel.h"
+
+/**
+ * NAME: spread_bits
+ * INPUT: unsigned int x
+ * OUTPUT: unsigned long long
+ * USAGE: moves bit b of x to bit 2b.
+ */
+static unsigned long long spread_bits(unsigned int x)
+{
+    unsigned long long v = x;
+    v = (v | (v << 16)) & 0x0000FFFF0000FFFFULL;
+    v = (v | (v << 8)) & 0x00FF00FF00FF00FFULL;
+    v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    v = (v | (v << 2)) & 0x3333333333333333ULL;
+    v = (v | (v << 1)) & 0x5555555555555555ULL;
+    return v;
+}
+
+/**
+ * NAME: tile_offset
+ * INPUT: MORTON* z, int ti, int tj
+ * OUTPUT: size_t
+ * USAGE: offset of the first cell of tile (ti, tj). Row bits are the
+ *          higher of each pair, so the quadrants go 11, 12, 21, 22.
+ */
+static size_t tile_offset(MORTON* z, int ti, int tj)
+{
+    unsigned long long index = (spread_bits(ti) << 1) | spread_bits(tj);
+    return (size_t) index * z->tile * z->tile;
+}
+
+/**
+ * NAME: morton_alloc
+ * INPUT: int size, MORTON* z
+ * USAGE: allocates z as a size by size Morton matrix, size a power of 2.
+ *          Entries are left uninitialized.
+ *
+ * NOTES: the storage is counted by memtrack.
+ */
+void morton_alloc(int size, MORTON* z)
+{
+    z->size = size;
+    z->tile = (size < MORTON_TILE) ? size : MORTON_TILE;
+    z->data = malloc((size_t) size * size * sizeof(BIGNUM));
+    memtrack_alloc((size_t) size * size * sizeof(BIGNUM));
+}
+
+// Arguments of the parallel conversions.
+typedef struct
+{
+    MATRIX* m;
+    MORTON* z;
+}
+CONVERT_ARGS;
+
+/**
+ * NAME: pack_tile_rows
+ * INPUT: int begin, int end, void* arg
+ * USAGE: parallel_for body copying rows of tiles [begin, end) of m
+ *          into z, padding with zeros.
+ */
+static void pack_tile_rows(int begin, int end, void* arg)
+{
+    CONVERT_ARGS* args = arg;
+    MORTON* z = args->z;
+    int t = z->tile;
+    for (int ti = begin; ti < end; ti++)
+    {
+        for (int tj = 0; tj < z->size / t; tj++)
+        {
+            BIGNUM* tile = z->data + tile_offset(z, ti, tj);
+            for (int r = 0; r < t; r++)
+            {
+                int i = ti * t + r;
+                int j = tj * t;
+
+                // Copy the part of the row inside m, then pad.
+                int inside = 0;
+                if (i < args->m->numRows && j < args->m->numCols)
+                    inside = (args->m->numCols - j < t) ? args->m->numCols - j : t;
+                if (inside > 0)
+                    memcpy(tile + r * t, args->m->matrix[i] + j, inside * sizeof(BIGNUM));
+                for (int c = inside; c < t; c++)
+                    bignum_from_int(0, &tile[r * t + c]);
+            }
+        }
+    }
+}
+
+/**
+ * NAME: morton_from_matrix
+ * INPUT: MATRIX* m, int size, MORTON* z
+ * USAGE: allocates z as a size by size Morton matrix holding m, padded
+ *          with zeros. size must be a power of 2 no smaller than m.
+ */
+void morton_from_matrix(MATRIX* m, int size, MORTON* z)
+{
+    morton_alloc(size, z);
+    CONVERT_ARGS args = {m, z};
+    parallel_for(size / z->tile, pack_tile_rows, &args);
+}
+
+/**
+ * NAME: unpack_tile_rows
+ * INPUT: int begin, int end, void* arg
+ * USAGE: parallel_for body copying the parts of rows of tiles
+ *          [begin, end) of z that lie inside m into m.
+ */
+static void unpack_tile_rows(int begin, int end, void* arg)
+{
+    CONVERT_ARGS* args = arg;
+    MORTON* z = args->z;
+    int t = z->tile;
+    for (int ti = begin; ti < end; ti++)
+    {
+        for (int tj = 0; tj * t < args->m->numCols; tj++)
+        {
+            BIGNUM* tile = z->data + tile_offset(z, ti, tj);
+            int j = tj * t;
+            int inside = (args->m->numCols - j < t) ? args->m->numCols - j : t;
+            for (int r = 0; r < t && ti * t + r < args->m->numRows; r++)
+                memcpy(args->m->matrix[ti * t + r] + j, tile + r * t, inside * sizeof(BIGNUM));
+        }
+    }
+}
+
+/**
+ * NAME: morton_to_matrix
+ * INPUT: MORTON* z, int rowSize, int colSize, MATRIX* m
+ * USAGE: initializes m to the top-left rowSize by colSize block of z.
+ *
+ * NOTES: assumes m is malloced.
+ */
+void morton_to_matrix(MORTON* z, int rowSize, int colSize, MATRIX* m)
+{
+    alloc_matrix(rowSize, colSize, m);
+    CONVERT_ARGS args = {m, z};
+    parallel_for((rowSize + z->tile - 1) / z->tile, unpack_tile_rows, &args);
+}
+
+/**
+ * NAME: morton_free
+ * INPUT: MORTON* z
+ * USAGE: frees the storage of z.
+ */
+void morton_free(MORTON* z)
+{
+    free(z->data);
+    memtrack_release((size_t) z->size * z->size * sizeof(BIGNUM));
+    z->data = NULL;
+}
@@ -0,0 +1,67 @@
+/****************************************************************************
+ * morton.h
+ *
+ * Computer Science 51
+ * Morton (Z-order) Matrix Layout
+ *
+ * A size by size matrix (size a power of 2) stored as one array of
+ * tile by tile row-major tiles, with the tiles in Z-order: the four
+ * quadrants of the matrix come one after another, each quadrant's own
+ * quadrants likewise, down to single tiles. Every quadrant at every
+ * level is therefore one contiguous run, and the quadrant (qi, qj) of a
+ * block of side s starts (2 * qi + qj) * (s / 2)^2 cells into it.
+ * Recursive algorithms can then walk quadrants with plain pointer
+ * arithmetic and stream through them.
+ ***************************************************************************/
+#ifndef _MORTON_H
+#define _MORTON_H
+
+#include "matrix.h"
+
+// side of the row-major tiles at the bottom of the Z-order
+#define MORTON_TILE 8
+
+// A matrix in Morton layout.
+typedef struct
+{
+    BIGNUM* data;
+    int size;
+    int tile;
+}
+MORTON;
+
+/**
+ * NAME: morton_alloc
+ * INPUT: int size, MORTON* z
+ * USAGE: allocates z as a size by size Morton matrix, size a power of 2.
+ *          Entries are left uninitialized.
+ *
+ * NOTES: the storage is counted by memtrack.
+ */
+void morton_alloc(int size, MORTON* z);
+
+/**
+ * NAME: morton_from_matrix
+ * INPUT: MATRIX* m, int size, MORTON* z
+ * USAGE: allocates z as a size by size Morton matrix holding m, padded
+ *          with zeros. size must be a power of 2 no smaller than m.
+ */
+void morton_from_matrix(MATRIX* m, int size, MORTON* z);
+
+/**
+ * NAME: morton_to_matrix
+ * INPUT: MORTON* z, int rowSize, int colSize, MATRIX* m
+ * USAGE: initializes m to the top-left rowSize by colSize block of z.
+ *
+ * NOTES: assumes m is malloced.
+ */
+void morton_to_matrix(MORTON* z, int rowSize, int colSize, MATRIX* m);
+
+/**
+ * NAME: morton_free
+ * INPUT: MORTON* z
+ * USAGE: frees the storage of z.
+ */
+void morton_free(MORTON* z);
+
+#endif
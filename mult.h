@@ -0,0 +1,111 @@
+/****************************************************************************
+ * mult.h
+ *
+ * Computer Science 51
+ * Multiplication Algorithms
+ *
+ * Entry points of the multiplication algorithms, for programs that link
+ * them as a library. Each algorithm file also has its own main(), which
+ * is left out when it is compiled with -DNO_MAIN (the *.lib.o objects).
+ ***************************************************************************/
+#ifndef _MULT_H
+#define _MULT_H
+
+#include "matrix.h"
+
+/**
+ * NAME: regular_mult
+ * INPUT: MATRIX* m1, MATRIX* m2, MATRIX* res
+ * USAGE: Multiplies m1 and m2 naively and stores the result in res.
+ *
+ * NOTES: pointers for m1, m2, m3 must all be malloced before using this function.
+ */
+void regular_mult(MATRIX* m1, MATRIX* m2, MATRIX* res);
+
+/**
+ * NAME: winograd_mult
+ * INPUT: MATRIX* m1, MATRIX* m2, MATRIX* res
+ * USAGE: Multiplies m1 and m2 using winograd's algorithm and stores
+ *           the result in res
+ *
+ * NOTES: m1, m2, m3 must all be malloced before using this function.
+ */
+void winograd_mult(MATRIX* m1, MATRIX* m2, MATRIX* res);
+
+/**
+ * NAME: strassen_mult
+ * INPUT: MATRIX* mOrig1, MATRIX* mOrig2, MATRIX* res
+ * USAGE: Multiplies mOrig1 and mOrig2 using Strassen's algorithm and
+ *           stores the result in res.
+ *
+ * NOTES: mOrig1, mOrig2, res must all be malloced before using this function.
+ */
+void strassen_mult(MATRIX* mOrig1, MATRIX* mOrig2, MATRIX* res);
+
+/**
+ * NAME: recursive_mult
+ * INPUT: MATRIX* m1, MATRIX* m2, MATRIX* res
+ * USAGE: Multiplies m1 and m2 with the cache-oblivious recursive
+ *          algorithm and stores the result in res.
+ *
+ * NOTES: m1, m2, res must all be malloced before using this function.
+ */
+void recursive_mult(MATRIX* m1, MATRIX* m2, MATRIX* res);
+
+/**
+ * NAME: strassen_morton_mult
+ * INPUT: MATRIX* mOrig1, MATRIX* mOrig2, MATRIX* res
+ * USAGE: Multiplies mOrig1 and mOrig2 using Strassen's algorithm on
+ *           Morton layout copies and stores the result in res.
+ *           strassen_mult does this when STRASSEN_LAYOUT=morton.
+ *
+ * NOTES: mOrig1, mOrig2, res must all be malloced before using this function.
+ */
+void strassen_morton_mult(MATRIX* mOrig1, MATRIX* mOrig2, MATRIX* res);
+
+/**
+ * NAME: strassen_planes_mult
+ * INPUT: MATRIX* mOrig1, MATRIX* mOrig2, MATRIX* res
+ * USAGE: Multiplies mOrig1 and mOrig2 using Strassen's algorithm on
+ *           Morton layout copies held in digit planes (see planes.h),
+ *           so its sums are vectorized, and stores the result in res.
+ *           strassen_mult does this when STRASSEN_LAYOUT=planes. Other
+ *           bignum types use strassen_morton_mult.
+ *
+ * NOTES: mOrig1, mOrig2, res must all be malloced before using this function.
+ */
+void strassen_planes_mult(MATRIX* mOrig1, MATRIX* mOrig2, MATRIX* res);
+
+/**
+ * NAME: matrix_pow
+ * INPUT: MATRIX* m, int k, MATRIX* res
+ * USAGE: Raises the square matrix m to the power k >= 0 by repeated
+ *           squaring with Strassen's algorithm and stores the result
+ *           in res. Padding and the workspace are shared by all the
+ *           products.
+ *
+ * NOTES: m and res must be malloced before using this function.
+ */
+void matrix_pow(MATRIX* m, int k, MATRIX* res);
+
+/**
+ * NAME: rect_mult
+ * INPUT: MATRIX* m1, MATRIX* m2, MATRIX* res
+ * USAGE: Multiplies m1 and m2 with Strassen's algorithm padded level by
+ *          level (see rectmult.c) and stores the result in res.
+ *
+ * NOTES: m1, m2, res must all be malloced before using this function.
+ */
+void rect_mult(MATRIX* m1, MATRIX* m2, MATRIX* res);
+
+/**
+ * NAME: rect_bound
+ * INPUT: int rowSize, int innerSize, int colSize, double maxA, double maxB
+ * OUTPUT: double
+ * USAGE: a bound on the magnitude of every value rect_mult forms, the
+ *          partial sums included, for entries of m1 at most maxA and of
+ *          m2 at most maxB in magnitude.
+ */
+double rect_bound(int rowSize, int innerSize, int colSize, double maxA, double maxB);
+
+#endif
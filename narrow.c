@@ -0,0 +1,318 @@
+/*************************************************************************
+ * narrow.c
+ *
+ * Implements narrow integer matrices (see narrow.h).
+ *
+ * For a product, b is repacked so that the GROUP consecutive entries
+ * of each column that meet one group of GROUP entries of a row of a
+ * are adjacent: GROUP is 2 for int16 and 4 for int8, the pairs and
+ * quads that pmaddwd and VNNI's dot product instructions multiply and
+ * sum in one step. The kernels are plain C over that layout, stamped
+ * out by NARROW_ROWS once per entry and accumulator type, and
+ * leave the choice of instructions to the compiler. Rows of a are split
+ * over threads with parallel_for, and columns are taken NARROW_COLS at
+ * a time so the packed block of b being reused stays in cache.
+ ************************************************************************/
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memtrack.h"
+#include "narrow.h"
+#include "parallel.h"
+
+// columns of the product computed together
+#define NARROW_COLS 256
+
+/**
+ * NAME: elem_size
+ * INPUT: NARROW_TYPE type
+ * OUTPUT: size_t
+ * USAGE: bytes per entry of the given type.
+ */
+static size_t elem_size(NARROW_TYPE type)
+{
+    return (type == NARROW_INT8) ? sizeof(int8_t) : sizeof(int16_t);
+}
+
+/**
+ * NAME: narrow_type_name
+ * INPUT: NARROW_TYPE type
+ * OUTPUT: const char*
+ * USAGE: "int8" or "int16".
+ */
+const char* narrow_type_name(NARROW_TYPE type)
+{
+    return (type == NARROW_INT8) ? "int8" : "int16";
+}
+
+// Arguments of the parallel conversion.
+typedef struct
+{
+    MATRIX* m;
+    NARROWMAT* n;
+    int* rowMax;
+}
+CONVERT_ARGS;
+
+/**
+ * NAME: convert_rows
+ * INPUT: int begin, int end, void* arg
+ * USAGE: parallel_for body narrowing rows [begin, end) of m, storing
+ *          each row's largest magnitude in rowMax, or -1 if an entry of
+ *          the row does not fit.
+ */
+static void convert_rows(int begin, int end, void* arg)
+{
+    CONVERT_ARGS* args = arg;
+    NARROWMAT* n = args->n;
+    long long limit = (n->type == NARROW_INT8) ? 128 : 32768;
+    for (int i = begin; i < end; i++)
+    {
+        int rowMax = 0;
+        for (int j = 0; j < n->numCols; j++)
+        {
+            // The value, or else its negation (GF(p) elements compare as
+            // values in [0, p), so -x is p - x), must be its own residue
+            // mod 2 * limit, taken into [-limit, limit).
+            BIGNUM b = args->m->matrix[i][j];
+            int value = 0;
+            bool fits = false;
+            for (int sign = 1; sign >= -1 && !fits; sign -= 2)
+            {
+                long long r = bignum_mod(&b, 2 * limit);
+                value = (int) ((r >= limit) ? r - 2 * limit : r);
+                BIGNUM check;
+                bignum_from_int(value, &check);
+                fits = bignum_compare(&b, &check) == 0 && value * sign < limit;
+                value *= sign;
+                negate_bignums(&b);
+            }
+            if (!fits)
+            {
+                rowMax = -1;
+                break;
+            }
+
+            if (n->type == NARROW_INT8)
+                ((int8_t*) n->data)[(size_t) i * n->stride + j] = (int8_t) value;
+            else
+                ((int16_t*) n->data)[(size_t) i * n->stride + j] = (int16_t) value;
+            if (abs(value) > rowMax)
+                rowMax = abs(value);
+        }
+        args->rowMax[i] = rowMax;
+    }
+}
+
+/**
+ * NAME: narrow_from_matrix
+ * INPUT: MATRIX* m, NARROW_TYPE type, NARROWMAT* n
+ * OUTPUT: bool
+ * USAGE: allocates n holding m with entries of the given type. Returns
+ *          false, allocating nothing, if an entry of m does not fit.
+ *
+ * NOTES: the storage is counted by memtrack.
+ */
+bool narrow_from_matrix(MATRIX* m, NARROW_TYPE type, NARROWMAT* n)
+{
+    n->type = type;
+    n->stride = (m->numCols + 3) / 4 * 4;
+    n->numRows = m->numRows;
+    n->numCols = m->numCols;
+    n->maxAbs = 0;
+    size_t bytes = (size_t) m->numRows * n->stride * elem_size(type);
+    n->data = calloc(1, bytes > 0 ? bytes : 1);
+
+    int* rowMax = malloc((m->numRows > 0 ? m->numRows : 1) * sizeof(int));
+    CONVERT_ARGS args = {m, n, rowMax};
+    parallel_for(m->numRows, convert_rows, &args);
+
+    bool ok = true;
+    for (int i = 0; i < m->numRows; i++)
+    {
+        if (rowMax[i] < 0)
+            ok = false;
+        else if (rowMax[i] > n->maxAbs)
+            n->maxAbs = rowMax[i];
+    }
+    free(rowMax);
+
+    if (!ok)
+    {
+        free(n->data);
+        n->data = NULL;
+        return false;
+    }
+    memtrack_alloc(bytes);
+    return true;
+}
+
+/**
+ * NAME: narrow_accumulator
+ * INPUT: NARROWMAT* a, NARROWMAT* b
+ * OUTPUT: NARROW_ACC
+ * USAGE: the narrowest accumulator that cannot overflow in a * b: no
+ *          entry of the product or of its partial sums exceeds
+ *          a->maxAbs * b->maxAbs * a->numCols in magnitude.
+ */
+NARROW_ACC narrow_accumulator(NARROWMAT* a, NARROWMAT* b)
+{
+    // At most 2^15 * 2^15 * 2^31, so this cannot overflow, and int64
+    // always suffices.
+    long long bound = (long long) a->maxAbs * b->maxAbs * a->numCols;
+    return (bound <= INT_MAX) ? NARROW_ACC32 : NARROW_ACC64;
+}
+
+/**
+ * NAME: bignum_from_acc
+ * INPUT: long long v, BIGNUM* b
+ * USAGE: b = v, for any accumulated value.
+ */
+static void bignum_from_acc(long long v, BIGNUM* b)
+{
+    if (v >= INT_MIN && v <= INT_MAX)
+    {
+        bignum_from_int((int) v, b);
+        return;
+    }
+    char buf[24];
+    int len = snprintf(buf, sizeof(buf), "%lld", v);
+    bignum_from_string(buf, len, b);
+}
+
+// Arguments of the parallel products.
+typedef struct
+{
+    NARROWMAT* a;
+    void* packed;
+    MATRIX* res;
+}
+MULT_ARGS;
+
+// Defines NAME_pack, which repacks b, of entries ELEM taken GROUP at a
+// time, so that entry (k, j) is at
+// ((k / GROUP) * numCols + j) * GROUP + k % GROUP.
+#define NARROW_PACK(NAME, ELEM, GROUP) \
+    static void NAME##_pack(NARROWMAT* b, int groups, ELEM* packed) \
+    { \
+        ELEM* data = b->data; \
+        for (int kg = 0; kg < groups; kg++) \
+        { \
+            for (int j = 0; j < b->numCols; j++) \
+            { \
+                for (int g = 0; g < GROUP; g++) \
+                { \
+                    int k = kg * GROUP + g; \
+                    packed[((size_t) kg * b->numCols + j) * GROUP + g] = \
+                        (k < b->numRows) ? data[(size_t) k * b->stride + j] : 0; \
+                } \
+            } \
+        } \
+    }
+
+// Defines NAME_rows, a parallel_for body computing rows [begin, end) of
+// the product into res, for entries ELEM taken GROUP at a time and
+// accumulators ACC.
+#define NARROW_ROWS(NAME, ELEM, ACC, GROUP) \
+    static void NAME##_rows(int begin, int end, void* arg) \
+    { \
+        MULT_ARGS* args = arg; \
+        int groups = args->a->stride / GROUP; \
+        int cols = args->res->numCols; \
+        ACC* acc = malloc(NARROW_COLS * sizeof(ACC)); \
+        for (int i = begin; i < end; i++) \
+        { \
+            ELEM* row = (ELEM*) args->a->data + (size_t) i * args->a->stride; \
+            for (int j0 = 0; j0 < cols; j0 += NARROW_COLS) \
+            { \
+                int width = (cols - j0 < NARROW_COLS) ? cols - j0 : NARROW_COLS; \
+                for (int j = 0; j < width; j++) \
+                    acc[j] = 0; \
+                for (int kg = 0; kg < groups; kg++) \
+                { \
+                    ELEM* x = row + kg * GROUP; \
+                    bool zero = true; \
+                    for (int g = 0; g < GROUP; g++) \
+                        zero = zero && x[g] == 0; \
+                    if (zero) \
+                        continue; \
+                    ELEM* y = (ELEM*) args->packed + ((size_t) kg * cols + j0) * GROUP; \
+                    for (int j = 0; j < width; j++) \
+                    { \
+                        ACC sum = 0; \
+                        for (int g = 0; g < GROUP; g++) \
+                            sum += (ACC) x[g] * y[j * GROUP + g]; \
+                        acc[j] += sum; \
+                    } \
+                } \
+                for (int j = 0; j < width; j++) \
+                    bignum_from_acc(acc[j], &args->res->matrix[i][j0 + j]); \
+            } \
+        } \
+        free(acc); \
+    }
+
+NARROW_PACK(int8, int8_t, 4)
+NARROW_PACK(int16, int16_t, 2)
+NARROW_ROWS(int8_acc32, int8_t, int32_t, 4)
+NARROW_ROWS(int8_acc64, int8_t, int64_t, 4)
+NARROW_ROWS(int16_acc32, int16_t, int32_t, 2)
+NARROW_ROWS(int16_acc64, int16_t, int64_t, 2)
+
+/**
+ * NAME: narrow_mult
+ * INPUT: NARROWMAT* a, NARROWMAT* b, MATRIX* res
+ * OUTPUT: bool
+ * USAGE: initializes res to the exact product of a and b, accumulating
+ *          as narrow_accumulator picks. Returns false if they cannot be
+ *          multiplied or their entries are of different types.
+ *
+ * NOTES: assumes res is malloced.
+ */
+bool narrow_mult(NARROWMAT* a, NARROWMAT* b, MATRIX* res)
+{
+    if (a->numCols != b->numRows || a->type != b->type)
+    {
+        printf("Error: Matrices cannot be multiplied");
+        return false;
+    }
+
+    int group = (a->type == NARROW_INT8) ? 4 : 2;
+    int groups = a->stride / group;
+    size_t bytes = (size_t) groups * group * b->numCols * elem_size(b->type);
+    void* packed = malloc(bytes > 0 ? bytes : 1);
+    memtrack_alloc(bytes);
+
+    alloc_matrix(a->numRows, b->numCols, res);
+    MULT_ARGS args = {a, packed, res};
+    bool wide = narrow_accumulator(a, b) == NARROW_ACC64;
+    if (a->type == NARROW_INT8)
+    {
+        int8_pack(b, groups, packed);
+        parallel_for(a->numRows, wide ? int8_acc64_rows : int8_acc32_rows, &args);
+    }
+    else
+    {
+        int16_pack(b, groups, packed);
+        parallel_for(a->numRows, wide ? int16_acc64_rows : int16_acc32_rows, &args);
+    }
+
+    free(packed);
+    memtrack_release(bytes);
+    return true;
+}
+
+/**
+ * NAME: narrow_free
+ * INPUT: NARROWMAT* n
+ * USAGE: frees the storage of n.
+ */
+void narrow_free(NARROWMAT* n)
+{
+    memtrack_release((size_t) n->numRows * n->stride * elem_size(n->type));
+    free(n->data);
+    n->data = NULL;
+}
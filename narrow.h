@@ -0,0 +1,100 @@
+/****************************************************************************
+ * narrow.h
+ *
+ * Computer Science 51
+ * Narrow Integer Matrices
+ *
+ * Matrices of small integers stored as int8 or int16, for operands
+ * whose values are small (initialize_matrix's are all below 10000).
+ * Such a matrix takes 1 or 2 bytes per entry instead of 8 for a long
+ * long or 408 for a BIGNUM, so many more entries share each cache line
+ * and each vector operation. Products widen into int32 accumulators
+ * when the entries' magnitudes prove that int32 cannot overflow for
+ * the inner dimension, and into int64 otherwise.
+ ***************************************************************************/
+#ifndef _NARROW_H
+#define _NARROW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "matrix.h"
+
+// entries of a narrow matrix
+typedef enum
+{
+    NARROW_INT8,    // -128 to 127
+    NARROW_INT16    // -32768 to 32767
+}
+NARROW_TYPE;
+
+// accumulators of a narrow product
+typedef enum
+{
+    NARROW_ACC32,
+    NARROW_ACC64
+}
+NARROW_ACC;
+
+// A narrow matrix. Rows are stride entries apart, stride being numCols
+// rounded up to a multiple of 4, and the entries past numCols are zero.
+typedef struct
+{
+    void* data;
+    NARROW_TYPE type;
+    int stride;
+    int numRows;
+    int numCols;
+    int maxAbs;     // largest magnitude of an entry
+}
+NARROWMAT;
+
+/**
+ * NAME: narrow_type_name
+ * INPUT: NARROW_TYPE type
+ * OUTPUT: const char*
+ * USAGE: "int8" or "int16".
+ */
+const char* narrow_type_name(NARROW_TYPE type);
+
+/**
+ * NAME: narrow_from_matrix
+ * INPUT: MATRIX* m, NARROW_TYPE type, NARROWMAT* n
+ * OUTPUT: bool
+ * USAGE: allocates n holding m with entries of the given type. Returns
+ *          false, allocating nothing, if an entry of m does not fit.
+ *
+ * NOTES: the storage is counted by memtrack.
+ */
+bool narrow_from_matrix(MATRIX* m, NARROW_TYPE type, NARROWMAT* n);
+
+/**
+ * NAME: narrow_accumulator
+ * INPUT: NARROWMAT* a, NARROWMAT* b
+ * OUTPUT: NARROW_ACC
+ * USAGE: the narrowest accumulator that cannot overflow in a * b: no
+ *          entry of the product or of its partial sums exceeds
+ *          a->maxAbs * b->maxAbs * a->numCols in magnitude.
+ */
+NARROW_ACC narrow_accumulator(NARROWMAT* a, NARROWMAT* b);
+
+/**
+ * NAME: narrow_mult
+ * INPUT: NARROWMAT* a, NARROWMAT* b, MATRIX* res
+ * OUTPUT: bool
+ * USAGE: initializes res to the exact product of a and b, accumulating
+ *          as narrow_accumulator picks. Returns false if they cannot be
+ *          multiplied or their entries are of different types.
+ *
+ * NOTES: assumes res is malloced.
+ */
+bool narrow_mult(NARROWMAT* a, NARROWMAT* b, MATRIX* res);
+
+/**
+ * NAME: narrow_free
+ * INPUT: NARROWMAT* n
+ * USAGE: frees the storage of n.
+ */
+void narrow_free(NARROWMAT* n);
+
+#endif
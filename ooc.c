@@ -0,0 +1,499 @@
+/*************************************************************************
+ * ooc.c
+ *
+ * Implements out-of-core multiplication (see ooc.h).
+ *
+ * C tiles are visited row of tiles by row of tiles, and both the column
+ * order and the order of the tiles summed into each C tile snake back
+ * and forth. Consecutive steps therefore always share one input tile:
+ * moving along a row of C keeps the last A tile, moving down keeps the
+ * last B tile, and that tile is copied instead of read again. Tiles are
+ * read with pread into one of two slots by a prefetch thread, so the
+ * disk works on step s + 1 while step s is multiplied.
+ ************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "matfile.h"
+#include "ooc.h"
+
+// working set of a step, in tiles: two slots of A and B tiles, the C
+// tile, the product and room for the algorithm's own temporaries
+#define OOC_TILES 10
+
+// Tiles of one step, filled by the prefetch thread.
+typedef struct
+{
+    MATRIX* a;
+    MATRIX* b;
+    bool full;
+}
+SLOT;
+
+// State shared by the multiplying and prefetch threads.
+typedef struct
+{
+    int fdA, fdB;
+    MATFILE_HEADER hA, hB;
+    int rowSize, innerSize, colSize;
+    int tile;
+    int rowTiles, innerTiles, colTiles;
+    long long steps;
+
+    SLOT slots[2];
+    bool error;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+
+    long long bytesRead;
+    long long bytesReused;
+}
+OOC;
+
+/**
+ * NAME: tiles_needed
+ * INPUT: int size, int tile
+ * OUTPUT: int
+ * USAGE: number of tiles covering size.
+ */
+static int tiles_needed(int size, int tile)
+{
+    return (size + tile - 1) / tile;
+}
+
+/**
+ * NAME: ooc_tile_size
+ * INPUT: int rowSize, int innerSize, int colSize
+ * OUTPUT: int
+ * USAGE: picks a power of 2 tile size whose working set fits in
+ *          OOC_MEMORY megabytes (default 256), no larger than the
+ *          matrices need.
+ */
+int ooc_tile_size(int rowSize, int innerSize, int colSize)
+{
+    const char* env = getenv("OOC_MEMORY");
+    double budget = ((env != NULL) ? atof(env) : 256) * 1024 * 1024;
+
+    int largest = rowSize;
+    if (innerSize > largest)
+        largest = innerSize;
+    if (colSize > largest)
+        largest = colSize;
+
+    int tile = 1;
+    while (tile < largest &&
+           (double) OOC_TILES * (2 * tile) * (2 * tile) * sizeof(BIGNUM) <= budget)
+        tile *= 2;
+    return tile;
+}
+
+/**
+ * NAME: step_tiles
+ * INPUT: OOC* o, long long s, int* i, int* j, int* k, int* kPos
+ * USAGE: finds the tiles of step s: C tile (i, j) gets A tile (i, k)
+ *          times B tile (k, j), and kPos counts the steps of this C
+ *          tile so far.
+ */
+static void step_tiles(OOC* o, long long s, int* i, int* j, int* k, int* kPos)
+{
+    long long cIndex = s / o->innerTiles;
+    *kPos = (int) (s % o->innerTiles);
+    *i = (int) (cIndex / o->colTiles);
+    int jPos = (int) (cIndex % o->colTiles);
+
+    // Snake across C and along k so neighbouring steps share a tile.
+    *j = (*i % 2 == 0) ? jPos : o->colTiles - 1 - jPos;
+    *k = (cIndex % 2 == 0) ? *kPos : o->innerTiles - 1 - *kPos;
+}
+
+/**
+ * NAME: set_tile
+ * INPUT: MATRIX* t, int tile, int index, int size, bool rows
+ * USAGE: sets the rows (or columns) of t to the part of tile number
+ *          index that lies within size.
+ */
+static void set_tile(MATRIX* t, int tile, int index, int size, bool rows)
+{
+    int extent = size - index * tile;
+    if (extent > tile)
+        extent = tile;
+    if (rows)
+        t->numRows = extent;
+    else
+        t->numCols = extent;
+}
+
+/**
+ * NAME: read_tile
+ * INPUT: int fd, MATFILE_HEADER* h, int row, int col, MATRIX* t
+ * OUTPUT: bool
+ * USAGE: reads the t->numRows by t->numCols block of the file starting
+ *          at (row, col) into t.
+ */
+static bool read_tile(int fd, MATFILE_HEADER* h, int row, int col, MATRIX* t)
+{
+    size_t bytes = t->numCols * sizeof(BIGNUM);
+    for (int r = 0; r < t->numRows; r++)
+    {
+        off_t offset = h->payloadOffset + (off_t) (row + r) * h->stride +
+                       (off_t) col * sizeof(BIGNUM);
+        if (pread(fd, t->matrix[r], bytes, offset) != (ssize_t) bytes)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * NAME: write_tile
+ * INPUT: int fd, MATFILE_HEADER* h, int row, int col, MATRIX* t
+ * OUTPUT: bool
+ * USAGE: writes t to the file as the block starting at (row, col).
+ */
+static bool write_tile(int fd, MATFILE_HEADER* h, int row, int col, MATRIX* t)
+{
+    size_t bytes = t->numCols * sizeof(BIGNUM);
+    for (int r = 0; r < t->numRows; r++)
+    {
+        off_t offset = h->payloadOffset + (off_t) (row + r) * h->stride +
+                       (off_t) col * sizeof(BIGNUM);
+        if (pwrite(fd, t->matrix[r], bytes, offset) != (ssize_t) bytes)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * NAME: copy_tile
+ * INPUT: MATRIX* from, MATRIX* to
+ * USAGE: copies the tile from into to, dimensions included.
+ */
+static void copy_tile(MATRIX* from, MATRIX* to)
+{
+    to->numRows = from->numRows;
+    to->numCols = from->numCols;
+    for (int r = 0; r < from->numRows; r++)
+        memcpy(to->matrix[r], from->matrix[r], from->numCols * sizeof(BIGNUM));
+}
+
+/**
+ * NAME: fill_slot
+ * INPUT: OOC* o, long long s
+ * OUTPUT: bool
+ * USAGE: loads the A and B tiles of step s into its slot, reusing a tile
+ *          the previous step already loaded.
+ */
+static bool fill_slot(OOC* o, long long s)
+{
+    SLOT* slot = &o->slots[s % 2];
+    SLOT* prev = &o->slots[(s + 1) % 2];
+    int i, j, k, kPos;
+    step_tiles(o, s, &i, &j, &k, &kPos);
+
+    int pi = -1, pj = -1, pk = -1, pkPos;
+    if (s > 0)
+        step_tiles(o, s - 1, &pi, &pj, &pk, &pkPos);
+
+    set_tile(slot->a, o->tile, i, o->rowSize, true);
+    set_tile(slot->a, o->tile, k, o->innerSize, false);
+    set_tile(slot->b, o->tile, k, o->innerSize, true);
+    set_tile(slot->b, o->tile, j, o->colSize, false);
+    long long bytesA = (long long) slot->a->numRows * slot->a->numCols * sizeof(BIGNUM);
+    long long bytesB = (long long) slot->b->numRows * slot->b->numCols * sizeof(BIGNUM);
+
+    // The previous step's slot is only being read, so copying from it
+    // is safe while it is multiplied.
+    if (pi == i && pk == k)
+    {
+        copy_tile(prev->a, slot->a);
+        o->bytesReused += bytesA;
+    }
+    else if (!read_tile(o->fdA, &o->hA, i * o->tile, k * o->tile, slot->a))
+        return false;
+    else
+        o->bytesRead += bytesA;
+
+    if (pk == k && pj == j)
+    {
+        copy_tile(prev->b, slot->b);
+        o->bytesReused += bytesB;
+    }
+    else if (!read_tile(o->fdB, &o->hB, k * o->tile, j * o->tile, slot->b))
+        return false;
+    else
+        o->bytesRead += bytesB;
+    return true;
+}
+
+/**
+ * NAME: prefetch
+ * INPUT: void* arg
+ * OUTPUT: void*
+ * USAGE: prefetch thread: fills slots in step order, waiting for the
+ *          multiplying thread to empty each one first.
+ */
+static void* prefetch(void* arg)
+{
+    OOC* o = arg;
+    for (long long s = 0; s < o->steps; s++)
+    {
+        SLOT* slot = &o->slots[s % 2];
+        pthread_mutex_lock(&o->lock);
+        while (slot->full && !o->error)
+            pthread_cond_wait(&o->changed, &o->lock);
+        bool stop = o->error;
+        pthread_mutex_unlock(&o->lock);
+        if (stop)
+            break;
+
+        bool ok = fill_slot(o, s);
+
+        pthread_mutex_lock(&o->lock);
+        if (ok)
+            slot->full = true;
+        else
+            o->error = true;
+        pthread_cond_broadcast(&o->changed);
+        pthread_mutex_unlock(&o->lock);
+        if (!ok)
+        {
+            printf("Error: failed reading tiles of step %lld\n", s);
+            break;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * NAME: now
+ * OUTPUT: double
+ * USAGE: monotonic time in seconds.
+ */
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/**
+ * NAME: accumulate
+ * INPUT: MATRIX* c, MATRIX* p
+ * USAGE: adds p into c.
+ */
+static void accumulate(MATRIX* c, MATRIX* p)
+{
+    BIGNUM sum;
+    for (int i = 0; i < c->numRows; i++)
+    {
+        for (int j = 0; j < c->numCols; j++)
+        {
+            add_bignums(&c->matrix[i][j], &p->matrix[i][j], &sum);
+            c->matrix[i][j] = sum;
+        }
+    }
+}
+
+/**
+ * NAME: free_tile
+ * INPUT: MATRIX* t, int tile
+ * USAGE: frees a tile whose dimensions may have been shrunk.
+ */
+static void free_tile(MATRIX* t, int tile)
+{
+    t->numRows = tile;
+    t->numCols = tile;
+    free_matrix(t);
+}
+
+/**
+ * NAME: open_input
+ * INPUT: const char* path, MATFILE_HEADER* h
+ * OUTPUT: int
+ * USAGE: opens a native matrix file for tiled reading. Returns the file
+ *          descriptor, or -1.
+ */
+static int open_input(const char* path, MATFILE_HEADER* h)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        printf("Error: cannot open %s\n", path);
+        return -1;
+    }
+    if (!matfile_read_header(fd, path, h))
+    {
+        close(fd);
+        return -1;
+    }
+    if (h->elemType != MATFILE_NATIVE)
+    {
+        printf("Error: %s is not native, convert it first\n", path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * NAME: ooc_mult
+ * INPUT: const char* pathA, const char* pathB, const char* pathC,
+ *          int tile, OOC_MULT mult, OOC_STATS* stats
+ * OUTPUT: bool
+ * USAGE: multiplies the native matrix files at pathA and pathB with
+ *          tile by tile tiles, using mult on each pair, and writes the
+ *          product to pathC as a native file. tile 0 means
+ *          ooc_tile_size. Fills in stats if it is not NULL.
+ *
+ * NOTES: memory use is a few tiles, whatever the size of the files.
+ *          mult must not modify its inputs, which the prefetch thread
+ *          may be copying from.
+ */
+bool ooc_mult(const char* pathA, const char* pathB, const char* pathC,
+              int tile, OOC_MULT mult, OOC_STATS* stats)
+{
+    OOC o;
+    memset(&o, 0, sizeof(o));
+    o.fdA = open_input(pathA, &o.hA);
+    o.fdB = (o.fdA < 0) ? -1 : open_input(pathB, &o.hB);
+    if (o.fdB < 0)
+    {
+        if (o.fdA >= 0)
+            close(o.fdA);
+        return false;
+    }
+    if (o.hA.numCols != o.hB.numRows)
+    {
+        printf("Error: Matrices cannot be multiplied\n");
+        close(o.fdA);
+        close(o.fdB);
+        return false;
+    }
+
+    MATFILE_HEADER hC;
+    int fdC = open(pathC, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fdC < 0 || !matfile_write_header(fdC, (int) o.hA.numRows, (int) o.hB.numCols, &hC))
+    {
+        printf("Error: cannot create %s\n", pathC);
+        if (fdC >= 0)
+            close(fdC);
+        close(o.fdA);
+        close(o.fdB);
+        return false;
+    }
+
+    o.rowSize = (int) o.hA.numRows;
+    o.innerSize = (int) o.hA.numCols;
+    o.colSize = (int) o.hB.numCols;
+    o.tile = (tile > 0) ? tile : ooc_tile_size(o.rowSize, o.innerSize, o.colSize);
+    o.rowTiles = tiles_needed(o.rowSize, o.tile);
+    o.innerTiles = tiles_needed(o.innerSize, o.tile);
+    o.colTiles = tiles_needed(o.colSize, o.tile);
+    o.steps = (long long) o.rowTiles * o.colTiles * o.innerTiles;
+
+    for (int s = 0; s < 2; s++)
+    {
+        o.slots[s].a = malloc(sizeof(MATRIX));
+        o.slots[s].b = malloc(sizeof(MATRIX));
+        alloc_matrix(o.tile, o.tile, o.slots[s].a);
+        alloc_matrix(o.tile, o.tile, o.slots[s].b);
+    }
+    MATRIX* c = malloc(sizeof(MATRIX));
+    alloc_matrix(o.tile, o.tile, c);
+
+    pthread_mutex_init(&o.lock, NULL);
+    pthread_cond_init(&o.changed, NULL);
+    pthread_t reader;
+    pthread_create(&reader, NULL, prefetch, &o);
+
+    double stall = 0.0;
+    long long bytesWritten = 0;
+    for (long long s = 0; s < o.steps; s++)
+    {
+        SLOT* slot = &o.slots[s % 2];
+
+        // Wait for the prefetch thread; time spent here is I/O that
+        // compute did not hide.
+        double waitStart = now();
+        pthread_mutex_lock(&o.lock);
+        while (!slot->full && !o.error)
+            pthread_cond_wait(&o.changed, &o.lock);
+        bool stop = o.error;
+        pthread_mutex_unlock(&o.lock);
+        stall += now() - waitStart;
+        if (stop)
+            break;
+
+        int i, j, k, kPos;
+        step_tiles(&o, s, &i, &j, &k, &kPos);
+
+        // A fresh C tile starts at zero.
+        if (kPos == 0)
+        {
+            set_tile(c, o.tile, i, o.rowSize, true);
+            set_tile(c, o.tile, j, o.colSize, false);
+            for (int r = 0; r < c->numRows; r++)
+                for (int q = 0; q < c->numCols; q++)
+                    bignum_from_int(0, &c->matrix[r][q]);
+        }
+
+        MATRIX* product = malloc(sizeof(MATRIX));
+        mult(slot->a, slot->b, product);
+        accumulate(c, product);
+        free_matrix(product);
+
+        pthread_mutex_lock(&o.lock);
+        slot->full = false;
+        pthread_cond_broadcast(&o.changed);
+        pthread_mutex_unlock(&o.lock);
+
+        // The last step of a C tile writes it out.
+        if (kPos == o.innerTiles - 1)
+        {
+            if (!write_tile(fdC, &hC, i * o.tile, j * o.tile, c))
+            {
+                printf("Error: failed writing %s\n", pathC);
+                pthread_mutex_lock(&o.lock);
+                o.error = true;
+                pthread_cond_broadcast(&o.changed);
+                pthread_mutex_unlock(&o.lock);
+                break;
+            }
+            bytesWritten += (long long) c->numRows * c->numCols * sizeof(BIGNUM);
+        }
+    }
+
+    pthread_join(reader, NULL);
+    pthread_mutex_destroy(&o.lock);
+    pthread_cond_destroy(&o.changed);
+
+    for (int s = 0; s < 2; s++)
+    {
+        free_tile(o.slots[s].a, o.tile);
+        free_tile(o.slots[s].b, o.tile);
+    }
+    free_tile(c, o.tile);
+
+    bool ok = !o.error && fsync(fdC) == 0;
+    close(o.fdA);
+    close(o.fdB);
+    close(fdC);
+
+    if (stats != NULL)
+    {
+        stats->tile = o.tile;
+        stats->steps = o.steps;
+        stats->bytesRead = o.bytesRead;
+        stats->bytesReused = o.bytesReused;
+        stats->bytesWritten = bytesWritten;
+        stats->stallTime = stall;
+    }
+    return ok;
+}
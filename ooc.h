@@ -0,0 +1,63 @@
+/****************************************************************************
+ * ooc.h
+ *
+ * Computer Science 51
+ * Out-of-Core Multiplication
+ *
+ * Multiplies native matrix files (see matfile.h) that do not fit in
+ * memory. C is computed one tile at a time: the tile is held in memory
+ * while the matching tiles of A and B are read from disk, multiplied
+ * with an in-memory algorithm and added in, and then written out. A
+ * prefetch thread reads the next pair of tiles while the current pair
+ * is being multiplied.
+ ***************************************************************************/
+#ifndef _OOC_H
+#define _OOC_H
+
+#include <stdbool.h>
+
+#include "matrix.h"
+
+// in-memory algorithm used on each pair of tiles
+typedef void (*OOC_MULT)(MATRIX* m1, MATRIX* m2, MATRIX* res);
+
+// What an out-of-core multiplication did.
+typedef struct
+{
+    int tile;
+    long long steps;
+    long long bytesRead;
+    long long bytesReused;
+    long long bytesWritten;
+    double stallTime;
+}
+OOC_STATS;
+
+/**
+ * NAME: ooc_tile_size
+ * INPUT: int rowSize, int innerSize, int colSize
+ * OUTPUT: int
+ * USAGE: picks a power of 2 tile size whose working set fits in
+ *          OOC_MEMORY megabytes (default 256), no larger than the
+ *          matrices need.
+ */
+int ooc_tile_size(int rowSize, int innerSize, int colSize);
+
+/**
+ * NAME: ooc_mult
+ * INPUT: const char* pathA, const char* pathB, const char* pathC,
+ *          int tile, OOC_MULT mult, OOC_STATS* stats
+ * OUTPUT: bool
+ * USAGE: multiplies the native matrix files at pathA and pathB with
+ *          tile by tile tiles, using mult on each pair, and writes the
+ *          product to pathC as a native file. tile 0 means
+ *          ooc_tile_size. Fills in stats if it is not NULL.
+ *
+ * NOTES: memory use is a few tiles, whatever the size of the files.
+ *          mult must not modify its inputs, which the prefetch thread
+ *          may be copying from.
+ */
+bool ooc_mult(const char* pathA, const char* pathB, const char* pathC,
+              int tile, OOC_MULT mult, OOC_STATS* stats);
+
+#endif
@@ -0,0 +1,104 @@
+/*************************************************************************
+ * parallel.c
+ *
+ * Implements parallel_for with one pthread per chunk. Threads are
+ * created per call, which is cheap next to the matrix-sized loops this
+ * is used for.
+ ************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "parallel.h"
+
+// most threads parallel_for will start
+#define MAX_THREADS 256
+
+// One chunk of a parallel loop.
+typedef struct
+{
+    int begin;
+    int end;
+    PARALLEL_BODY body;
+    void* arg;
+}
+CHUNK;
+
+/**
+ * NAME: run_chunk
+ * INPUT: void* c
+ * OUTPUT: void*
+ * USAGE: pthread entry point for one chunk.
+ */
+static void* run_chunk(void* c)
+{
+    CHUNK* chunk = c;
+    chunk->body(chunk->begin, chunk->end, chunk->arg);
+    return NULL;
+}
+
+/**
+ * NAME: parallel_threads
+ * OUTPUT: int
+ * USAGE: returns how many threads parallel_for will use.
+ */
+int parallel_threads(void)
+{
+    const char* env = getenv("THREADS");
+    int threads = (env != NULL) ? atoi(env) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1)
+        threads = 1;
+    if (threads > MAX_THREADS)
+        threads = MAX_THREADS;
+    return threads;
+}
+
+/**
+ * NAME: parallel_for
+ * INPUT: int count, PARALLEL_BODY body, void* arg
+ * USAGE: splits iterations [0, count) into one contiguous chunk per
+ *          thread and calls body on each chunk. Returns when all chunks
+ *          are done.
+ *
+ * NOTES: the calling thread runs the first chunk itself.
+ */
+void parallel_for(int count, PARALLEL_BODY body, void* arg)
+{
+    int threads = parallel_threads();
+    if (threads > count)
+        threads = count;
+    if (threads <= 1)
+    {
+        if (count > 0)
+            body(0, count, arg);
+        return;
+    }
+
+    CHUNK chunks[MAX_THREADS];
+    pthread_t ids[MAX_THREADS];
+    for (int t = 0; t < threads; t++)
+    {
+        chunks[t].begin = (int) ((long long) count * t / threads);
+        chunks[t].end = (int) ((long long) count * (t + 1) / threads);
+        chunks[t].body = body;
+        chunks[t].arg = arg;
+    }
+
+    // If a thread cannot be started its chunk runs here instead.
+    bool started[MAX_THREADS];
+    for (int t = 1; t < threads; t++)
+        started[t] = (pthread_create(&ids[t], NULL, run_chunk, &chunks[t]) == 0);
+
+    run_chunk(&chunks[0]);
+    for (int t = 1; t < threads; t++)
+    {
+        if (started[t])
+            pthread_join(ids[t], NULL);
+        else
+            run_chunk(&chunks[t]);
+    }
+}
@@ -0,0 +1,34 @@
+/****************************************************************************
+ * parallel.h
+ *
+ * Computer Science 51
+ * Parallel Loops
+ *
+ * A minimal pthreads parallel-for. The number of threads comes from the
+ * THREADS environment variable and defaults to the number of CPUs.
+ ***************************************************************************/
+#ifndef _PARALLEL_H
+#define _PARALLEL_H
+
+// body of a parallel loop: handles iterations [begin, end)
+typedef void (*PARALLEL_BODY)(int begin, int end, void* arg);
+
+/**
+ * NAME: parallel_threads
+ * OUTPUT: int
+ * USAGE: returns how many threads parallel_for will use.
+ */
+int parallel_threads(void);
+
+/**
+ * NAME: parallel_for
+ * INPUT: int count, PARALLEL_BODY body, void* arg
+ * USAGE: splits iterations [0, count) into one contiguous chunk per
+ *          thread and calls body on each chunk. Returns when all chunks
+ *          are done.
+ *
+ * NOTES: the calling thread runs the first chunk itself.
+ */
+void parallel_for(int count, PARALLEL_BODY body, void* arg);
+
+#endif
@@ -0,0 +1,271 @@
+/*************************************************************************
+ * perfcount.c
+ *
+ * Implements per-phase timing and hardware performance counters using
+ * Linux perf_event_open. Each event is opened as its own counter and
+ * read with read(2) at the start and end of a phase, so phases are
+ * measured exclusively of whatever runs between them.
+ ************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include "perfcount.h"
+
+// Column headers for the report, in counter order.
+static const char* eventNames[PERF_NUM_EVENTS] =
+    {"cycles", "instr", "br-miss", "L1D-miss", "LLC-miss", "dTLB-miss"};
+
+static bool enabled = false;
+static int fds[PERF_NUM_EVENTS];
+static const char* unavailable = NULL;
+static PERF_PHASE* phases = NULL;
+static PERF_PHASE* lastPhase = NULL;
+
+/**
+ * NAME: now
+ * OUTPUT: double
+ * USAGE: monotonic wall clock in seconds.
+ */
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#ifdef __linux__
+/**
+ * NAME: open_event
+ * INPUT: unsigned int type, unsigned long long config
+ * OUTPUT: int
+ * USAGE: opens one user-space counter for this process, returns the fd
+ *          or -1 on failure.
+ */
+static int open_event(unsigned int type, unsigned long long config)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/**
+ * NAME: cache_event
+ * INPUT: int cache, int op, int result
+ * OUTPUT: unsigned long long
+ * USAGE: encodes a PERF_TYPE_HW_CACHE config value.
+ */
+static unsigned long long cache_event(int cache, int op, int result)
+{
+    return cache | (op << 8) | (result << 16);
+}
+#endif
+
+/**
+ * NAME: read_counters
+ * INPUT: long long* values
+ * USAGE: reads every open counter into values, scaling for multiplexing.
+ *          Unopened counters read as -1.
+ */
+static void read_counters(long long* values)
+{
+    for (int i = 0; i < PERF_NUM_EVENTS; i++)
+    {
+        values[i] = -1;
+
+        // value, time enabled, time running
+        unsigned long long buf[3];
+        if (fds[i] < 0 || read(fds[i], buf, sizeof(buf)) != sizeof(buf))
+            continue;
+
+        if (buf[2] > 0 && buf[2] < buf[1])
+            values[i] = (long long) (buf[0] * ((double) buf[1] / buf[2]));
+        else
+            values[i] = (long long) buf[0];
+    }
+}
+
+/**
+ * NAME: perf_init
+ * USAGE: reads PERF_COUNTERS from the environment and, if set, opens
+ *          the hardware counters for this process.
+ *
+ * NOTES: counters that cannot be opened (no permission, no PMU, not
+ *          Linux) are reported as n/a; phase timing still works.
+ */
+void perf_init(void)
+{
+    const char* env = getenv("PERF_COUNTERS");
+    enabled = (env != NULL && env[0] != '\0' && strcmp(env, "0") != 0);
+
+    for (int i = 0; i < PERF_NUM_EVENTS; i++)
+        fds[i] = -1;
+    if (!enabled)
+        return;
+
+#ifdef __linux__
+    fds[0] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    fds[1] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    fds[2] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    fds[3] = open_event(PERF_TYPE_HW_CACHE,
+                        cache_event(PERF_COUNT_HW_CACHE_L1D,
+                                    PERF_COUNT_HW_CACHE_OP_READ,
+                                    PERF_COUNT_HW_CACHE_RESULT_MISS));
+    fds[4] = open_event(PERF_TYPE_HW_CACHE,
+                        cache_event(PERF_COUNT_HW_CACHE_LL,
+                                    PERF_COUNT_HW_CACHE_OP_READ,
+                                    PERF_COUNT_HW_CACHE_RESULT_MISS));
+    fds[5] = open_event(PERF_TYPE_HW_CACHE,
+                        cache_event(PERF_COUNT_HW_CACHE_DTLB,
+                                    PERF_COUNT_HW_CACHE_OP_READ,
+                                    PERF_COUNT_HW_CACHE_RESULT_MISS));
+
+    // If nothing opened, remember why so the report can say so.
+    bool any = false;
+    for (int i = 0; i < PERF_NUM_EVENTS; i++)
+        any = any || fds[i] >= 0;
+    if (!any)
+        unavailable = strerror(errno);
+#else
+    unavailable = "perf_event_open requires Linux";
+#endif
+}
+
+/**
+ * NAME: perf_counting
+ * OUTPUT: bool
+ * USAGE: whether PERF_COUNTERS is set, so phases are being measured.
+ *          A phase's counts are -1 for counters that could not be
+ *          opened.
+ */
+bool perf_counting(void)
+{
+    return enabled;
+}
+
+/**
+ * NAME: perf_begin
+ * INPUT: PERF_PHASE* p
+ * USAGE: starts measuring phase p, or for a sampled phase only every
+ *          kth call of it.
+ *
+ * NOTES: phases must not nest with themselves.
+ */
+void perf_begin(PERF_PHASE* p)
+{
+    if (!enabled)
+        return;
+
+    // Append to the report list the first time the phase is seen.
+    if (!p->registered)
+    {
+        p->registered = true;
+        if (lastPhase == NULL)
+            phases = p;
+        else
+            lastPhase->next = p;
+        lastPhase = p;
+    }
+
+    p->sampled = (p->every <= 1 || p->calls % p->every == 0);
+    if (!p->sampled)
+        return;
+    read_counters(p->start);
+    p->startTime = now();
+}
+
+/**
+ * NAME: perf_end
+ * INPUT: PERF_PHASE* p
+ * USAGE: stops measuring phase p and adds the deltas to its totals.
+ */
+void perf_end(PERF_PHASE* p)
+{
+    if (!enabled)
+        return;
+
+    p->calls++;
+    if (!p->sampled)
+        return;
+    double end = now();
+    long long values[PERF_NUM_EVENTS];
+    read_counters(values);
+
+    p->measured++;
+    p->seconds += end - p->startTime;
+    for (int i = 0; i < PERF_NUM_EVENTS; i++)
+    {
+        if (values[i] < 0 || p->start[i] < 0)
+            p->counts[i] = -1;
+        else if (p->counts[i] >= 0)
+            p->counts[i] += values[i] - p->start[i];
+    }
+}
+
+/**
+ * NAME: perf_report
+ * USAGE: prints a table of every phase used so far to stdout and closes
+ *          the counters.
+ */
+void perf_report(void)
+{
+    if (!enabled)
+        return;
+
+    printf("\n%-24s %10s %12s", "Phase", "Calls", "Seconds");
+    for (int i = 0; i < PERF_NUM_EVENTS; i++)
+        printf(" %14s", eventNames[i]);
+    printf(" %6s\n", "IPC");
+
+    for (PERF_PHASE* p = phases; p != NULL; p = p->next)
+    {
+        // Sampled phases are scaled from the calls measured to all.
+        char label[64];
+        double scale = (p->measured > 0) ? (double) p->calls / p->measured : 0.0;
+        if (p->every > 1)
+            snprintf(label, sizeof(label), "%s (1/%d)", p->name, p->every);
+        else
+            snprintf(label, sizeof(label), "%s", p->name);
+        printf("%-24s %10ld %12.6f", label, p->calls, p->seconds * scale);
+        for (int i = 0; i < PERF_NUM_EVENTS; i++)
+        {
+            if (p->counts[i] < 0 || fds[i] < 0)
+                printf(" %14s", "n/a");
+            else
+                printf(" %14lld", (long long) (p->counts[i] * scale));
+        }
+        if (p->counts[0] > 0 && p->counts[1] >= 0 && fds[0] >= 0 && fds[1] >= 0)
+            printf(" %6.2f\n", (double) p->counts[1] / p->counts[0]);
+        else
+            printf(" %6s\n", "n/a");
+    }
+
+    if (unavailable != NULL)
+        printf("(hardware counters unavailable: %s)\n", unavailable);
+
+    for (int i = 0; i < PERF_NUM_EVENTS; i++)
+    {
+        if (fds[i] >= 0)
+            close(fds[i]);
+        fds[i] = -1;
+    }
+}
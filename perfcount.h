@@ -0,0 +1,94 @@
+/****************************************************************************
+ * perfcount.h
+ *
+ * Computer Science 51
+ * Performance Counters
+ *
+ * Per-phase timing and hardware counters (Linux perf_event_open) for
+ * the multiplication algorithms. Enabled by setting PERF_COUNTERS=1 in
+ * the environment; otherwise every call here is a cheap no-op.
+ ***************************************************************************/
+#ifndef _PERFCOUNT_H
+#define _PERFCOUNT_H
+
+#include <stdbool.h>
+
+// cycles, instructions, branch misses, L1D misses, LLC misses, dTLB misses
+#define PERF_NUM_EVENTS 6
+
+// One instrumented phase of an algorithm. Declare these static and
+// initialize them with PERF_PHASE_INIT("name"), or with
+// PERF_PHASE_SAMPLED("name", k) for phases entered so often, and for so
+// little work each time, that reading the counters on every call would
+// cost more than the phase: those are measured on one call in k and the
+// report scales their totals up to all of the calls.
+typedef struct PERF_PHASE
+{
+    const char* name;
+    int every;
+
+    // calls counts every perf_begin/perf_end pair and measured those
+    // that read the counters; seconds and counts total the measured
+    long calls;
+    long measured;
+    double seconds;
+    long long counts[PERF_NUM_EVENTS];
+
+    // snapshot taken by perf_begin, if this call is measured
+    bool sampled;
+    double startTime;
+    long long start[PERF_NUM_EVENTS];
+
+    // phases link themselves into the report list on first use
+    bool registered;
+    struct PERF_PHASE* next;
+}
+PERF_PHASE;
+
+#define PERF_PHASE_SAMPLED(n, k) { n, k, 0, 0, 0.0, {0}, false, 0.0, {0}, false, NULL }
+#define PERF_PHASE_INIT(n) PERF_PHASE_SAMPLED(n, 1)
+
+/**
+ * NAME: perf_init
+ * USAGE: reads PERF_COUNTERS from the environment and, if set, opens
+ *          the hardware counters for this process.
+ *
+ * NOTES: counters that cannot be opened (no permission, no PMU, not
+ *          Linux) are reported as n/a; phase timing still works.
+ */
+void perf_init(void);
+
+/**
+ * NAME: perf_counting
+ * OUTPUT: bool
+ * USAGE: whether PERF_COUNTERS is set, so phases are being measured.
+ *          A phase's counts are -1 for counters that could not be
+ *          opened.
+ */
+bool perf_counting(void);
+
+/**
+ * NAME: perf_begin
+ * INPUT: PERF_PHASE* p
+ * USAGE: starts measuring phase p, or for a sampled phase only every
+ *          kth call of it.
+ *
+ * NOTES: phases must not nest with themselves.
+ */
+void perf_begin(PERF_PHASE* p);
+
+/**
+ * NAME: perf_end
+ * INPUT: PERF_PHASE* p
+ * USAGE: stops measuring phase p and adds the deltas to its totals.
+ */
+void perf_end(PERF_PHASE* p);
+
+/**
+ * NAME: perf_report
+ * USAGE: prints a table of every phase used so far to stdout and closes
+ *          the counters.
+ */
+void perf_report(void);
+
+#endif
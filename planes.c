@@ -0,0 +1,189 @@
+/*************************************************************************
+ * planes.c
+ *
+ * Implements the digit plane layout (see planes.h). planes_add is the
+ * kernel: its inner loops run over one plane of each operand and the
+ * carries with no dependence from one lane to the next, so they
+ * vectorize; the carries pass from plane to plane through the carry
+ * bytes rather than from digit to digit within a value.
+ ************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "memtrack.h"
+#include "planes.h"
+
+/**
+ * NAME: planes_alloc
+ * INPUT: size_t count, int planes, PLANES* p
+ * USAGE: allocates p for count values of planes digits each. Values
+ *          are left uninitialized.
+ *
+ * NOTES: the storage is counted by memtrack.
+ */
+void planes_alloc(size_t count, int planes, PLANES* p)
+{
+    p->stride = count;
+    p->planes = planes;
+    p->digits = malloc(count * planes);
+    memtrack_alloc(count * planes);
+}
+
+/**
+ * NAME: planes_view
+ * INPUT: PLANES* p, size_t offset
+ * OUTPUT: PLANES
+ * USAGE: the values of p from offset on.
+ */
+PLANES planes_view(PLANES* p, size_t offset)
+{
+    PLANES view = *p;
+    view.digits += offset;
+    return view;
+}
+
+/**
+ * NAME: planes_encode
+ * INPUT: BIGNUM* cells, size_t count, PLANES* p
+ * USAGE: stores count cells as the first count values of p, keeping
+ *          their low p->planes digits.
+ *
+ * NOTES: a negative value is stored as 10^planes minus its magnitude:
+ *          every digit taken from 9, then 1 added.
+ */
+void planes_encode(BIGNUM* cells, size_t count, PLANES* p)
+{
+    for (size_t e = 0; e < count; e++)
+    {
+        BIGNUM* b = &cells[e];
+        int carry = b->neg;
+        for (int k = 0; k < p->planes; k++)
+        {
+            int d = (k <= b->lastIndex) ? b->coeffs[k] : 0;
+            if (b->neg)
+            {
+                d = 9 - d + carry;
+                carry = d / 10;
+                d %= 10;
+            }
+            p->digits[k * p->stride + e] = d;
+        }
+    }
+}
+
+/**
+ * NAME: planes_decode
+ * INPUT: PLANES* p, size_t count, BIGNUM* cells
+ * USAGE: sets count cells to the first count values of p, those with
+ *          a top digit of 5 or more being negative.
+ */
+void planes_decode(PLANES* p, size_t count, BIGNUM* cells)
+{
+    int top = p->planes - 1;
+    for (size_t e = 0; e < count; e++)
+    {
+        BIGNUM* b = &cells[e];
+        bool neg = (p->digits[top * p->stride + e] >= 5);
+        int carry = neg;
+        b->lastIndex = 0;
+        for (int k = 0; k < LIMIT; k++)
+        {
+            int d = 0;
+            if (k < p->planes)
+            {
+                d = p->digits[k * p->stride + e];
+                if (neg)
+                {
+                    d = 9 - d + carry;
+                    carry = d / 10;
+                    d %= 10;
+                }
+            }
+            b->coeffs[k] = d;
+            if (d != 0)
+                b->lastIndex = k;
+        }
+        b->neg = neg;
+    }
+}
+
+/**
+ * NAME: planes_add
+ * INPUT: PLANES* x, PLANES* y, PLANES* out, size_t count, bool subtract,
+ *          unsigned char* carry
+ * USAGE: out = x + y (or x - y) over the first count values, using
+ *          count bytes at carry for the carries. out may be x or y.
+ *
+ * NOTES: x - y is x + (10^planes - 1 - y) + 1: each digit of y taken
+ *          from 9 and a carry of 1 into the lowest plane.
+ */
+void planes_add(PLANES* x, PLANES* y, PLANES* out, size_t count, bool subtract,
+                unsigned char* carry)
+{
+    memset(carry, subtract, count);
+    for (int k = 0; k < out->planes; k++)
+    {
+        unsigned char* xs = x->digits + k * x->stride;
+        unsigned char* ys = y->digits + k * y->stride;
+        unsigned char* os = out->digits + k * out->stride;
+        unsigned char* restrict cs = carry;
+        if (subtract)
+        {
+            for (size_t e = 0; e < count; e++)
+            {
+                unsigned char d = xs[e] + (9 - ys[e]) + cs[e];
+                cs[e] = (d >= 10);
+                os[e] = d - 10 * cs[e];
+            }
+        }
+        else
+        {
+            for (size_t e = 0; e < count; e++)
+            {
+                unsigned char d = xs[e] + ys[e] + cs[e];
+                cs[e] = (d >= 10);
+                os[e] = d - 10 * cs[e];
+            }
+        }
+    }
+}
+
+/**
+ * NAME: planes_copy
+ * INPUT: PLANES* from, PLANES* to, size_t count
+ * USAGE: copies the first count values of from to to.
+ */
+void planes_copy(PLANES* from, PLANES* to, size_t count)
+{
+    for (int k = 0; k < to->planes; k++)
+        memcpy(to->digits + k * to->stride, from->digits + k * from->stride, count);
+}
+
+/**
+ * NAME: planes_matrix_digits
+ * INPUT: MATRIX* m
+ * OUTPUT: int
+ * USAGE: the most digits an entry of m has.
+ */
+int planes_matrix_digits(MATRIX* m)
+{
+    int digits = 1;
+    for (int i = 0; i < m->numRows; i++)
+        for (int j = 0; j < m->numCols; j++)
+            if (m->matrix[i][j].lastIndex + 1 > digits)
+                digits = m->matrix[i][j].lastIndex + 1;
+    return digits;
+}
+
+/**
+ * NAME: planes_free
+ * INPUT: PLANES* p
+ * USAGE: frees the storage of p, which must not be a view.
+ */
+void planes_free(PLANES* p)
+{
+    free(p->digits);
+    memtrack_release(p->stride * p->planes);
+    p->digits = NULL;
+}
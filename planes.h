@@ -0,0 +1,105 @@
+/****************************************************************************
+ * planes.h
+ *
+ * Computer Science 51
+ * Digit Plane Layout
+ *
+ * The bignums keep each value's digits together, so adding two blocks
+ * of them walks each value's digits one after another, carrying as it
+ * goes, and no two values can be added at once. A block in digit
+ * planes stores digit k of every value together instead, plane k being
+ * one contiguous run of bytes. Adding two blocks is then one pass per
+ * plane, adding whole planes lane by lane with a carry per lane, which
+ * the compiler turns into vector instructions adding 16 or 32 digits
+ * at a time. Values are held in ten's complement modulo 10^planes, so
+ * subtraction is the same pass and signs need no special cases.
+ *
+ * Only the bignums have digits to lay out this way (see BIGNUM_DIGITS
+ * in bignum.h).
+ ***************************************************************************/
+#ifndef _PLANES_H
+#define _PLANES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "matrix.h"
+
+// A block of values in digit planes: digit k (least significant first)
+// of value e is digits[k * stride + e]. A view of part of a block keeps
+// its stride and starts at a later value.
+typedef struct
+{
+    unsigned char* digits;
+    size_t stride;
+    int planes;
+}
+PLANES;
+
+/**
+ * NAME: planes_alloc
+ * INPUT: size_t count, int planes, PLANES* p
+ * USAGE: allocates p for count values of planes digits each. Values
+ *          are left uninitialized.
+ *
+ * NOTES: the storage is counted by memtrack.
+ */
+void planes_alloc(size_t count, int planes, PLANES* p);
+
+/**
+ * NAME: planes_view
+ * INPUT: PLANES* p, size_t offset
+ * OUTPUT: PLANES
+ * USAGE: the values of p from offset on.
+ */
+PLANES planes_view(PLANES* p, size_t offset);
+
+/**
+ * NAME: planes_encode
+ * INPUT: BIGNUM* cells, size_t count, PLANES* p
+ * USAGE: stores count cells as the first count values of p, keeping
+ *          their low p->planes digits.
+ */
+void planes_encode(BIGNUM* cells, size_t count, PLANES* p);
+
+/**
+ * NAME: planes_decode
+ * INPUT: PLANES* p, size_t count, BIGNUM* cells
+ * USAGE: sets count cells to the first count values of p, those with
+ *          a top digit of 5 or more being negative.
+ */
+void planes_decode(PLANES* p, size_t count, BIGNUM* cells);
+
+/**
+ * NAME: planes_add
+ * INPUT: PLANES* x, PLANES* y, PLANES* out, size_t count, bool subtract,
+ *          unsigned char* carry
+ * USAGE: out = x + y (or x - y) over the first count values, using
+ *          count bytes at carry for the carries. out may be x or y.
+ */
+void planes_add(PLANES* x, PLANES* y, PLANES* out, size_t count, bool subtract,
+                unsigned char* carry);
+
+/**
+ * NAME: planes_copy
+ * INPUT: PLANES* from, PLANES* to, size_t count
+ * USAGE: copies the first count values of from to to.
+ */
+void planes_copy(PLANES* from, PLANES* to, size_t count);
+
+/**
+ * NAME: planes_matrix_digits
+ * INPUT: MATRIX* m
+ * OUTPUT: int
+ * USAGE: the most digits an entry of m has.
+ */
+int planes_matrix_digits(MATRIX* m);
+
+/**
+ * NAME: planes_free
+ * INPUT: PLANES* p
+ * USAGE: frees the storage of p, which must not be a view.
+ */
+void planes_free(PLANES* p);
+
+#endif
@@ -0,0 +1,525 @@
+/*************************************************************************
+ * poolmat.c
+ *
+ * Implements pooled bignum matrices (see poolmat.h). Entries move in
+ * and out through bignum_to_string and bignum_from_string, which every
+ * bignum type has, so the pool works with all of them; for the bignums
+ * both are linear in the digits. Whole matrices are converted a row
+ * per parallel_for iteration: each row's limbs are gathered on their
+ * own, then copied into the arena at their row's offset.
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parallel.h"
+#include "poolmat.h"
+
+// limbs hold POOL_DIGITS decimal digits each
+#define POOL_DIGITS 9
+
+// values of up to this many digits are held inline
+#define POOL_INLINE_DIGITS 18
+
+// room for the decimal text of any entry, sign included
+#define POOL_TEXT 128
+
+// rows of a product held as BIGNUMs together
+#define POOL_ROWS 8
+
+// The limbs of some rows, gathered before they go into the arena.
+typedef struct
+{
+    unsigned int* limbs;
+    size_t count;
+    size_t capacity;
+}
+ROW_LIMBS;
+
+/**
+ * NAME: encode
+ * INPUT: BIGNUM* b, POOL_CELL* cell, unsigned int* limbs
+ * OUTPUT: int
+ * USAGE: sets the size of cell for b and either stores b inline or
+ *          writes its limbs to limbs, which must have room for
+ *          POOL_TEXT / POOL_DIGITS of them. Returns the number of limbs
+ *          written, or -1 if b is not an integer.
+ */
+static int encode(BIGNUM* b, POOL_CELL* cell, unsigned int* limbs)
+{
+    char text[POOL_TEXT];
+    int len = bignum_to_string(b, text, sizeof(text));
+    if (len <= 0)
+        return -1;
+    bool neg = (text[0] == '-');
+    const char* digits = text + neg;
+    int count = len - neg;
+    for (int d = 0; d < count; d++)
+        if (digits[d] < '0' || digits[d] > '9')
+            return -1;
+
+    if (count <= POOL_INLINE_DIGITS)
+    {
+        long long value = 0;
+        for (int d = 0; d < count; d++)
+            value = value * 10 + (digits[d] - '0');
+        cell->size = 0;
+        cell->data = neg ? -value : value;
+        return 0;
+    }
+
+    // Limb l holds the digits POOL_DIGITS * l to POOL_DIGITS * (l + 1)
+    // counted from the end.
+    int size = (count + POOL_DIGITS - 1) / POOL_DIGITS;
+    for (int l = 0; l < size; l++)
+    {
+        int end = count - POOL_DIGITS * l;
+        int start = (end > POOL_DIGITS) ? end - POOL_DIGITS : 0;
+        unsigned int limb = 0;
+        for (int d = start; d < end; d++)
+            limb = limb * 10 + (digits[d] - '0');
+        limbs[l] = limb;
+    }
+    cell->size = neg ? -size : size;
+    return size;
+}
+
+/**
+ * NAME: decode
+ * INPUT: POOL_CELL* cell, unsigned int* arena, BIGNUM* b
+ * USAGE: sets b to the value of cell.
+ */
+static void decode(POOL_CELL* cell, unsigned int* arena, BIGNUM* b)
+{
+    char text[POOL_TEXT];
+    int len;
+    if (cell->size == 0)
+        len = snprintf(text, sizeof(text), "%lld", cell->data);
+    else
+    {
+        int size = abs(cell->size);
+        unsigned int* limbs = arena + cell->data;
+        len = snprintf(text, sizeof(text), "%s%u", cell->size < 0 ? "-" : "", limbs[size - 1]);
+
+        // The lower limbs are written with all their digits.
+        for (int l = size - 2; l >= 0; l--)
+        {
+            unsigned int limb = limbs[l];
+            for (int d = POOL_DIGITS - 1; d >= 0; d--)
+            {
+                text[len + d] = '0' + limb % 10;
+                limb /= 10;
+            }
+            len += POOL_DIGITS;
+        }
+    }
+    bignum_from_string(text, len, b);
+}
+
+/**
+ * NAME: append_limbs
+ * INPUT: ROW_LIMBS* r, unsigned int* limbs, int count
+ * OUTPUT: size_t
+ * USAGE: adds count limbs to r and returns where they start.
+ */
+static size_t append_limbs(ROW_LIMBS* r, unsigned int* limbs, int count)
+{
+    if (r->count + count > r->capacity)
+    {
+        while (r->count + count > r->capacity)
+            r->capacity = (r->capacity > 0) ? 2 * r->capacity : 64;
+        r->limbs = realloc(r->limbs, r->capacity * sizeof(unsigned int));
+    }
+    size_t start = r->count;
+    memcpy(r->limbs + start, limbs, count * sizeof(unsigned int));
+    r->count += count;
+    return start;
+}
+
+/**
+ * NAME: encode_row
+ * INPUT: BIGNUM* row, int n, POOL_CELL* cells, ROW_LIMBS* r
+ * OUTPUT: bool
+ * USAGE: encodes the n entries of row into cells, with the limbs going
+ *          to r and offsets relative to r. Returns false if an entry is
+ *          not an integer.
+ */
+static bool encode_row(BIGNUM* row, int n, POOL_CELL* cells, ROW_LIMBS* r)
+{
+    unsigned int limbs[POOL_TEXT / POOL_DIGITS];
+    for (int j = 0; j < n; j++)
+    {
+        int count = encode(&row[j], &cells[j], limbs);
+        if (count < 0)
+            return false;
+        cells[j].room = count;
+        if (count > 0)
+            cells[j].data = append_limbs(r, limbs, count);
+    }
+    return true;
+}
+
+/**
+ * NAME: assemble
+ * INPUT: POOLMAT* p, ROW_LIMBS* rows
+ * USAGE: builds the arena of p from the limbs gathered for each row,
+ *          whose cells are already in place with offsets relative to
+ *          their row, and frees the row buffers.
+ */
+static void assemble(POOLMAT* p, ROW_LIMBS* rows)
+{
+    p->used = 0;
+    for (int i = 0; i < p->numRows; i++)
+        p->used += rows[i].count;
+    p->capacity = p->used;
+    p->garbage = 0;
+    p->limbs = malloc((p->capacity > 0 ? p->capacity : 1) * sizeof(unsigned int));
+
+    size_t start = 0;
+    for (int i = 0; i < p->numRows; i++)
+    {
+        // A row of zeros has no limbs, and no buffer to copy from.
+        if (rows[i].count > 0)
+            memcpy(p->limbs + start, rows[i].limbs, rows[i].count * sizeof(unsigned int));
+        POOL_CELL* cells = p->cells + (size_t) i * p->numCols;
+        for (int j = 0; j < p->numCols; j++)
+            if (cells[j].size != 0)
+                cells[j].data += start;
+        start += rows[i].count;
+        free(rows[i].limbs);
+    }
+    free(rows);
+}
+
+/**
+ * NAME: gather
+ * INPUT: POOLMAT* p, ROW_LIMBS* rows, bool* bad
+ * OUTPUT: bool
+ * USAGE: assembles p from its encoded rows unless one is marked bad,
+ *          in which case it frees everything and returns false.
+ */
+static bool gather(POOLMAT* p, ROW_LIMBS* rows, bool* bad)
+{
+    bool ok = true;
+    for (int i = 0; i < p->numRows; i++)
+        ok = ok && !bad[i];
+    free(bad);
+    if (ok)
+    {
+        assemble(p, rows);
+        return true;
+    }
+
+    printf("Error: pooled matrices hold integers only\n");
+    for (int i = 0; i < p->numRows; i++)
+        free(rows[i].limbs);
+    free(rows);
+    free(p->cells);
+    return false;
+}
+
+// Arguments of the parallel conversions.
+typedef struct
+{
+    MATRIX* m;
+    POOLMAT* p;
+    ROW_LIMBS* rows;
+    bool* bad;
+}
+CONVERT_ARGS;
+
+/**
+ * NAME: encode_rows
+ * INPUT: int begin, int end, void* arg
+ * USAGE: parallel_for body encoding rows [begin, end) of m, marking the
+ *          rows with an entry that is not an integer.
+ */
+static void encode_rows(int begin, int end, void* arg)
+{
+    CONVERT_ARGS* args = arg;
+    for (int i = begin; i < end; i++)
+        args->bad[i] = !encode_row(args->m->matrix[i], args->m->numCols,
+                                   args->p->cells + (size_t) i * args->p->numCols,
+                                   &args->rows[i]);
+}
+
+/**
+ * NAME: poolmat_from_matrix
+ * INPUT: MATRIX* m, POOLMAT* p
+ * OUTPUT: bool
+ * USAGE: allocates p holding m. Returns false, allocating nothing, if
+ *          an entry is not an integer (a floating-point BIGNUM).
+ */
+bool poolmat_from_matrix(MATRIX* m, POOLMAT* p)
+{
+    p->numRows = m->numRows;
+    p->numCols = m->numCols;
+    size_t cells = (size_t) m->numRows * m->numCols;
+    p->cells = malloc((cells > 0 ? cells : 1) * sizeof(POOL_CELL));
+
+    ROW_LIMBS* rows = calloc(m->numRows > 0 ? m->numRows : 1, sizeof(ROW_LIMBS));
+    bool* bad = malloc((m->numRows > 0 ? m->numRows : 1) * sizeof(bool));
+    CONVERT_ARGS args = {m, p, rows, bad};
+    parallel_for(m->numRows, encode_rows, &args);
+    return gather(p, rows, bad);
+}
+
+/**
+ * NAME: decode_rows
+ * INPUT: int begin, int end, void* arg
+ * USAGE: parallel_for body decoding rows [begin, end) of p into m.
+ */
+static void decode_rows(int begin, int end, void* arg)
+{
+    CONVERT_ARGS* args = arg;
+    POOLMAT* p = args->p;
+    for (int i = begin; i < end; i++)
+        for (int j = 0; j < p->numCols; j++)
+            decode(&p->cells[(size_t) i * p->numCols + j], p->limbs, &args->m->matrix[i][j]);
+}
+
+/**
+ * NAME: poolmat_to_matrix
+ * INPUT: POOLMAT* p, MATRIX* m
+ * USAGE: initializes m to the entries of p.
+ *
+ * NOTES: assumes m is malloced.
+ */
+void poolmat_to_matrix(POOLMAT* p, MATRIX* m)
+{
+    alloc_matrix(p->numRows, p->numCols, m);
+    CONVERT_ARGS args = {m, p, NULL, NULL};
+    parallel_for(p->numRows, decode_rows, &args);
+}
+
+/**
+ * NAME: poolmat_get
+ * INPUT: POOLMAT* p, int i, int j, BIGNUM* b
+ * USAGE: sets b to entry (i, j) of p.
+ */
+void poolmat_get(POOLMAT* p, int i, int j, BIGNUM* b)
+{
+    decode(&p->cells[(size_t) i * p->numCols + j], p->limbs, b);
+}
+
+/**
+ * NAME: poolmat_set
+ * INPUT: POOLMAT* p, int i, int j, BIGNUM* b
+ * OUTPUT: bool
+ * USAGE: sets entry (i, j) of p to b, reusing its limbs in the arena
+ *          when b fits in them and appending new ones otherwise. The
+ *          arena is repacked once over half of it is garbage. Returns
+ *          false, leaving the entry alone, if b is not an integer.
+ *
+ * NOTES: not safe to call from several threads at once.
+ */
+bool poolmat_set(POOLMAT* p, int i, int j, BIGNUM* b)
+{
+    POOL_CELL* cell = &p->cells[(size_t) i * p->numCols + j];
+    POOL_CELL updated;
+    unsigned int limbs[POOL_TEXT / POOL_DIGITS];
+    int count = encode(b, &updated, limbs);
+    if (count < 0)
+        return false;
+
+    // garbage already counts the room the entry leaves unused, so only
+    // the limbs it used before and uses now change it.
+    p->garbage += abs(cell->size);
+    if (count == 0)
+        updated.room = 0;
+    else if (count <= cell->room)
+    {
+        updated.room = cell->room;
+        updated.data = cell->data;
+        p->garbage -= count;
+    }
+    else
+    {
+        // The old room is abandoned, and garbage already counts all of
+        // it: its slack from before and its live limbs from above. The
+        // new limbs are appended, growing the arena geometrically like
+        // a ROW_LIMBS.
+        if (p->used + count > p->capacity)
+        {
+            while (p->used + count > p->capacity)
+                p->capacity = (p->capacity > 0) ? 2 * p->capacity : 64;
+            p->limbs = realloc(p->limbs, p->capacity * sizeof(unsigned int));
+        }
+        updated.room = count;
+        updated.data = p->used;
+        p->used += count;
+    }
+    if (count > 0)
+        memcpy(p->limbs + updated.data, limbs, count * sizeof(unsigned int));
+    *cell = updated;
+
+    if (p->garbage > p->used / 2)
+        poolmat_repack(p);
+    return true;
+}
+
+/**
+ * NAME: poolmat_repack
+ * INPUT: POOLMAT* p
+ * USAGE: rewrites the arena with the limbs of every entry in row order
+ *          and no garbage, and shrinks it to fit.
+ */
+void poolmat_repack(POOLMAT* p)
+{
+    size_t cells = (size_t) p->numRows * p->numCols;
+    size_t used = 0;
+    for (size_t c = 0; c < cells; c++)
+        used += abs(p->cells[c].size);
+
+    unsigned int* limbs = malloc((used > 0 ? used : 1) * sizeof(unsigned int));
+    size_t start = 0;
+    for (size_t c = 0; c < cells; c++)
+    {
+        POOL_CELL* cell = &p->cells[c];
+        int size = abs(cell->size);
+        if (size > 0)
+        {
+            memcpy(limbs + start, p->limbs + cell->data, size * sizeof(unsigned int));
+            cell->data = start;
+            start += size;
+        }
+        cell->room = size;
+    }
+
+    free(p->limbs);
+    p->limbs = limbs;
+    p->used = used;
+    p->capacity = used;
+    p->garbage = 0;
+}
+
+/**
+ * NAME: poolmat_bytes
+ * INPUT: POOLMAT* p
+ * OUTPUT: size_t
+ * USAGE: bytes held by p, cells and arena.
+ */
+size_t poolmat_bytes(POOLMAT* p)
+{
+    return (size_t) p->numRows * p->numCols * sizeof(POOL_CELL) +
+           p->capacity * sizeof(unsigned int);
+}
+
+// Arguments of the parallel product.
+typedef struct
+{
+    POOLMAT* a;
+    POOLMAT* b;
+    POOLMAT* c;
+    ROW_LIMBS* rows;
+    bool* bad;
+}
+MULT_ARGS;
+
+/**
+ * NAME: mult_blocks
+ * INPUT: int begin, int end, void* arg
+ * USAGE: parallel_for body computing the blocks of POOL_ROWS rows
+ *          [begin, end) of the product and encoding them, marking the
+ *          rows that are not integers. Each row of b is decoded once per
+ *          block and used for all of its rows.
+ */
+static void mult_blocks(int begin, int end, void* arg)
+{
+    MULT_ARGS* args = arg;
+    POOLMAT *a = args->a, *b = args->b, *c = args->c;
+    int cols = b->numCols;
+    BIGNUM* acc = malloc((size_t) POOL_ROWS * (cols > 0 ? cols : 1) * sizeof(BIGNUM));
+    BIGNUM* brow = malloc((cols > 0 ? cols : 1) * sizeof(BIGNUM));
+
+    for (int block = begin; block < end; block++)
+    {
+        int first = block * POOL_ROWS;
+        int count = (a->numRows - first < POOL_ROWS) ? a->numRows - first : POOL_ROWS;
+        for (size_t x = 0; x < (size_t) count * cols; x++)
+            bignum_from_int(0, &acc[x]);
+
+        for (int k = 0; k < a->numCols; k++)
+        {
+            bool decoded = false;
+            for (int r = 0; r < count; r++)
+            {
+                POOL_CELL* cell = &a->cells[(size_t) (first + r) * a->numCols + k];
+                if (cell->size == 0 && cell->data == 0)
+                    continue;
+                if (!decoded)
+                {
+                    for (int j = 0; j < cols; j++)
+                        poolmat_get(b, k, j, &brow[j]);
+                    decoded = true;
+                }
+
+                BIGNUM x;
+                decode(cell, a->limbs, &x);
+                BIGNUM* accRow = acc + (size_t) r * cols;
+#ifdef BIGNUM_AXPY
+                bignum_axpy(accRow, &x, brow, cols);
+#else
+                for (int j = 0; j < cols; j++)
+                {
+                    BIGNUM product, sum;
+                    bignum_from_int(0, &product);
+                    mult_bignums(&x, &brow[j], &product);
+                    add_bignums(&accRow[j], &product, &sum);
+                    accRow[j] = sum;
+                }
+#endif
+            }
+        }
+
+        for (int r = 0; r < count; r++)
+            args->bad[first + r] = !encode_row(acc + (size_t) r * cols, cols,
+                                               c->cells + (size_t) (first + r) * cols,
+                                               &args->rows[first + r]);
+    }
+    free(acc);
+    free(brow);
+}
+
+/**
+ * NAME: poolmat_mult
+ * INPUT: POOLMAT* a, POOLMAT* b, POOLMAT* c
+ * OUTPUT: bool
+ * USAGE: allocates c holding a times b, computed classically a few rows
+ *          at a time, so only those rows are ever held as BIGNUMs.
+ *          Returns false, allocating nothing, if the shapes do not match
+ *          or an entry of the product is not an integer.
+ */
+bool poolmat_mult(POOLMAT* a, POOLMAT* b, POOLMAT* c)
+{
+    if (a->numCols != b->numRows)
+    {
+        printf("Error: Matrices cannot be multiplied\n");
+        return false;
+    }
+
+    c->numRows = a->numRows;
+    c->numCols = b->numCols;
+    size_t cells = (size_t) c->numRows * c->numCols;
+    c->cells = malloc((cells > 0 ? cells : 1) * sizeof(POOL_CELL));
+    ROW_LIMBS* rows = calloc(c->numRows > 0 ? c->numRows : 1, sizeof(ROW_LIMBS));
+    bool* bad = malloc((c->numRows > 0 ? c->numRows : 1) * sizeof(bool));
+
+    MULT_ARGS args = {a, b, c, rows, bad};
+    parallel_for((a->numRows + POOL_ROWS - 1) / POOL_ROWS, mult_blocks, &args);
+    return gather(c, rows, bad);
+}
+
+/**
+ * NAME: poolmat_free
+ * INPUT: POOLMAT* p
+ * USAGE: frees the storage of p.
+ */
+void poolmat_free(POOLMAT* p)
+{
+    free(p->cells);
+    free(p->limbs);
+    p->cells = NULL;
+    p->limbs = NULL;
+}
@@ -0,0 +1,121 @@
+/****************************************************************************
+ * poolmat.h
+ *
+ * Computer Science 51
+ * Pooled Bignum Matrices
+ *
+ * A BIGNUM is sized for the largest value it can hold: 100 digits, 408
+ * bytes, even for the single digit most entries have. A pooled matrix
+ * stores each entry in a 16-byte cell instead, holding values of up to
+ * 18 digits inline and the digits of larger ones, in base 10^9 limbs,
+ * in an arena shared by the whole matrix, packed in row order. Memory
+ * then follows the digits actually held, so much larger matrices fit
+ * in RAM and far more of one fits in cache. Entries are turned back
+ * into BIGNUMs only to compute with them.
+ ***************************************************************************/
+#ifndef _POOLMAT_H
+#define _POOLMAT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "matrix.h"
+
+// An entry. size is 0 for a value held inline in data, and otherwise
+// the number of limbs at offset data in the arena, negated for a
+// negative value (as GMP does). room is the number of limbs reserved
+// there, which a larger value may reuse.
+typedef struct
+{
+    int size;
+    int room;
+    long long data;
+}
+POOL_CELL;
+
+// A pooled matrix. Limbs are least significant first. garbage counts
+// the limbs of the arena below used that hold no entry's value.
+typedef struct
+{
+    POOL_CELL* cells;
+    unsigned int* limbs;
+    size_t used;
+    size_t capacity;
+    size_t garbage;
+    int numRows;
+    int numCols;
+}
+POOLMAT;
+
+/**
+ * NAME: poolmat_from_matrix
+ * INPUT: MATRIX* m, POOLMAT* p
+ * OUTPUT: bool
+ * USAGE: allocates p holding m. Returns false, allocating nothing, if
+ *          an entry is not an integer (a floating-point BIGNUM).
+ */
+bool poolmat_from_matrix(MATRIX* m, POOLMAT* p);
+
+/**
+ * NAME: poolmat_to_matrix
+ * INPUT: POOLMAT* p, MATRIX* m
+ * USAGE: initializes m to the entries of p.
+ *
+ * NOTES: assumes m is malloced.
+ */
+void poolmat_to_matrix(POOLMAT* p, MATRIX* m);
+
+/**
+ * NAME: poolmat_get
+ * INPUT: POOLMAT* p, int i, int j, BIGNUM* b
+ * USAGE: sets b to entry (i, j) of p.
+ */
+void poolmat_get(POOLMAT* p, int i, int j, BIGNUM* b);
+
+/**
+ * NAME: poolmat_set
+ * INPUT: POOLMAT* p, int i, int j, BIGNUM* b
+ * OUTPUT: bool
+ * USAGE: sets entry (i, j) of p to b, reusing its limbs in the arena
+ *          when b fits in them and appending new ones otherwise. The
+ *          arena is repacked once over half of it is garbage. Returns
+ *          false, leaving the entry alone, if b is not an integer.
+ *
+ * NOTES: not safe to call from several threads at once.
+ */
+bool poolmat_set(POOLMAT* p, int i, int j, BIGNUM* b);
+
+/**
+ * NAME: poolmat_repack
+ * INPUT: POOLMAT* p
+ * USAGE: rewrites the arena with the limbs of every entry in row order
+ *          and no garbage, and shrinks it to fit.
+ */
+void poolmat_repack(POOLMAT* p);
+
+/**
+ * NAME: poolmat_bytes
+ * INPUT: POOLMAT* p
+ * OUTPUT: size_t
+ * USAGE: bytes held by p, cells and arena.
+ */
+size_t poolmat_bytes(POOLMAT* p);
+
+/**
+ * NAME: poolmat_mult
+ * INPUT: POOLMAT* a, POOLMAT* b, POOLMAT* c
+ * OUTPUT: bool
+ * USAGE: allocates c holding a times b, computed classically a few rows
+ *          at a time, so only those rows are ever held as BIGNUMs.
+ *          Returns false if the shapes do not match.
+ */
+bool poolmat_mult(POOLMAT* a, POOLMAT* b, POOLMAT* c);
+
+/**
+ * NAME: poolmat_free
+ * INPUT: POOLMAT* p
+ * USAGE: frees the storage of p.
+ */
+void poolmat_free(POOLMAT* p);
+
+#endif
@@ -0,0 +1,496 @@
+/*************************************************************************
+ * rectmult.c
+ *
+ * Implements Strassen's algorithm on rectangular matrices without
+ * padding them to one square. Rectangular multiplication can be done by
+ * running "rect" (which uses bignums) and "intrect" (which uses 64bit
+ * ints). "make rect" and "make intrect" will compile the required files.
+ *
+ * A scheme <m,k,n> multiplies an m by k block matrix A by a k by n
+ * block matrix B with rank block products: product r is
+ *
+ *     (sum of U[r][i][l] A_il) times (sum of V[r][l][j] B_lj)
+ *
+ * and is added into C_ij with coefficient W[r][i][j]. Strassen's
+ * algorithm is <2,2,2> with 7 products, and is the only scheme in the
+ * table. At each level a simple operation count decides between it and
+ * the classical algorithm for the current shape, so a long, thin operand
+ * is multiplied classically once a side gets too short instead of being
+ * padded out to a square. Uneven blocks are padded with zeros only at
+ * the level that needs it.
+ ************************************************************************/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bignum.h"
+#include "gen.h"
+#include "matrix.h"
+#include "memtrack.h"
+#include "mult.h"
+#include "perfcount.h"
+#include "trace.h"
+#include "verify.h"
+
+// cost of one cell of a block sum or update, relative to one
+// multiply-add of the classical algorithm
+#define ADD_COST 1.0
+
+// Instrumented phases, see perfcount.h.
+static PERF_PHASE sumPhase = PERF_PHASE_INIT("rect operand sums");
+static PERF_PHASE leafPhase = PERF_PHASE_SAMPLED("rect classical", 16);
+static PERF_PHASE updatePhase = PERF_PHASE_INIT("rect update");
+
+/* COEFFICIENT TABLES */
+
+// Block indices are row-major: U[r][i * k + l], V[r][l * n + j] and
+// W[r][i * n + j]. Only Strassen's <2,2,2> is listed. A scheme pays off
+// here only if its products per block volume, rank / (m k n), is below
+// Strassen's 7/8: <2,2,3> (rank 11) and <2,3,4> built from Strassen's
+// (rank 22) never are, and no table is kept for them. Rank-15 <3,2,3> or
+// rank-20 <2,3,4> tables would be, and can be added here.
+
+// <2,2,2>: 7 products
+static const signed char s222U[7][4] =
+{
+    { 1,  0,  0,  1},
+    { 0,  0,  1,  1},
+    { 1,  0,  0,  0},
+    { 0,  0,  0,  1},
+    { 1,  1,  0,  0},
+    {-1,  0,  1,  0},
+    { 0,  1,  0, -1}
+};
+
+static const signed char s222V[7][4] =
+{
+    { 1,  0,  0,  1},
+    { 1,  0,  0,  0},
+    { 0,  1,  0, -1},
+    {-1,  0,  1,  0},
+    { 0,  0,  0,  1},
+    { 1,  1,  0,  0},
+    { 0,  0,  1,  1}
+};
+
+static const signed char s222W[7][4] =
+{
+    { 1,  0,  0,  1},
+    { 0,  0,  1, -1},
+    { 0,  1,  0,  1},
+    { 1,  0,  1,  0},
+    {-1,  1,  0,  0},
+    { 0,  0,  0,  1},
+    { 1,  0,  0,  0}
+};
+
+// A multiplication scheme.
+typedef struct
+{
+    const char* name;
+    int m, k, n;
+    int rank;
+    const signed char* u;
+    const signed char* v;
+    const signed char* w;
+}
+SCHEME;
+
+#define SCHEME_ENTRY(name, m, k, n, t) \
+    {name, m, k, n, sizeof(t##U) / sizeof(t##U[0]), &t##U[0][0], &t##V[0][0], &t##W[0][0]}
+
+static const SCHEME schemes[] =
+{
+    SCHEME_ENTRY("<2,2,2>", 2, 2, 2, s222),
+};
+#define NUM_SCHEMES (int) (sizeof(schemes) / sizeof(schemes[0]))
+
+/* RECTANGULAR ALGORITHM FUNCTIONS */
+
+/**
+ * NAME: blocks
+ * INPUT: int size, int parts
+ * OUTPUT: int
+ * USAGE: side of each of parts blocks covering size.
+ */
+static int blocks(int size, int parts)
+{
+    return (size + parts - 1) / parts;
+}
+
+/**
+ * NAME: nonzeros
+ * INPUT: const signed char* coeffs, int count
+ * OUTPUT: int
+ * USAGE: number of nonzero coefficients among count.
+ */
+static int nonzeros(const signed char* coeffs, int count)
+{
+    int total = 0;
+    for (int c = 0; c < count; c++)
+        total += (coeffs[c] != 0);
+    return total;
+}
+
+/**
+ * NAME: scheme_cost
+ * INPUT: const SCHEME* s, int rowSize, int innerSize, int colSize
+ * OUTPUT: double
+ * USAGE: estimated cost of one level of s on this shape, with the block
+ *          products done classically: the products, the operand sums
+ *          (a single block needs no sum) and the updates of C.
+ */
+static double scheme_cost(const SCHEME* s, int rowSize, int innerSize, int colSize)
+{
+    double mb = blocks(rowSize, s->m);
+    double kb = blocks(innerSize, s->k);
+    double nb = blocks(colSize, s->n);
+    double cost = s->rank * mb * kb * nb;
+    for (int r = 0; r < s->rank; r++)
+    {
+        int terms = nonzeros(s->u + r * s->m * s->k, s->m * s->k);
+        if (terms > 1)
+            cost += ADD_COST * terms * mb * kb;
+        terms = nonzeros(s->v + r * s->k * s->n, s->k * s->n);
+        if (terms > 1)
+            cost += ADD_COST * terms * kb * nb;
+        cost += ADD_COST * nonzeros(s->w + r * s->m * s->n, s->m * s->n) * mb * nb;
+    }
+    return cost;
+}
+
+/**
+ * NAME: choose_scheme
+ * INPUT: int rowSize, int innerSize, int colSize
+ * OUTPUT: const SCHEME*
+ * USAGE: the cheapest scheme for this shape, or NULL if the classical
+ *          algorithm is cheaper than all of them.
+ */
+static const SCHEME* choose_scheme(int rowSize, int innerSize, int colSize)
+{
+    const SCHEME* best = NULL;
+    double bestCost = (double) rowSize * innerSize * colSize;
+    for (int s = 0; s < NUM_SCHEMES; s++)
+    {
+        // Every block must be at least one cell in each direction.
+        if (rowSize < schemes[s].m || innerSize < schemes[s].k || colSize < schemes[s].n)
+            continue;
+        double cost = scheme_cost(&schemes[s], rowSize, innerSize, colSize);
+        if (cost < bestCost)
+        {
+            best = &schemes[s];
+            bestCost = cost;
+        }
+    }
+    return best;
+}
+
+/**
+ * NAME: block_view
+ * INPUT: MATRIX* m, int bi, int bj, int rowSide, int colSide, MATRIX* v
+ * OUTPUT: bool
+ * USAGE: makes v the block (bi, bj) of m for blocks of rowSide by
+ *          colSide, clipped to m. Returns false (and makes no view) if
+ *          the block lies wholly outside m.
+ */
+static bool block_view(MATRIX* m, int bi, int bj, int rowSide, int colSide, MATRIX* v)
+{
+    int row = bi * rowSide;
+    int col = bj * colSide;
+    if (row >= m->numRows || col >= m->numCols)
+        return false;
+    int rows = (m->numRows - row < rowSide) ? m->numRows - row : rowSide;
+    int cols = (m->numCols - col < colSide) ? m->numCols - col : colSide;
+    view_matrix(m, row, col, rows, cols, v);
+    return true;
+}
+
+/**
+ * NAME: add_scaled
+ * INPUT: MATRIX* dst, MATRIX* src, int coeff
+ * USAGE: adds coeff (1 or -1) times src into the top-left of dst, over
+ *          the cells both have.
+ */
+static void add_scaled(MATRIX* dst, MATRIX* src, int coeff)
+{
+    int rows = (dst->numRows < src->numRows) ? dst->numRows : src->numRows;
+    int cols = (dst->numCols < src->numCols) ? dst->numCols : src->numCols;
+    BIGNUM term, sum;
+    for (int i = 0; i < rows; i++)
+    {
+        for (int j = 0; j < cols; j++)
+        {
+            term = src->matrix[i][j];
+            if (coeff < 0)
+                negate_bignums(&term);
+            add_bignums(&dst->matrix[i][j], &term, &sum);
+            dst->matrix[i][j] = sum;
+        }
+    }
+}
+
+/**
+ * NAME: combine_blocks
+ * INPUT: MATRIX* m, const signed char* coeffs, int parts, int cols,
+ *          int rowSide, int colSide, MATRIX* out
+ * OUTPUT: bool
+ * USAGE: forms the operand sum(coeffs[b] * block b) of m, which is
+ *          split into parts by cols blocks of rowSide by colSide. A lone
+ *          full-size block with coefficient 1 is returned as a view
+ *          (and the function returns true); otherwise out is allocated
+ *          as a zero-padded rowSide by colSide matrix holding the sum.
+ *
+ * NOTES: assumes out is malloced. Release out with free_view if this
+ *          returns true, free_matrix otherwise.
+ */
+static bool combine_blocks(MATRIX* m, const signed char* coeffs, int parts, int cols,
+                           int rowSide, int colSide, MATRIX* out)
+{
+    MATRIX* block = malloc(sizeof(MATRIX));
+    if (nonzeros(coeffs, parts * cols) == 1)
+    {
+        for (int b = 0; b < parts * cols; b++)
+        {
+            if (coeffs[b] == 1 && block_view(m, b / cols, b % cols, rowSide, colSide, out))
+            {
+                if (out->numRows == rowSide && out->numCols == colSide)
+                {
+                    free(block);
+                    return true;
+                }
+                free(out->matrix);
+            }
+        }
+    }
+
+    zero_matrix(rowSide, colSide, out);
+    for (int b = 0; b < parts * cols; b++)
+    {
+        if (coeffs[b] != 0 && block_view(m, b / cols, b % cols, rowSide, colSide, block))
+        {
+            add_scaled(out, block, coeffs[b]);
+            free(block->matrix);
+        }
+    }
+    free(block);
+    return false;
+}
+
+/**
+ * NAME: release_operand
+ * INPUT: MATRIX* m, bool isView
+ * USAGE: frees an operand made by combine_blocks.
+ */
+static void release_operand(MATRIX* m, bool isView)
+{
+    if (isView)
+        free_view(m);
+    else
+        free_matrix(m);
+}
+
+/**
+ * NAME: rect_helper
+ * INPUT: MATRIX* m1, MATRIX* m2, MATRIX* res, int depth
+ * USAGE: adds m1 times m2 to res, with the scheme choose_scheme picks
+ *          for the shape at this level.
+ */
+static void rect_helper(MATRIX* m1, MATRIX* m2, MATRIX* res, int depth)
+{
+    int rowSize = m1->numRows;
+    int innerSize = m1->numCols;
+    int colSize = m2->numCols;
+
+    // base case
+    const SCHEME* s = choose_scheme(rowSize, innerSize, colSize);
+    if (s == NULL)
+    {
+        perf_begin(&leafPhase);
+        multiply_accumulate(m1, m2, res);
+        perf_end(&leafPhase);
+        return;
+    }
+
+    trace_begin(s->name, depth, rowSize, 0);
+    int mb = blocks(rowSize, s->m);
+    int kb = blocks(innerSize, s->k);
+    int nb = blocks(colSize, s->n);
+
+    MATRIX* product = malloc(sizeof(MATRIX));
+    MATRIX* block = malloc(sizeof(MATRIX));
+    zero_matrix(mb, nb, product);
+
+    for (int r = 0; r < s->rank; r++)
+    {
+        MATRIX* left = malloc(sizeof(MATRIX));
+        MATRIX* right = malloc(sizeof(MATRIX));
+        perf_begin(&sumPhase);
+        bool leftView = combine_blocks(m1, s->u + r * s->m * s->k, s->m, s->k, mb, kb, left);
+        bool rightView = combine_blocks(m2, s->v + r * s->k * s->n, s->k, s->n, kb, nb, right);
+        for (int i = 0; i < mb; i++)
+            for (int j = 0; j < nb; j++)
+                bignum_from_int(0, &product->matrix[i][j]);
+        perf_end(&sumPhase);
+
+        rect_helper(left, right, product, depth + 1);
+        release_operand(left, leftView);
+        release_operand(right, rightView);
+
+        // Add the product into every block of C that uses it.
+        perf_begin(&updatePhase);
+        const signed char* w = s->w + r * s->m * s->n;
+        for (int b = 0; b < s->m * s->n; b++)
+        {
+            if (w[b] != 0 && block_view(res, b / s->n, b % s->n, mb, nb, block))
+            {
+                add_scaled(block, product, w[b]);
+                free(block->matrix);
+            }
+        }
+        perf_end(&updatePhase);
+    }
+
+    free(block);
+    free_matrix(product);
+    trace_end(s->name);
+}
+
+/**
+ * NAME: largest_sum
+ * INPUT: const signed char* coeffs, int count, int rank
+ * OUTPUT: int
+ * USAGE: the largest sum of |coefficients| over the rank rows of count
+ *          coefficients each.
+ */
+static int largest_sum(const signed char* coeffs, int count, int rank)
+{
+    int largest = 0;
+    for (int r = 0; r < rank; r++)
+    {
+        int total = 0;
+        for (int c = 0; c < count; c++)
+            total += abs(coeffs[r * count + c]);
+        if (total > largest)
+            largest = total;
+    }
+    return largest;
+}
+
+/**
+ * NAME: rect_bound
+ * INPUT: int rowSize, int innerSize, int colSize, double maxA, double maxB
+ * OUTPUT: double
+ * USAGE: a bound on the magnitude of every value rect_mult forms, the
+ *          partial sums included, for entries of m1 at most maxA and of
+ *          m2 at most maxB in magnitude.
+ *
+ * NOTES: follows the schemes rect_helper picks. Each level's operand
+ *          sums grow the entries by the largest |U| and |V| row sums,
+ *          and a block of C gathers its products' bounds times |W|.
+ */
+double rect_bound(int rowSize, int innerSize, int colSize, double maxA, double maxB)
+{
+    const SCHEME* s = choose_scheme(rowSize, innerSize, colSize);
+    if (s == NULL)
+        return innerSize * maxA * maxB;
+
+    int kb = blocks(innerSize, s->k);
+    double a = maxA * largest_sum(s->u, s->m * s->k, s->rank);
+    double b = maxB * largest_sum(s->v, s->k * s->n, s->rank);
+
+    // Every product is at most kb a b; the block of C with the most
+    // |W| weight gathers the most of them.
+    int gathered = 0;
+    for (int blk = 0; blk < s->m * s->n; blk++)
+    {
+        int total = 0;
+        for (int r = 0; r < s->rank; r++)
+            total += abs(s->w[r * s->m * s->n + blk]);
+        if (total > gathered)
+            gathered = total;
+    }
+
+    // The operand sums themselves are values too.
+    double bound = rect_bound(blocks(rowSize, s->m), kb, blocks(colSize, s->n), a, b);
+    double candidates[3] = {gathered * kb * a * b, a, b};
+    for (int c = 0; c < 3; c++)
+        if (candidates[c] > bound)
+            bound = candidates[c];
+    return bound;
+}
+
+/**
+ * NAME: rect_mult
+ * INPUT: MATRIX* m1, MATRIX* m2, MATRIX* res
+ * USAGE: Multiplies m1 and m2 with Strassen's scheme, padding only
+ *          odd sizes at each level, and stores the result in res.
+ *
+ * NOTES: m1, m2, res must all be malloced before using this function.
+ */
+void rect_mult(MATRIX* m1, MATRIX* m2, MATRIX* res)
+{
+    // Checks to see whether m1 and m2 can be multiplied.
+    if (m1->numCols != m2->numRows)
+    {
+        printf("Error: Matrices cannot be multiplied");
+        return;
+    }
+
+    zero_matrix(m1->numRows, m2->numCols, res);
+    rect_helper(m1, m2, res, 0);
+}
+
+#ifndef NO_MAIN
+
+int main(void)
+{
+    // Structs for timing data.
+    struct rusage before, after;
+    double ti_multiply=0.0;
+
+    // Open hardware counters if PERF_COUNTERS is set.
+    perf_init();
+    trace_open();
+
+    // Seed random number generators. MATRIX_SEED overrides the seed.
+    srand(time(NULL));
+    gen_set_seed(time(NULL));
+
+    // Initalize matrixes. A tall-skinny by short-fat product by default;
+    // change values here for different size matrices.
+    MATRIX* m1 = malloc(sizeof(MATRIX));
+    MATRIX* m2 = malloc(sizeof(MATRIX));
+    initialize_matrix(12,8,m1);
+    initialize_matrix(8,6,m2);
+
+    MATRIX* m3 = malloc(sizeof(MATRIX));
+
+    // Calculate time while multiplying.
+    getrusage(RUSAGE_SELF, &before);
+    rect_mult(m1,m2,m3);
+    getrusage(RUSAGE_SELF, &after);
+    ti_multiply = calculate(&before, &after);
+
+    // Print out matrices to stdout.  Comment this section out for large matrices.
+    print_matrix(m1);
+    print_matrix(m2);
+    print_matrix(m3);
+
+    // Print out computation time.
+    printf("\nTime Spent (in sec): %f\n", (ti_multiply));
+    trace_close();
+    perf_report();
+    memtrack_report();
+
+    // Check the product if VERIFY_ROUNDS is set.
+    verify_from_env(m1, m2, m3);
+
+    // Free matrices when done with them.
+    free_matrix(m1);
+    free_matrix(m2);
+    free_matrix(m3);
+}
+#endif
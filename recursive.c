@@ -0,0 +1,182 @@
+/*************************************************************************
+ * recursive.c
+ *
+ * Implements cache-oblivious recursive multiplication.
+ * Recursive multiplication can be done by running
+ * "recursive" (which uses bignums) and "intrecursive" (which uses 64bit ints).
+ * "make recursive" and "make intrecursive" will compile the required files.
+ *
+ * The classical algorithm, reorganized: the largest of the three
+ * dimensions is halved until the blocks are small, so at some level of
+ * the recursion the blocks fit in each level of cache, whatever its
+ * size. Halves are views (see view_matrix) and products are added
+ * straight into the result, so no temporary matrices are made.
+ ************************************************************************/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bignum.h"
+#include "gen.h"
+#include "matrix.h"
+#include "memtrack.h"
+#include "mult.h"
+#include "perfcount.h"
+#include "verify.h"
+
+// Blocks are multiplied directly once all three fit in this many bytes.
+// This only amortizes the cost of recursing; it is not a cache size.
+#define LEAF_BYTES 8192
+
+// Instrumented phases, see perfcount.h.
+static PERF_PHASE multiplyPhase = PERF_PHASE_INIT("recursive multiply");
+
+/**
+ * NAME: recursive_helper
+ * INPUT: MATRIX* m1, MATRIX* m2, MATRIX* res
+ * USAGE: adds m1 times m2 to res, halving the largest dimension until
+ *          the blocks are small enough for multiply_accumulate.
+ */
+static void recursive_helper(MATRIX* m1, MATRIX* m2, MATRIX* res)
+{
+    int rows = m1->numRows;
+    int inner = m1->numCols;
+    int cols = m2->numCols;
+
+    // base case
+    long long elements = (long long) rows * inner + (long long) inner * cols +
+                         (long long) rows * cols;
+    if (elements * (long long) sizeof(BIGNUM) <= LEAF_BYTES ||
+        (rows <= 1 && inner <= 1 && cols <= 1))
+    {
+        multiply_accumulate(m1, m2, res);
+        return;
+    }
+
+    MATRIX* first1 = malloc(sizeof(MATRIX));
+    MATRIX* first2 = malloc(sizeof(MATRIX));
+    MATRIX* firstRes = malloc(sizeof(MATRIX));
+    MATRIX* second1 = malloc(sizeof(MATRIX));
+    MATRIX* second2 = malloc(sizeof(MATRIX));
+    MATRIX* secondRes = malloc(sizeof(MATRIX));
+
+    if (rows >= inner && rows >= cols)
+    {
+        // Top and bottom halves of m1 and res.
+        int half = rows / 2;
+        view_matrix(m1, 0, 0, half, inner, first1);
+        view_matrix(m1, half, 0, rows - half, inner, second1);
+        view_matrix(m2, 0, 0, inner, cols, first2);
+        view_matrix(m2, 0, 0, inner, cols, second2);
+        view_matrix(res, 0, 0, half, cols, firstRes);
+        view_matrix(res, half, 0, rows - half, cols, secondRes);
+    }
+    else if (cols >= inner)
+    {
+        // Left and right halves of m2 and res.
+        int half = cols / 2;
+        view_matrix(m1, 0, 0, rows, inner, first1);
+        view_matrix(m1, 0, 0, rows, inner, second1);
+        view_matrix(m2, 0, 0, inner, half, first2);
+        view_matrix(m2, 0, half, inner, cols - half, second2);
+        view_matrix(res, 0, 0, rows, half, firstRes);
+        view_matrix(res, 0, half, rows, cols - half, secondRes);
+    }
+    else
+    {
+        // Left half of m1 with the top half of m2, then the rest; both
+        // products add into all of res.
+        int half = inner / 2;
+        view_matrix(m1, 0, 0, rows, half, first1);
+        view_matrix(m1, 0, half, rows, inner - half, second1);
+        view_matrix(m2, 0, 0, half, cols, first2);
+        view_matrix(m2, half, 0, inner - half, cols, second2);
+        view_matrix(res, 0, 0, rows, cols, firstRes);
+        view_matrix(res, 0, 0, rows, cols, secondRes);
+    }
+
+    recursive_helper(first1, first2, firstRes);
+    recursive_helper(second1, second2, secondRes);
+
+    free_view(first1);
+    free_view(first2);
+    free_view(firstRes);
+    free_view(second1);
+    free_view(second2);
+    free_view(secondRes);
+}
+
+/**
+ * NAME: recursive_mult
+ * INPUT: MATRIX* m1, MATRIX* m2, MATRIX* res
+ * USAGE: Multiplies m1 and m2 with the cache-oblivious recursive
+ *          algorithm and stores the result in res.
+ *
+ * NOTES: m1, m2, res must all be malloced before using this function.
+ */
+void recursive_mult(MATRIX* m1, MATRIX* m2, MATRIX* res)
+{
+    // Checks to see whether m1 and m2 can be multiplied.
+    if (m1->numCols != m2->numRows)
+    {
+        printf("Error: Matrices cannot be multiplied");
+        return;
+    }
+
+    perf_begin(&multiplyPhase);
+    zero_matrix(m1->numRows, m2->numCols, res);
+    recursive_helper(m1, m2, res);
+    perf_end(&multiplyPhase);
+}
+
+#ifndef NO_MAIN
+
+int main(void)
+{
+    // Structs for timing data.
+    struct rusage before, after;
+    double ti_multiply=0.0;
+
+    // Open hardware counters if PERF_COUNTERS is set.
+    perf_init();
+
+    // Seed random number generators. MATRIX_SEED overrides the seed.
+    srand(time(NULL));
+    gen_set_seed(time(NULL));
+
+    // Initalize matrixes. Change values here for different size matrices.
+    MATRIX* m1 = malloc(sizeof(MATRIX));
+    MATRIX* m2 = malloc(sizeof(MATRIX));
+    initialize_matrix(10,10,m1);
+    initialize_matrix(10,10,m2);
+
+    MATRIX* m3 = malloc(sizeof(MATRIX));
+
+    // Calculate time while multiplying.
+    getrusage(RUSAGE_SELF, &before);
+    recursive_mult(m1,m2,m3);
+    getrusage(RUSAGE_SELF, &after);
+    ti_multiply = calculate(&before, &after);
+
+    // Print out matrices to stdout.  Comment this section out for large matrices.
+    print_matrix(m1);
+    print_matrix(m2);
+    print_matrix(m3);
+
+    // Print out computation time.
+    printf("\nTime Spent (in sec): %f\n", (ti_multiply));
+    perf_report();
+    memtrack_report();
+
+    // Check the product if VERIFY_ROUNDS is set.
+    verify_from_env(m1, m2, m3);
+
+    // Free matrices when done with them.
+    free_matrix(m1);
+    free_matrix(m2);
+    free_matrix(m3);
+}
+#endif
@@ -14,7 +14,15 @@
 #include <time.h>
 
 #include "bignum.h"
+#include "gen.h"
 #include "matrix.h"
+#include "memtrack.h"
+#include "mult.h"
+#include "perfcount.h"
+#include "verify.h"
+
+// Instrumented phases, see perfcount.h.
+static PERF_PHASE multiplyPhase = PERF_PHASE_INIT("regular multiply");
 
 
 /**
@@ -37,17 +45,19 @@ void regular_mult(MATRIX* m1, MATRIX* m2, MATRIX* res)
     int rowSize = m1->numRows;
     int colSize = m2->numCols;
     
-    // Fill in matrix information
-    res->numRows = rowSize;
-    res->numCols = colSize;
+    perf_begin(&multiplyPhase);
     
-    // Allocate memory for the rows of the matrix.
-    res->matrix = (BIGNUM**) malloc(rowSize * sizeof(BIGNUM*));
+#ifdef BIGNUM_AXPY
+    // Bignum types with their own inner loop (see bignum_axpy) run the
+    // i-k-j loops of multiply_accumulate instead, which make the same
+    // sums in the same order with no temporaries.
+    zero_matrix(rowSize, colSize, res);
+    multiply_accumulate(m1, m2, res);
+#else
+    // Allocate memory for the matrix.
+    alloc_matrix(rowSize, colSize, res);
     for(int i = 0; i < rowSize; i++)
     {
-        // Allocate memory for each entry in the matrix.
-        res->matrix[i] = (BIGNUM*) malloc(colSize * sizeof(BIGNUM));
-        
         // Go across the columns of m2
         for (int j=0; j< colSize; j++)
         {
@@ -80,16 +90,25 @@ void regular_mult(MATRIX* m1, MATRIX* m2, MATRIX* res)
             free(sum);
         }
     }
+#endif
+    
+    perf_end(&multiplyPhase);
 }
 
+#ifndef NO_MAIN
+
 int main(void)
 {
     // Structs for timing data.
     struct rusage before, after;
     double ti_multiply=0.0;
     
-    // Seed random number generator.
+    // Open hardware counters if PERF_COUNTERS is set.
+    perf_init();
+    
+    // Seed random number generators. MATRIX_SEED overrides the seed.
 	srand(time(NULL));
+	gen_set_seed(time(NULL));
 	
 	// Initalize matrixes. Change values here for different size matrices.
     MATRIX* m1 = malloc(sizeof(MATRIX));
@@ -112,9 +131,15 @@ int main(void)
     
     // Print out computation time.
     printf("\nTime Spent (in sec): %f\n", (ti_multiply));
+    perf_report();
+    memtrack_report();
+    
+    // Check the product if VERIFY_ROUNDS is set.
+    verify_from_env(m1, m2, m3);
     
     // Free matrices when done with them.
     free_matrix(m1);
     free_matrix(m2);
     free_matrix(m3);
 }
+#endif
@@ -0,0 +1,96 @@
+/*************************************************************************
+ * rounding.c
+ *
+ * Implements the rounding error bounds of Strassen's and Winograd's
+ * algorithms (see rounding.h). They depend only on the size, the depth and the unit
+ * roundoff, so every program of a bignum type that rounds shares them.
+ ************************************************************************/
+
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "bignum.h"
+#include "rounding.h"
+
+/**
+ * NAME: strassen_error_bound
+ * INPUT: int n, int depth
+ * OUTPUT: double
+ * USAGE: Higham's bound on the rounding error of n by n Strassen
+ *          products recursing depth levels, relative to n max|a| max|b|.
+ */
+double strassen_error_bound(int n, int depth)
+{
+#ifdef BIGNUM_UNIT_ROUNDOFF
+    double n0 = n;
+    double growth = 1;
+    for (int level = 0; level < depth; level++)
+    {
+        n0 /= 2;
+        growth *= 12;
+    }
+    return (growth * (n0 * n0 + 5.0 * n0) - 5.0 * n) * BIGNUM_UNIT_ROUNDOFF / n;
+#else
+    (void) n;
+    (void) depth;
+    return 0;
+#endif
+}
+
+/**
+ * NAME: winograd_error_bound
+ * INPUT: int n
+ * OUTPUT: double
+ * USAGE: the bound on the rounding error of Winograd's products with
+ *          inner dimension n and balanced operands, relative to
+ *          n max|a| max|b|.
+ */
+double winograd_error_bound(int n)
+{
+#ifdef BIGNUM_UNIT_ROUNDOFF
+    return 7.2 * (n + 4.0) * BIGNUM_UNIT_ROUNDOFF;
+#else
+    (void) n;
+    return 0;
+#endif
+}
+
+/**
+ * NAME: strassen_max_depth
+ * INPUT: int n, double tolerance
+ * OUTPUT: int
+ * USAGE: the deepest recursion on n by n blocks whose bound is within
+ *          tolerance.
+ */
+int strassen_max_depth(int n, double tolerance)
+{
+#ifdef BIGNUM_UNIT_ROUNDOFF
+    int depth = 0;
+    while ((n >> (depth + 1)) >= 1 && strassen_error_bound(n, depth + 1) <= tolerance)
+        depth++;
+    return depth;
+#else
+    (void) n;
+    (void) tolerance;
+    return INT_MAX;
+#endif
+}
+
+/**
+ * NAME: strassen_depth_limit
+ * INPUT: int n
+ * OUTPUT: int
+ * USAGE: strassen_max_depth for n and STRASSEN_TOLERANCE, by default
+ *          the square root of the unit roundoff.
+ */
+int strassen_depth_limit(int n)
+{
+    const char* env = getenv("STRASSEN_TOLERANCE");
+#ifdef BIGNUM_UNIT_ROUNDOFF
+    double tolerance = (env != NULL) ? atof(env) : sqrt(BIGNUM_UNIT_ROUNDOFF);
+#else
+    double tolerance = (env != NULL) ? atof(env) : 0;
+#endif
+    return strassen_max_depth(n, tolerance);
+}
@@ -0,0 +1,79 @@
+/****************************************************************************
+ * rounding.h
+ *
+ * Computer Science 51
+ * Rounding Error Bounds
+ *
+ * Bounds on the rounding error of Strassen's and Winograd's algorithms
+ * for the bignums that round (see BIGNUM_UNIT_ROUNDOFF in
+ * fp_bignums/bignum.h). Strassen's drivers use them to pick how deep to
+ * recurse, and Freivalds' check to pick how far a product may be off.
+ ***************************************************************************/
+#ifndef _ROUNDING_H
+#define _ROUNDING_H
+
+/**
+ * NAME: strassen_error_bound
+ * INPUT: int n, int depth
+ * OUTPUT: double
+ * USAGE: a bound on the rounding error of every entry of an n by n
+ *          product (n a power of 2) by Strassen's algorithm recursing
+ *          depth levels, relative to n max|a| max|b|, the largest
+ *          magnitude an entry of the product can have. Depth 0 is the
+ *          classical algorithm, whose bound is n u. 0 for bignums that
+ *          do not round.
+ *
+ * NOTES: the bound for Strassen's algorithm stopping at blocks of side
+ *          n0 = n / 2^depth (Higham, Accuracy and Stability of
+ *          Numerical Algorithms, 2nd ed., Theorem 23.2): every entry
+ *          is off by at most
+ *          ((n / n0)^log2(12) (n0^2 + 5 n0) - 5n) u max|a| max|b|,
+ *          u the unit roundoff. It grows about 3 times per level.
+ */
+double strassen_error_bound(int n, int depth);
+
+/**
+ * NAME: winograd_error_bound
+ * INPUT: int n
+ * OUTPUT: double
+ * USAGE: a bound on the rounding error of every entry of a product
+ *          with inner dimension n by Winograd's algorithm, relative to
+ *          n max|a| max|b| as for strassen_error_bound. 0 for bignums
+ *          that do not round.
+ *
+ * NOTES: Winograd's algorithm multiplies sums a + b of entries of both
+ *          operands, so its error scales with (max|a| + max|b|)^2 and
+ *          not max|a| max|b|. winograd_mult scales the operands by
+ *          powers of 2 until max|a| and max|b| are within a factor of
+ *          4 of each other; then the n / 2 products, row factors and
+ *          column factors add up to at most 7.125 n max|a| max|b|,
+ *          each term rounded at most n + 4 times (a row factor is
+ *          summed once on its own and again into every entry), which
+ *          gives 7.2 (n + 4) u.
+ */
+double winograd_error_bound(int n);
+
+/**
+ * NAME: strassen_max_depth
+ * INPUT: int n, double tolerance
+ * OUTPUT: int
+ * USAGE: the deepest recursion on n by n blocks (n a power of 2) whose
+ *          strassen_error_bound is within tolerance; 0 (the classical
+ *          algorithm) if none is. INT_MAX for bignums that do not round.
+ */
+int strassen_max_depth(int n, double tolerance);
+
+/**
+ * NAME: strassen_depth_limit
+ * INPUT: int n
+ * OUTPUT: int
+ * USAGE: strassen_max_depth for n with the tolerance in
+ *          STRASSEN_TOLERANCE, by default the square root of the unit
+ *          roundoff (about half of the digits).
+ *
+ * NOTES: strassen_mult, strassen_morton_mult and matrix_pow multiply
+ *          classically below this depth.
+ */
+int strassen_depth_limit(int n);
+
+#endif
@@ -0,0 +1,288 @@
+/*************************************************************************
+ * semiring.c
+ *
+ * Implements semiring products (see semiring.h). One set of classical
+ * kernels is stamped out per semiring by SEMIRING_KERNELS, so every
+ * inner loop calls its own combine and reduce steps directly rather
+ * than through function pointers, and an optimizing build can inline
+ * them. Each result starts from the k = 0 term instead of an identity,
+ * so min-plus and max-plus need no infinity.
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mult.h"
+#include "parallel.h"
+#include "semiring.h"
+#include "sparse.h"
+
+// side of the cache blocks of the blocked kernels
+#define SEMIRING_BLOCK 32
+
+/* COMBINE AND REDUCE STEPS */
+
+/**
+ * NAME: times_combine
+ * INPUT: BIGNUM* x, BIGNUM* y, BIGNUM* out
+ * USAGE: out = x * y.
+ */
+static inline void times_combine(BIGNUM* x, BIGNUM* y, BIGNUM* out)
+{
+    // mult_bignums adds into its result, so start from zero.
+    bignum_from_int(0, out);
+    mult_bignums(x, y, out);
+}
+
+/**
+ * NAME: plus_combine
+ * INPUT: BIGNUM* x, BIGNUM* y, BIGNUM* out
+ * USAGE: out = x + y.
+ */
+static inline void plus_combine(BIGNUM* x, BIGNUM* y, BIGNUM* out)
+{
+    add_bignums(x, y, out);
+}
+
+/**
+ * NAME: plus_reduce
+ * INPUT: BIGNUM* acc, BIGNUM* term
+ * USAGE: acc += term.
+ */
+static inline void plus_reduce(BIGNUM* acc, BIGNUM* term)
+{
+    BIGNUM sum;
+    add_bignums(acc, term, &sum);
+    *acc = sum;
+}
+
+/**
+ * NAME: min_reduce
+ * INPUT: BIGNUM* acc, BIGNUM* term
+ * USAGE: acc = min(acc, term).
+ */
+static inline void min_reduce(BIGNUM* acc, BIGNUM* term)
+{
+    if (bignum_compare(term, acc) < 0)
+        *acc = *term;
+}
+
+/**
+ * NAME: max_reduce
+ * INPUT: BIGNUM* acc, BIGNUM* term
+ * USAGE: acc = max(acc, term).
+ */
+static inline void max_reduce(BIGNUM* acc, BIGNUM* term)
+{
+    if (bignum_compare(term, acc) > 0)
+        *acc = *term;
+}
+
+/* KERNELS */
+
+// Arguments of the parallel blocked kernels.
+typedef struct
+{
+    MATRIX* m1;
+    MATRIX* m2;
+    MATRIX* res;
+}
+SEMIRING_ARGS;
+
+// Defines, for a semiring NAME with steps COMBINE and REDUCE:
+//   NAME_block   reduces the terms k in [k0, k1) into rows [i0, i1) and
+//                columns [j0, j1) of res
+//   NAME_blocks  parallel_for body running the blocked product on the
+//                row blocks [begin, end)
+//   NAME_mult    the whole product, classical or blocked
+#define SEMIRING_KERNELS(NAME, COMBINE, REDUCE) \
+    static void NAME##_block(MATRIX* m1, MATRIX* m2, MATRIX* res, int i0, int i1, \
+                             int k0, int k1, int j0, int j1) \
+    { \
+        BIGNUM term; \
+        for (int i = i0; i < i1; i++) \
+        { \
+            BIGNUM* out = res->matrix[i]; \
+            for (int k = k0; k < k1; k++) \
+            { \
+                BIGNUM* a = &m1->matrix[i][k]; \
+                BIGNUM* row = m2->matrix[k]; \
+                for (int j = j0; j < j1; j++) \
+                { \
+                    COMBINE(a, &row[j], &term); \
+                    REDUCE(&out[j], &term); \
+                } \
+            } \
+        } \
+    } \
+    \
+    static void NAME##_blocks(int begin, int end, void* arg) \
+    { \
+        SEMIRING_ARGS* args = arg; \
+        int rows = args->m1->numRows; \
+        int inner = args->m1->numCols; \
+        int cols = args->m2->numCols; \
+        for (int ib = begin; ib < end; ib++) \
+        { \
+            int i0 = ib * SEMIRING_BLOCK; \
+            int i1 = (i0 + SEMIRING_BLOCK < rows) ? i0 + SEMIRING_BLOCK : rows; \
+            for (int k0 = 0; k0 < inner; k0 += SEMIRING_BLOCK) \
+            { \
+                int k1 = (k0 + SEMIRING_BLOCK < inner) ? k0 + SEMIRING_BLOCK : inner; \
+                for (int j0 = 0; j0 < cols; j0 += SEMIRING_BLOCK) \
+                { \
+                    int j1 = (j0 + SEMIRING_BLOCK < cols) ? j0 + SEMIRING_BLOCK : cols; \
+                    NAME##_block(args->m1, args->m2, args->res, i0, i1, \
+                                 (k0 > 0) ? k0 : 1, k1, j0, j1); \
+                } \
+            } \
+        } \
+    } \
+    \
+    static void NAME##_mult(MATRIX* m1, MATRIX* m2, MATRIX* res, bool blocked) \
+    { \
+        /* Start every entry from its k = 0 term. */ \
+        alloc_matrix(m1->numRows, m2->numCols, res); \
+        for (int i = 0; i < m1->numRows; i++) \
+        { \
+            for (int j = 0; j < m2->numCols; j++) \
+                COMBINE(&m1->matrix[i][0], &m2->matrix[0][j], &res->matrix[i][j]); \
+        } \
+        \
+        if (blocked) \
+        { \
+            SEMIRING_ARGS args = {m1, m2, res}; \
+            parallel_for((m1->numRows + SEMIRING_BLOCK - 1) / SEMIRING_BLOCK, \
+                         NAME##_blocks, &args); \
+        } \
+        else \
+            NAME##_block(m1, m2, res, 0, m1->numRows, 1, m1->numCols, 0, m2->numCols); \
+    }
+
+SEMIRING_KERNELS(plus_times, times_combine, plus_reduce)
+SEMIRING_KERNELS(min_plus, plus_combine, min_reduce)
+SEMIRING_KERNELS(max_plus, plus_combine, max_reduce)
+
+/* DISPATCH */
+
+static const struct
+{
+    const char* name;
+    SEMIRING ring;
+    void (*mult)(MATRIX*, MATRIX*, MATRIX*, bool);
+}
+semirings[] =
+{
+    {"plus-times", SEMIRING_PLUS_TIMES, plus_times_mult},
+    {"min-plus", SEMIRING_MIN_PLUS, min_plus_mult},
+    {"max-plus", SEMIRING_MAX_PLUS, max_plus_mult},
+};
+#define NUM_SEMIRINGS (int) (sizeof(semirings) / sizeof(semirings[0]))
+
+// algorithms that assume (+, x), with whether they subtract
+static const struct
+{
+    const char* name;
+    void (*mult)(MATRIX*, MATRIX*, MATRIX*);
+    bool subtracts;
+}
+ringAlgorithms[] =
+{
+    {"winograd", winograd_mult, true},
+    {"strassen", strassen_mult, true},
+    {"morton", strassen_morton_mult, true},
+    {"rect", rect_mult, true},
+    {"recursive", recursive_mult, false},
+    {"sparse", sparse_matrix_mult, false},
+};
+#define NUM_RING_ALGORITHMS (int) (sizeof(ringAlgorithms) / sizeof(ringAlgorithms[0]))
+
+/**
+ * NAME: semiring_parse
+ * INPUT: const char* name, SEMIRING* ring
+ * OUTPUT: bool
+ * USAGE: parses "plus-times", "min-plus" or "max-plus" into ring.
+ */
+bool semiring_parse(const char* name, SEMIRING* ring)
+{
+    for (int s = 0; s < NUM_SEMIRINGS; s++)
+    {
+        if (strcmp(name, semirings[s].name) == 0)
+        {
+            *ring = semirings[s].ring;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * NAME: semiring_mult
+ * INPUT: const char* alg, SEMIRING ring, MATRIX* m1, MATRIX* m2,
+ *          MATRIX* res
+ * OUTPUT: bool
+ * USAGE: multiplies m1 and m2 over ring with the algorithm called alg
+ *          and stores the result in res. "regular" and "blocked" (the
+ *          classical product over cache blocks, on all threads) work
+ *          for every semiring; the algorithms of mult.h work for
+ *          plus-times only. Returns false, printing why, if alg does
+ *          not apply to ring or the matrices cannot be multiplied.
+ *
+ * NOTES: m1, m2, res must all be malloced before using this function.
+ *          Over min-plus and max-plus the inner dimension must not be
+ *          zero, as the empty sum would be infinite. They are refused
+ *          for bignums without an order (BIGNUM_UNORDERED), such as the
+ *          elements of GF(p), whose min and max would mean nothing.
+ */
+bool semiring_mult(const char* alg, SEMIRING ring, MATRIX* m1, MATRIX* m2, MATRIX* res)
+{
+    if (m1->numCols != m2->numRows)
+    {
+        printf("Error: Matrices cannot be multiplied\n");
+        return false;
+    }
+
+#ifdef BIGNUM_UNORDERED
+    if (ring != SEMIRING_PLUS_TIMES)
+    {
+        printf("Error: %s needs ordered values, and %s values have no order; "
+               "use plus-times\n", semirings[ring].name, bignum_type_name());
+        return false;
+    }
+#endif
+
+    if (strcmp(alg, "regular") == 0 || strcmp(alg, "blocked") == 0)
+    {
+        if (m1->numCols == 0 && ring != SEMIRING_PLUS_TIMES)
+        {
+            printf("Error: %s has no empty sum\n", semirings[ring].name);
+            return false;
+        }
+        if (m1->numCols == 0)
+            zero_matrix(m1->numRows, m2->numCols, res);
+        else
+            semirings[ring].mult(m1, m2, res, strcmp(alg, "blocked") == 0);
+        return true;
+    }
+
+    for (int a = 0; a < NUM_RING_ALGORITHMS; a++)
+    {
+        if (strcmp(alg, ringAlgorithms[a].name) != 0)
+            continue;
+        if (ring != SEMIRING_PLUS_TIMES)
+        {
+            if (ringAlgorithms[a].subtracts)
+                printf("Error: %s subtracts, and %s has no subtraction; "
+                       "use regular or blocked\n", alg, semirings[ring].name);
+            else
+                printf("Error: %s is plus-times only; use regular or blocked\n", alg);
+            return false;
+        }
+        ringAlgorithms[a].mult(m1, m2, res);
+        return true;
+    }
+
+    printf("Error: unknown algorithm %s\n", alg);
+    return false;
+}
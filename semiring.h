@@ -0,0 +1,57 @@
+/****************************************************************************
+ * semiring.h
+ *
+ * Computer Science 51
+ * Semiring Products
+ *
+ * Matrix products over semirings other than (+, x): (min, +) for
+ * all-pairs shortest paths and (max, +) for scheduling and longest
+ * paths. Only classical algorithms apply to these, because Strassen's
+ * and Winograd's algorithms subtract and min and max have no inverse;
+ * semiring_mult refuses them for such semirings.
+ ***************************************************************************/
+#ifndef _SEMIRING_H
+#define _SEMIRING_H
+
+#include <stdbool.h>
+
+#include "matrix.h"
+
+// the sum and product of a semiring
+typedef enum
+{
+    SEMIRING_PLUS_TIMES,    // (+, x), the usual product
+    SEMIRING_MIN_PLUS,      // (min, +), the tropical semiring
+    SEMIRING_MAX_PLUS       // (max, +)
+}
+SEMIRING;
+
+/**
+ * NAME: semiring_parse
+ * INPUT: const char* name, SEMIRING* ring
+ * OUTPUT: bool
+ * USAGE: parses "plus-times", "min-plus" or "max-plus" into ring.
+ */
+bool semiring_parse(const char* name, SEMIRING* ring);
+
+/**
+ * NAME: semiring_mult
+ * INPUT: const char* alg, SEMIRING ring, MATRIX* m1, MATRIX* m2,
+ *          MATRIX* res
+ * OUTPUT: bool
+ * USAGE: multiplies m1 and m2 over ring with the algorithm called alg
+ *          and stores the result in res. "regular" and "blocked" (the
+ *          classical product over cache blocks, on all threads) work
+ *          for every semiring; the algorithms of mult.h work for
+ *          plus-times only. Returns false, printing why, if alg does
+ *          not apply to ring or the matrices cannot be multiplied.
+ *
+ * NOTES: m1, m2, res must all be malloced before using this function.
+ *          Over min-plus and max-plus the inner dimension must not be
+ *          zero, as the empty sum would be infinite. They are refused
+ *          for bignums without an order (BIGNUM_UNORDERED), such as the
+ *          elements of GF(p), whose min and max would mean nothing.
+ */
+bool semiring_mult(const char* alg, SEMIRING ring, MATRIX* m1, MATRIX* m2, MATRIX* res);
+
+#endif
@@ -0,0 +1,430 @@
+/*************************************************************************
+ * sparse.c
+ *
+ * Implements CSR sparse matrices (see sparse.h). Conversion and both
+ * products are split over rows with parallel_for. sparse_mult first
+ * bounds the nonzeros of each result row from the column patterns
+ * alone (cheap integer work), reserves that much, computes every row
+ * into its slot with a dense accumulator per thread, and finally
+ * closes the gaps left by bounds that were too high.
+ ************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memtrack.h"
+#include "parallel.h"
+#include "sparse.h"
+
+/**
+ * NAME: sparse_start
+ * INPUT: int rowSize, int colSize, SPARSE* s
+ * USAGE: sets up s as rowSize by colSize with its row array allocated
+ *          (to be filled with counts) and no entries yet.
+ */
+static void sparse_start(int rowSize, int colSize, SPARSE* s)
+{
+    s->rowStart = malloc((rowSize + 1) * sizeof(int));
+    memtrack_alloc((rowSize + 1) * sizeof(int));
+    s->colIndex = NULL;
+    s->values = NULL;
+    s->nonzeros = 0;
+    s->numRows = rowSize;
+    s->numCols = colSize;
+}
+
+/**
+ * NAME: sparse_reserve
+ * INPUT: SPARSE* s, int nonzeros
+ * USAGE: allocates room for nonzeros entries in s.
+ */
+static void sparse_reserve(SPARSE* s, int nonzeros)
+{
+    s->colIndex = malloc(nonzeros * sizeof(int));
+    s->values = malloc(nonzeros * sizeof(BIGNUM));
+    memtrack_alloc(nonzeros * (sizeof(int) + sizeof(BIGNUM)));
+    s->nonzeros = nonzeros;
+}
+
+/**
+ * NAME: prefix_sum
+ * INPUT: int* counts, int n
+ * OUTPUT: int
+ * USAGE: turns counts[0..n-1] into their running starts, with the
+ *          total in counts[n], and returns the total.
+ */
+static int prefix_sum(int* counts, int n)
+{
+    int total = 0;
+    for (int i = 0; i < n; i++)
+    {
+        int count = counts[i];
+        counts[i] = total;
+        total += count;
+    }
+    counts[n] = total;
+    return total;
+}
+
+// Arguments of the parallel conversions.
+typedef struct
+{
+    MATRIX* m;
+    SPARSE* s;
+}
+CONVERT_ARGS;
+
+/**
+ * NAME: count_rows
+ * INPUT: int begin, int end, void* arg
+ * USAGE: parallel_for body counting the nonzeros of rows [begin, end)
+ *          into rowStart, for prefix_sum.
+ */
+static void count_rows(int begin, int end, void* arg)
+{
+    CONVERT_ARGS* args = arg;
+    for (int i = begin; i < end; i++)
+    {
+        int count = 0;
+        for (int j = 0; j < args->m->numCols; j++)
+            count += !bignum_is_zero(&args->m->matrix[i][j]);
+        args->s->rowStart[i] = count;
+    }
+}
+
+/**
+ * NAME: fill_rows
+ * INPUT: int begin, int end, void* arg
+ * USAGE: parallel_for body copying the nonzeros of rows [begin, end).
+ */
+static void fill_rows(int begin, int end, void* arg)
+{
+    CONVERT_ARGS* args = arg;
+    for (int i = begin; i < end; i++)
+    {
+        int k = args->s->rowStart[i];
+        for (int j = 0; j < args->m->numCols; j++)
+        {
+            if (!bignum_is_zero(&args->m->matrix[i][j]))
+            {
+                args->s->colIndex[k] = j;
+                args->s->values[k] = args->m->matrix[i][j];
+                k++;
+            }
+        }
+    }
+}
+
+/**
+ * NAME: sparse_from_matrix
+ * INPUT: MATRIX* m, SPARSE* s
+ * USAGE: makes s hold the nonzeros of m.
+ *
+ * NOTES: release s with sparse_free.
+ */
+void sparse_from_matrix(MATRIX* m, SPARSE* s)
+{
+    // Count the nonzeros of every row, then copy them.
+    sparse_start(m->numRows, m->numCols, s);
+    CONVERT_ARGS args = {m, s};
+    parallel_for(m->numRows, count_rows, &args);
+    sparse_reserve(s, prefix_sum(s->rowStart, m->numRows));
+    parallel_for(m->numRows, fill_rows, &args);
+}
+
+/**
+ * NAME: sparse_to_matrix
+ * INPUT: SPARSE* s, MATRIX* m
+ * USAGE: initializes m to the dense form of s.
+ *
+ * NOTES: assumes m is malloced.
+ */
+void sparse_to_matrix(SPARSE* s, MATRIX* m)
+{
+    zero_matrix(s->numRows, s->numCols, m);
+    for (int i = 0; i < s->numRows; i++)
+    {
+        for (int k = s->rowStart[i]; k < s->rowStart[i + 1]; k++)
+            m->matrix[i][s->colIndex[k]] = s->values[k];
+    }
+}
+
+/**
+ * NAME: add_product
+ * INPUT: BIGNUM* x, BIGNUM* y, BIGNUM* acc
+ * USAGE: acc += x * y.
+ */
+static void add_product(BIGNUM* x, BIGNUM* y, BIGNUM* acc)
+{
+    BIGNUM product, sum;
+
+    // mult_bignums adds into its result, so start from zero.
+    bignum_from_int(0, &product);
+    mult_bignums(x, y, &product);
+    add_bignums(acc, &product, &sum);
+    *acc = sum;
+}
+
+// Arguments of the parallel sparse by dense product.
+typedef struct
+{
+    SPARSE* a;
+    MATRIX* b;
+    MATRIX* res;
+}
+SPMM_ARGS;
+
+/**
+ * NAME: spmm_rows
+ * INPUT: int begin, int end, void* arg
+ * USAGE: parallel_for body computing rows [begin, end) of a * b: each
+ *          nonzero a[i][k] adds a[i][k] times row k of b to row i.
+ */
+static void spmm_rows(int begin, int end, void* arg)
+{
+    SPMM_ARGS* args = arg;
+    for (int i = begin; i < end; i++)
+    {
+        BIGNUM* out = args->res->matrix[i];
+        for (int k = args->a->rowStart[i]; k < args->a->rowStart[i + 1]; k++)
+        {
+            BIGNUM* row = args->b->matrix[args->a->colIndex[k]];
+            for (int j = 0; j < args->b->numCols; j++)
+                add_product(&args->a->values[k], &row[j], &out[j]);
+        }
+    }
+}
+
+/**
+ * NAME: sparse_dense_mult
+ * INPUT: SPARSE* a, MATRIX* b, MATRIX* res
+ * OUTPUT: bool
+ * USAGE: multiplies sparse a by dense b into dense res (SpMM). Returns
+ *          false if they cannot be multiplied.
+ *
+ * NOTES: assumes res is malloced.
+ */
+bool sparse_dense_mult(SPARSE* a, MATRIX* b, MATRIX* res)
+{
+    if (a->numCols != b->numRows)
+    {
+        printf("Error: Matrices cannot be multiplied");
+        return false;
+    }
+
+    zero_matrix(a->numRows, b->numCols, res);
+    SPMM_ARGS args = {a, b, res};
+    parallel_for(a->numRows, spmm_rows, &args);
+    return true;
+}
+
+// Arguments of the parallel sparse by sparse product.
+typedef struct
+{
+    SPARSE* a;
+    SPARSE* b;
+    SPARSE* res;
+    int* used;
+}
+SPGEMM_ARGS;
+
+/**
+ * NAME: bound_rows
+ * INPUT: int begin, int end, void* arg
+ * USAGE: parallel_for body bounding the nonzeros of rows [begin, end)
+ *          of a * b by the number of distinct columns they touch.
+ */
+static void bound_rows(int begin, int end, void* arg)
+{
+    SPGEMM_ARGS* args = arg;
+    SPARSE* a = args->a;
+    SPARSE* b = args->b;
+
+    // seen[j] == i + 1 once column j has been counted for row i
+    int* seen = calloc(b->numCols, sizeof(int));
+    for (int i = begin; i < end; i++)
+    {
+        int count = 0;
+        for (int k = a->rowStart[i]; k < a->rowStart[i + 1]; k++)
+        {
+            int row = a->colIndex[k];
+            for (int l = b->rowStart[row]; l < b->rowStart[row + 1]; l++)
+            {
+                if (seen[b->colIndex[l]] != i + 1)
+                {
+                    seen[b->colIndex[l]] = i + 1;
+                    count++;
+                }
+            }
+        }
+        args->res->rowStart[i] = count;
+    }
+    free(seen);
+}
+
+/**
+ * NAME: compare_ints
+ * INPUT: const void* x, const void* y
+ * OUTPUT: int
+ * USAGE: qsort comparison of ints.
+ */
+static int compare_ints(const void* x, const void* y)
+{
+    int a = *(const int*) x, b = *(const int*) y;
+    return (a > b) - (a < b);
+}
+
+/**
+ * NAME: spgemm_rows
+ * INPUT: int begin, int end, void* arg
+ * USAGE: parallel_for body computing rows [begin, end) of a * b into
+ *          their reserved slots, recording how many entries each keeps.
+ */
+static void spgemm_rows(int begin, int end, void* arg)
+{
+    SPGEMM_ARGS* args = arg;
+    SPARSE* a = args->a;
+    SPARSE* b = args->b;
+    SPARSE* res = args->res;
+
+    // Dense accumulator for one row, and the columns it holds.
+    BIGNUM* acc = malloc(b->numCols * sizeof(BIGNUM));
+    int* seen = calloc(b->numCols, sizeof(int));
+    for (int i = begin; i < end; i++)
+    {
+        int* cols = res->colIndex + res->rowStart[i];
+        int count = 0;
+        for (int k = a->rowStart[i]; k < a->rowStart[i + 1]; k++)
+        {
+            int row = a->colIndex[k];
+            for (int l = b->rowStart[row]; l < b->rowStart[row + 1]; l++)
+            {
+                int j = b->colIndex[l];
+                if (seen[j] != i + 1)
+                {
+                    seen[j] = i + 1;
+                    bignum_from_int(0, &acc[j]);
+                    cols[count++] = j;
+                }
+                add_product(&a->values[k], &b->values[l], &acc[j]);
+            }
+        }
+
+        // Gather in column order, leaving out entries that cancelled.
+        qsort(cols, count, sizeof(int), compare_ints);
+        BIGNUM* values = res->values + res->rowStart[i];
+        int kept = 0;
+        for (int c = 0; c < count; c++)
+        {
+            if (!bignum_is_zero(&acc[cols[c]]))
+            {
+                values[kept] = acc[cols[c]];
+                cols[kept++] = cols[c];
+            }
+        }
+        args->used[i] = kept;
+    }
+    free(acc);
+    free(seen);
+}
+
+/**
+ * NAME: sparse_mult
+ * INPUT: SPARSE* a, SPARSE* b, SPARSE* res
+ * OUTPUT: bool
+ * USAGE: multiplies sparse a by sparse b into sparse res (SpGEMM, by
+ *          Gustavson's algorithm with a dense accumulator). Entries that
+ *          cancel to zero are dropped. Returns false if they cannot be
+ *          multiplied.
+ *
+ * NOTES: release res with sparse_free.
+ */
+bool sparse_mult(SPARSE* a, SPARSE* b, SPARSE* res)
+{
+    if (a->numCols != b->numRows)
+    {
+        printf("Error: Matrices cannot be multiplied");
+        return false;
+    }
+
+    // Bound every row, then reserve the bounds.
+    sparse_start(a->numRows, b->numCols, res);
+    SPGEMM_ARGS args = {a, b, res, malloc(a->numRows * sizeof(int))};
+    parallel_for(a->numRows, bound_rows, &args);
+    sparse_reserve(res, prefix_sum(res->rowStart, a->numRows));
+    parallel_for(a->numRows, spgemm_rows, &args);
+
+    // Close the gaps left by cancelled entries, and give back the room.
+    int next = 0;
+    for (int i = 0; i < a->numRows; i++)
+    {
+        int start = res->rowStart[i];
+        memmove(res->colIndex + next, res->colIndex + start, args.used[i] * sizeof(int));
+        memmove(res->values + next, res->values + start, args.used[i] * sizeof(BIGNUM));
+        res->rowStart[i] = next;
+        next += args.used[i];
+    }
+    res->rowStart[a->numRows] = next;
+    free(args.used);
+
+    if (next < res->nonzeros)
+    {
+        if (next == 0)
+        {
+            free(res->colIndex);
+            free(res->values);
+            res->colIndex = NULL;
+            res->values = NULL;
+        }
+        else
+        {
+            res->colIndex = realloc(res->colIndex, next * sizeof(int));
+            res->values = realloc(res->values, next * sizeof(BIGNUM));
+        }
+        memtrack_release((res->nonzeros - next) * (sizeof(int) + sizeof(BIGNUM)));
+        res->nonzeros = next;
+    }
+    return true;
+}
+
+/**
+ * NAME: sparse_free
+ * INPUT: SPARSE* s
+ * USAGE: frees the storage of s.
+ */
+void sparse_free(SPARSE* s)
+{
+    memtrack_release((s->numRows + 1) * sizeof(int) +
+                     s->nonzeros * (sizeof(int) + sizeof(BIGNUM)));
+    free(s->rowStart);
+    free(s->colIndex);
+    free(s->values);
+}
+
+/**
+ * NAME: sparse_matrix_mult
+ * INPUT: MATRIX* m1, MATRIX* m2, MATRIX* res
+ * USAGE: Multiplies dense m1 and m2 by converting both to sparse form,
+ *          so the work scales with their nonzeros, and stores the
+ *          result in res.
+ *
+ * NOTES: m1, m2, res must all be malloced before using this function.
+ */
+void sparse_matrix_mult(MATRIX* m1, MATRIX* m2, MATRIX* res)
+{
+    SPARSE a, b, c;
+    if (m1->numCols != m2->numRows)
+    {
+        printf("Error: Matrices cannot be multiplied");
+        return;
+    }
+
+    sparse_from_matrix(m1, &a);
+    sparse_from_matrix(m2, &b);
+    sparse_mult(&a, &b, &c);
+    sparse_to_matrix(&c, res);
+    sparse_free(&a);
+    sparse_free(&b);
+    sparse_free(&c);
+}
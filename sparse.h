@@ -0,0 +1,92 @@
+/****************************************************************************
+ * sparse.h
+ *
+ * Computer Science 51
+ * Sparse Matrices
+ *
+ * A compressed sparse row (CSR) matrix type alongside MATRIX, for
+ * operands that are mostly zeros. Only the nonzeros are stored: row i
+ * holds the entries rowStart[i] to rowStart[i + 1] - 1 of colIndex and
+ * values, in increasing column order. Products work row by row in
+ * parallel and take time and memory in proportion to the nonzeros.
+ ***************************************************************************/
+#ifndef _SPARSE_H
+#define _SPARSE_H
+
+#include <stdbool.h>
+
+#include "matrix.h"
+
+// A sparse matrix in CSR form.
+typedef struct
+{
+    int* rowStart;
+    int* colIndex;
+    BIGNUM* values;
+    int nonzeros;
+    int numRows;
+    int numCols;
+}
+SPARSE;
+
+/**
+ * NAME: sparse_from_matrix
+ * INPUT: MATRIX* m, SPARSE* s
+ * USAGE: makes s hold the nonzeros of m.
+ *
+ * NOTES: release s with sparse_free.
+ */
+void sparse_from_matrix(MATRIX* m, SPARSE* s);
+
+/**
+ * NAME: sparse_to_matrix
+ * INPUT: SPARSE* s, MATRIX* m
+ * USAGE: initializes m to the dense form of s.
+ *
+ * NOTES: assumes m is malloced.
+ */
+void sparse_to_matrix(SPARSE* s, MATRIX* m);
+
+/**
+ * NAME: sparse_dense_mult
+ * INPUT: SPARSE* a, MATRIX* b, MATRIX* res
+ * OUTPUT: bool
+ * USAGE: multiplies sparse a by dense b into dense res (SpMM). Returns
+ *          false if they cannot be multiplied.
+ *
+ * NOTES: assumes res is malloced.
+ */
+bool sparse_dense_mult(SPARSE* a, MATRIX* b, MATRIX* res);
+
+/**
+ * NAME: sparse_mult
+ * INPUT: SPARSE* a, SPARSE* b, SPARSE* res
+ * OUTPUT: bool
+ * USAGE: multiplies sparse a by sparse b into sparse res (SpGEMM, by
+ *          Gustavson's algorithm with a dense accumulator). Entries that
+ *          cancel to zero are dropped. Returns false if they cannot be
+ *          multiplied.
+ *
+ * NOTES: release res with sparse_free.
+ */
+bool sparse_mult(SPARSE* a, SPARSE* b, SPARSE* res);
+
+/**
+ * NAME: sparse_free
+ * INPUT: SPARSE* s
+ * USAGE: frees the storage of s.
+ */
+void sparse_free(SPARSE* s);
+
+/**
+ * NAME: sparse_matrix_mult
+ * INPUT: MATRIX* m1, MATRIX* m2, MATRIX* res
+ * USAGE: Multiplies dense m1 and m2 by converting both to sparse form,
+ *          so the work scales with their nonzeros, and stores the
+ *          result in res.
+ *
+ * NOTES: m1, m2, res must all be malloced before using this function.
+ */
+void sparse_matrix_mult(MATRIX* m1, MATRIX* m2, MATRIX* res);
+
+#endif
@@ -9,6 +9,7 @@
  * "make strassen" and "make intstrassen" will compile the required files.
  ************************************************************************/
  
+#include <limits.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -17,6 +18,46 @@
 
 #include "matrix.h"
 #include "bignum.h"
+#include "gen.h"
+#include "memtrack.h"
+#include "morton.h"
+#include "mult.h"
+#include "perfcount.h"
+#include "planes.h"
+#include "rounding.h"
+#include "trace.h"
+#include "verify.h"
+
+// Instrumented phases, see perfcount.h. The recursive products are not
+// a phase of their own, so each phase below is exclusive of recursion.
+static PERF_PHASE padPhase = PERF_PHASE_INIT("strassen pad");
+static PERF_PHASE splitPhase = PERF_PHASE_INIT("strassen split");
+static PERF_PHASE sumPhase = PERF_PHASE_INIT("strassen operand sums");
+// The base case runs once per leaf, so it is sampled (see perfcount.h).
+static PERF_PHASE basePhase = PERF_PHASE_SAMPLED("strassen base case", 16);
+static PERF_PHASE combinePhase = PERF_PHASE_INIT("strassen combine");
+static PERF_PHASE stripPhase = PERF_PHASE_INIT("strassen strip");
+
+// Trace event names for each node, indexed by product number.
+static const char* productNames[8] =
+    {"strassen", "x1", "x2", "x3", "x4", "x5", "x6", "x7"};
+
+/* ROUNDING ERROR */
+
+// Depth at which the helpers stop recursing and multiply classically.
+// Each driver sets it with set_depth_limit before recursing.
+static int depthLimit = INT_MAX;
+
+/**
+ * NAME: set_depth_limit
+ * INPUT: int n
+ * USAGE: sets depthLimit for products of n by n blocks (see
+ *          strassen_depth_limit in rounding.h).
+ */
+static void set_depth_limit(int n)
+{
+    depthLimit = strassen_depth_limit(n);
+}
 
 /* STRASSEN HELPER FUNCTIONS */
 
@@ -45,23 +86,15 @@ int next_power(int n)
 
 /**
  * NAME: pad_matrix
- * INPUT: MATRIX* mOrig, MARIX* mNew
- * USAGE: Converts a matrix to the smallest 2^n by 2^n square matrix.
+ * INPUT: MATRIX* mOrig, MARIX* mNew, int newDims
+ * USAGE: Converts a matrix to a newDims by newDims square matrix.
  *          Pads missing values with 0.  Stores the result in mNew.
  *          Original Input is unmodified.
  * 
  * NOTES: Assumes mOrig and mNew are already initalized.
  */
-void pad_matrix(MATRIX* mOrig, MATRIX* mNew)
+void pad_matrix(MATRIX* mOrig, MATRIX* mNew, int newDims)
 {
-    // Calculate the new dimensions.
-    int origDims;
-    if(mOrig->numRows > mOrig->numCols)
-        origDims = mOrig->numRows;
-    else
-        origDims = mOrig->numCols;
-    int newDims = next_power(origDims);
-
     // Allocate memory for the new matrix and add zeros.
     zero_matrix(newDims, newDims, mNew);
     for(int i = 0; i < newDims; i++)
@@ -95,9 +128,17 @@ void strassen_preprocess(MATRIX* mOrig1, MATRIX* mOrig2, MATRIX* mNew1, MATRIX*
         return;
     }
     
-    // Pad matrices.
-    pad_matrix(mOrig1, mNew1);
-    pad_matrix(mOrig2, mNew2);   
+    // Pad both matrices to the same 2^n size, large enough for every
+    // dimension, so rectangular inputs line up.
+    int origDims = mOrig1->numRows;
+    if (mOrig1->numCols > origDims)
+        origDims = mOrig1->numCols;
+    if (mOrig2->numCols > origDims)
+        origDims = mOrig2->numCols;
+    int newDims = next_power(origDims);
+
+    pad_matrix(mOrig1, mNew1, newDims);
+    pad_matrix(mOrig2, mNew2, newDims);
 }
 
 /**
@@ -122,27 +163,36 @@ void strassen_postprocess(MATRIX* mOrig, MATRIX* mNew, int colSize, int rowSize)
 
 /* STRASSEN ALGORITHM FUNCTIONS */
 /**
- * NAME: strassen_postprocess
- * INPUT: MATRIX* mOrig, MATRIX* mNew2, int colSize, int rowSize
- * USAGE: Strips zeros from mOrig and outputs a new rowSize by colSize matrix.
+ * NAME: strassen_helper
+ * INPUT: MATRIX* m1, MATRIX* m2, MATRIX* res, int depth, int product
+ * USAGE: Multiplies the 2^n by 2^n matrices m1 and m2 recursively and
+ *          stores the result in res. depth is the recursion level, 0 at
+ *          the top, and product is which of the parent's x1..x7 this
+ *          node computes (0 at the top).
  * 
- * NOTES: Assumes all inputs are already initialized.
+ * NOTES: res must be initialized to zeros.
  */
-void strassen_helper(MATRIX* m1, MATRIX* m2, MATRIX* res)
+void strassen_helper(MATRIX* m1, MATRIX* m2, MATRIX* res, int depth, int product)
 {
+    trace_begin(productNames[product], depth, m1->numRows, product);
+    memtrack_push(depth, MEM_SPLIT);
+
     // base case
-    if (m1->numRows <= 1)
+    if (m1->numRows <= 1 || depth >= depthLimit)
     {
-        mult_bignums(&m1->matrix[0][0], &m2->matrix[0][0], &res->matrix[0][0]);
+        perf_begin(&basePhase);
+        multiply_accumulate(m1, m2, res);
+        perf_end(&basePhase);
     }
     else
     {
         // split mOrig1 & mOrig2 into a 2x2 of submatrices
         int n = m1->numRows/2;
         
-
+        perf_begin(&splitPhase);
+        trace_begin("split", depth, n, product);
            
-        // Initialize submatrices    
+        // Submatrices are views into m1 and m2, so nothing is copied.
         MATRIX* a11 = malloc(sizeof(MATRIX));
         MATRIX* a12 = malloc(sizeof(MATRIX));
         MATRIX* a21 = malloc(sizeof(MATRIX));
@@ -151,33 +201,17 @@ void strassen_helper(MATRIX* m1, MATRIX* m2, MATRIX* res)
         MATRIX* b12 = malloc(sizeof(MATRIX));
         MATRIX* b21 = malloc(sizeof(MATRIX));
         MATRIX* b22 = malloc(sizeof(MATRIX));
-        zero_matrix(n,n,a11);
-        zero_matrix(n,n,a12);
-        zero_matrix(n,n,a21);
-        zero_matrix(n,n,a22);
-        zero_matrix(n,n,b11);
-        zero_matrix(n,n,b12);
-        zero_matrix(n,n,b21);
-        zero_matrix(n,n,b22);
-        
-        // Strassens algorithm
-        for (int i = 0; i < n; i++)
-        {
-            for (int j = 0; j < n; j++)
-            {
-                // First matrix
-                a11->matrix[i][j] = m1->matrix[i][j];          
-                a12->matrix[i][j] = m1->matrix[i][j+n];   
-                a21->matrix[i][j] = m1->matrix[i+n][j];    
-                a22->matrix[i][j] = m1->matrix[i+n][j+n];
-             
-                // Second matrix
-                b11->matrix[i][j] = m2->matrix[i][j];            
-                b12->matrix[i][j] = m2->matrix[i][j+n];    
-                b21->matrix[i][j] = m2->matrix[i+n][j];    
-                b22->matrix[i][j] = m2->matrix[i+n][j+n]; 
-            }
-        }
+        view_matrix(m1, 0, 0, n, n, a11);
+        view_matrix(m1, 0, n, n, n, a12);
+        view_matrix(m1, n, 0, n, n, a21);
+        view_matrix(m1, n, n, n, n, a22);
+        view_matrix(m2, 0, 0, n, n, b11);
+        view_matrix(m2, 0, n, n, n, b12);
+        view_matrix(m2, n, 0, n, n, b21);
+        view_matrix(m2, n, n, n, n, b22);
+
+        trace_end("split");
+        perf_end(&splitPhase);
 
         // Create two temporary matrices
         MATRIX* temp1 = malloc(sizeof(MATRIX));
@@ -202,39 +236,58 @@ void strassen_helper(MATRIX* m1, MATRIX* m2, MATRIX* res)
         zero_matrix(n,n,x7);
         
         // Fill those 7 matrices with the correct values
+        memtrack_phase(MEM_PRODUCTS);
+        perf_begin(&sumPhase);
         add_matrices(a11, a22, temp1);
         add_matrices(b11, b22, temp2);
-        strassen_helper(temp1, temp2, x1); 
+        perf_end(&sumPhase);
+        strassen_helper(temp1, temp2, x1, depth + 1, 1); 
 
+        perf_begin(&sumPhase);
         add_matrices(a21, a22, temp1);
-        strassen_helper(temp1, b11, x2);
+        perf_end(&sumPhase);
+        strassen_helper(temp1, b11, x2, depth + 1, 2);
 
+        perf_begin(&sumPhase);
         subtract_matrices(b12, b22, temp2);
-        strassen_helper(a11, temp2, x3);
+        perf_end(&sumPhase);
+        strassen_helper(a11, temp2, x3, depth + 1, 3);
 
+        perf_begin(&sumPhase);
         subtract_matrices(b21, b11, temp2);
-        strassen_helper(a22, temp2, x4);
+        perf_end(&sumPhase);
+        strassen_helper(a22, temp2, x4, depth + 1, 4);
 
+        perf_begin(&sumPhase);
         add_matrices(a11, a12, temp1);
-        strassen_helper(temp1, b22, x5);  
+        perf_end(&sumPhase);
+        strassen_helper(temp1, b22, x5, depth + 1, 5);  
 
+        perf_begin(&sumPhase);
         subtract_matrices(a21, a11, temp1);
         add_matrices(b11, b12, temp2);      
-        strassen_helper(temp1, temp2, x6);
+        perf_end(&sumPhase);
+        strassen_helper(temp1, temp2, x6, depth + 1, 6);
         
+        perf_begin(&sumPhase);
         subtract_matrices(a12, a22, temp1);
         add_matrices(b21, b22, temp2);
-        strassen_helper(temp1, temp2, x7);
+        perf_end(&sumPhase);
+        strassen_helper(temp1, temp2, x7, depth + 1, 7);
 
-        // 4 temporary result submatrices
+        perf_begin(&combinePhase);
+        trace_begin("combine", depth, n, product);
+        memtrack_phase(MEM_COMBINE);
+
+        // The quadrants of res are views, so results land in place.
         MATRIX* res11 = malloc(sizeof(MATRIX));
         MATRIX* res12 = malloc(sizeof(MATRIX));
         MATRIX* res21 = malloc(sizeof(MATRIX));
         MATRIX* res22 = malloc(sizeof(MATRIX));
-        zero_matrix(n, n, res11);
-        zero_matrix(n, n, res12);
-        zero_matrix(n, n, res21);
-        zero_matrix(n, n, res22);
+        view_matrix(res, 0, 0, n, n, res11);
+        view_matrix(res, 0, n, n, n, res12);
+        view_matrix(res, n, 0, n, n, res21);
+        view_matrix(res, n, n, n, n, res22);
 
         add_matrices(x3, x5, res12);
         add_matrices(x2, x4, res21);
@@ -247,29 +300,15 @@ void strassen_helper(MATRIX* m1, MATRIX* m2, MATRIX* res)
         add_matrices(temp1, x6, temp2);
         subtract_matrices(temp2, x2, res22);
 
-
-        // Group submatrices
-        for (int i=0; i<n; i++)
-        {
-            for (int j=0; j<n; j++)
-            {
-                // first matrix
-                res->matrix[i][j] = res11->matrix[i][j];
-                res->matrix[i][j+n] = res12->matrix[i][j];
-                res->matrix[i+n][j] = res21->matrix[i][j];
-                res->matrix[i+n][j+n] = res22->matrix[i][j];
-            }
-        }
-        
         // Free all matrices.
-        free_matrix(a11);
-        free_matrix(a12);
-        free_matrix(a21);
-        free_matrix(a22);
-        free_matrix(b11);
-        free_matrix(b12);
-        free_matrix(b21);
-        free_matrix(b22);
+        free_view(a11);
+        free_view(a12);
+        free_view(a21);
+        free_view(a22);
+        free_view(b11);
+        free_view(b12);
+        free_view(b21);
+        free_view(b22);
         free_matrix(temp1);
         free_matrix(temp2);
         free_matrix(x1);
@@ -279,21 +318,547 @@ void strassen_helper(MATRIX* m1, MATRIX* m2, MATRIX* res)
         free_matrix(x5);
         free_matrix(x6);
         free_matrix(x7);
-        free_matrix(res11);
-        free_matrix(res12);
-        free_matrix(res21);
-        free_matrix(res22);
+        free_view(res11);
+        free_view(res12);
+        free_view(res21);
+        free_view(res22);
+        trace_end("combine");
+        perf_end(&combinePhase);
+    }
+    
+    memtrack_pop();
+    trace_end(productNames[product]);
+}
+
+/* MORTON LAYOUT */
+
+/**
+ * NAME: block_add
+ * INPUT: BIGNUM* x, BIGNUM* y, BIGNUM* out, size_t len, bool subtract
+ * USAGE: out = x + y (or x - y) over len contiguous cells.
+ */
+static void block_add(BIGNUM* x, BIGNUM* y, BIGNUM* out, size_t len, bool subtract)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        if (subtract)
+        {
+            BIGNUM negated = y[i];
+            negate_bignums(&negated);
+            add_bignums(&x[i], &negated, &out[i]);
+        }
+        else
+            add_bignums(&x[i], &y[i], &out[i]);
+    }
+}
+
+/**
+ * NAME: block_accumulate
+ * INPUT: BIGNUM* c, BIGNUM* p, size_t len, bool subtract
+ * USAGE: c += p (or c -= p) over len contiguous cells.
+ */
+static void block_accumulate(BIGNUM* c, BIGNUM* p, size_t len, bool subtract)
+{
+    BIGNUM sum;
+    for (size_t i = 0; i < len; i++)
+    {
+        BIGNUM term = p[i];
+        if (subtract)
+            negate_bignums(&term);
+        add_bignums(&c[i], &term, &sum);
+        c[i] = sum;
     }
 }
 
-// Helper function to multiply two matrices smartly
+/**
+ * NAME: leaf_multiply
+ * INPUT: BIGNUM* a, BIGNUM* b, BIGNUM* c, int n
+ * USAGE: c = a * b for n by n row-major tiles.
+ */
+static void leaf_multiply(BIGNUM* a, BIGNUM* b, BIGNUM* c, int n)
+{
+    for (int i = 0; i < n * n; i++)
+        bignum_from_int(0, &c[i]);
+    for (int i = 0; i < n; i++)
+    {
+        for (int k = 0; k < n; k++)
+        {
+#ifdef BIGNUM_AXPY
+            bignum_axpy(&c[i * n], &a[i * n + k], &b[k * n], n);
+#else
+            BIGNUM product, sum;
+            for (int j = 0; j < n; j++)
+            {
+                bignum_from_int(0, &product);
+                mult_bignums(&a[i * n + k], &b[k * n + j], &product);
+                add_bignums(&c[i * n + j], &product, &sum);
+                c[i * n + j] = sum;
+            }
+#endif
+        }
+    }
+}
+
+/**
+ * NAME: morton_classical
+ * INPUT: BIGNUM* a, BIGNUM* b, BIGNUM* c, int n, int tile, BIGNUM* ws
+ * USAGE: c = a * b for n by n blocks in Morton layout with the
+ *          classical algorithm, quadrant by quadrant down to the tiles,
+ *          using ws as strassen_morton_helper does.
+ */
+static void morton_classical(BIGNUM* a, BIGNUM* b, BIGNUM* c, int n, int tile, BIGNUM* ws)
+{
+    if (n <= tile)
+    {
+        leaf_multiply(a, b, c, n);
+        return;
+    }
+
+    // c(i, j) = a(i, 1) b(1, j) + a(i, 2) b(2, j), the second product
+    // going through p.
+    int h = n / 2;
+    size_t q = (size_t) h * h;
+    BIGNUM *p = ws, *next = ws + 3 * q;
+    for (int i = 0; i < 2; i++)
+    {
+        for (int j = 0; j < 2; j++)
+        {
+            BIGNUM* cij = c + (2 * i + j) * q;
+            morton_classical(a + (2 * i) * q, b + j * q, cij, h, tile, next);
+            morton_classical(a + (2 * i + 1) * q, b + (2 + j) * q, p, h, tile, next);
+            block_accumulate(cij, p, q, false);
+        }
+    }
+}
+
+/**
+ * NAME: strassen_workspace_size
+ * INPUT: int n, int tile
+ * OUTPUT: size_t
+ * USAGE: cells of workspace strassen_morton_helper needs for n by n
+ *          blocks: three quadrants at each level above the tiles.
+ */
+size_t strassen_workspace_size(int n, int tile)
+{
+    size_t cells = 0;
+    for (; n > tile; n /= 2)
+        cells += 3 * (size_t) (n / 2) * (n / 2);
+    return cells;
+}
+
+/**
+ * NAME: strassen_morton_helper
+ * INPUT: BIGNUM* a, BIGNUM* b, BIGNUM* c, int n, int tile, BIGNUM* ws,
+ *          int depth, int product
+ * USAGE: c = a * b for n by n blocks in Morton layout, using ws (see
+ *          strassen_workspace_size) for temporaries. depth and product
+ *          are as for strassen_helper.
+ *
+ * NOTES: each product is added into the quadrants of c that use it as
+ *          soon as it is computed, so a level needs only two operand
+ *          sums and one product at a time. If a and b are the same
+ *          block (a square), the first product is a square too and its
+ *          operand sum is formed once.
+ */
+void strassen_morton_helper(BIGNUM* a, BIGNUM* b, BIGNUM* c, int n, int tile,
+                            BIGNUM* ws, int depth, int product)
+{
+    trace_begin(productNames[product], depth, n, product);
+
+    // base case
+    if (n <= tile || depth >= depthLimit)
+    {
+        perf_begin(&basePhase);
+        morton_classical(a, b, c, n, tile, ws);
+        perf_end(&basePhase);
+        trace_end(productNames[product]);
+        return;
+    }
+
+    // Quadrants are contiguous runs of q cells.
+    int h = n / 2;
+    size_t q = (size_t) h * h;
+    BIGNUM *a11 = a, *a12 = a + q, *a21 = a + 2 * q, *a22 = a + 3 * q;
+    BIGNUM *b11 = b, *b12 = b + q, *b21 = b + 2 * q, *b22 = b + 3 * q;
+    BIGNUM *c11 = c, *c12 = c + q, *c21 = c + 2 * q, *c22 = c + 3 * q;
+    BIGNUM *t1 = ws, *t2 = ws + q, *p = ws + 2 * q, *next = ws + 3 * q;
+
+    bool square = (a == b);
+    perf_begin(&sumPhase);
+    block_add(a11, a22, t1, q, false);
+    if (!square)
+        block_add(b11, b22, t2, q, false);
+    perf_end(&sumPhase);
+    strassen_morton_helper(t1, square ? t1 : t2, p, h, tile, next, depth + 1, 1);
+    perf_begin(&combinePhase);
+    memcpy(c11, p, q * sizeof(BIGNUM));
+    memcpy(c22, p, q * sizeof(BIGNUM));
+    perf_end(&combinePhase);
+
+    perf_begin(&sumPhase);
+    block_add(a21, a22, t1, q, false);
+    perf_end(&sumPhase);
+    strassen_morton_helper(t1, b11, p, h, tile, next, depth + 1, 2);
+    perf_begin(&combinePhase);
+    memcpy(c21, p, q * sizeof(BIGNUM));
+    block_accumulate(c22, p, q, true);
+    perf_end(&combinePhase);
+
+    perf_begin(&sumPhase);
+    block_add(b12, b22, t2, q, true);
+    perf_end(&sumPhase);
+    strassen_morton_helper(a11, t2, p, h, tile, next, depth + 1, 3);
+    perf_begin(&combinePhase);
+    memcpy(c12, p, q * sizeof(BIGNUM));
+    block_accumulate(c22, p, q, false);
+    perf_end(&combinePhase);
+
+    perf_begin(&sumPhase);
+    block_add(b21, b11, t2, q, true);
+    perf_end(&sumPhase);
+    strassen_morton_helper(a22, t2, p, h, tile, next, depth + 1, 4);
+    perf_begin(&combinePhase);
+    block_accumulate(c11, p, q, false);
+    block_accumulate(c21, p, q, false);
+    perf_end(&combinePhase);
+
+    perf_begin(&sumPhase);
+    block_add(a11, a12, t1, q, false);
+    perf_end(&sumPhase);
+    strassen_morton_helper(t1, b22, p, h, tile, next, depth + 1, 5);
+    perf_begin(&combinePhase);
+    block_accumulate(c11, p, q, true);
+    block_accumulate(c12, p, q, false);
+    perf_end(&combinePhase);
+
+    perf_begin(&sumPhase);
+    block_add(a21, a11, t1, q, true);
+    block_add(b11, b12, t2, q, false);
+    perf_end(&sumPhase);
+    strassen_morton_helper(t1, t2, p, h, tile, next, depth + 1, 6);
+    perf_begin(&combinePhase);
+    block_accumulate(c22, p, q, false);
+    perf_end(&combinePhase);
+
+    perf_begin(&sumPhase);
+    block_add(a12, a22, t1, q, true);
+    block_add(b21, b22, t2, q, false);
+    perf_end(&sumPhase);
+    strassen_morton_helper(t1, t2, p, h, tile, next, depth + 1, 7);
+    perf_begin(&combinePhase);
+    block_accumulate(c11, p, q, false);
+    perf_end(&combinePhase);
+
+    trace_end(productNames[product]);
+}
+
+/**
+ * NAME: strassen_morton_mult
+ * INPUT: MATRIX* mOrig1, MATRIX* mOrig2, MATRIX* res
+ * USAGE: Multiplies mOrig1 and mOrig2 using Strassen's algorithm on
+ *           Morton layout copies and stores the result in res.
+ *
+ * NOTES: mOrig1, mOrig2, res must all be malloced before using this function.
+ */
+void strassen_morton_mult(MATRIX* mOrig1, MATRIX* mOrig2, MATRIX* res)
+{
+    if (mOrig1->numCols != mOrig2->numRows)
+    {
+        printf("Error: Matrices cannot be multiplied");
+        return;
+    }
+
+    int origDims = mOrig1->numRows;
+    if (mOrig1->numCols > origDims)
+        origDims = mOrig1->numCols;
+    if (mOrig2->numCols > origDims)
+        origDims = mOrig2->numCols;
+    int n = next_power(origDims);
+
+    // Convert to Morton layout; padding happens on the way.
+    MORTON a, b, c;
+    perf_begin(&padPhase);
+    morton_from_matrix(mOrig1, n, &a);
+    morton_from_matrix(mOrig2, n, &b);
+    morton_alloc(n, &c);
+    perf_end(&padPhase);
+
+    size_t wsCells = strassen_workspace_size(n, c.tile);
+    BIGNUM* ws = malloc(wsCells * sizeof(BIGNUM));
+    memtrack_alloc(wsCells * sizeof(BIGNUM));
+
+    set_depth_limit(n);
+    strassen_morton_helper(a.data, b.data, c.data, n, c.tile, ws, 0, 0);
+
+    perf_begin(&stripPhase);
+    morton_to_matrix(&c, mOrig1->numRows, mOrig2->numCols, res);
+    perf_end(&stripPhase);
+
+    free(ws);
+    memtrack_release(wsCells * sizeof(BIGNUM));
+    morton_free(&a);
+    morton_free(&b);
+    morton_free(&c);
+}
+
+/* DIGIT PLANES */
+
+#ifdef BIGNUM_DIGITS
+
+// Scratch shared by the whole recursion: carries for planes_add, and
+// room for two tiles of operands and one of product as BIGNUMs.
+typedef struct
+{
+    int tile;
+    unsigned char* carry;
+    BIGNUM* leaf;
+}
+PLANES_SCRATCH;
+
+/**
+ * NAME: planes_leaf
+ * INPUT: PLANES* a, PLANES* b, PLANES* c, int n, PLANES_SCRATCH* s
+ * USAGE: c = a * b for n by n row-major tiles in digit planes, done on
+ *          BIGNUMs decoded from them.
+ */
+static void planes_leaf(PLANES* a, PLANES* b, PLANES* c, int n, PLANES_SCRATCH* s)
+{
+    size_t cells = (size_t) n * n;
+    BIGNUM *la = s->leaf, *lb = s->leaf + cells, *lc = s->leaf + 2 * cells;
+    planes_decode(a, cells, la);
+    if (b->digits == a->digits)
+        lb = la;
+    else
+        planes_decode(b, cells, lb);
+    leaf_multiply(la, lb, lc, n);
+    planes_encode(lc, cells, c);
+}
+
+/**
+ * NAME: strassen_planes_helper
+ * INPUT: PLANES* a, PLANES* b, PLANES* c, int n, PLANES* ws,
+ *          PLANES_SCRATCH* s, int depth, int product
+ * USAGE: c = a * b for n by n blocks in Morton order held in digit
+ *          planes, as strassen_morton_helper does for BIGNUMs, with ws
+ *          holding strassen_workspace_size(n, s->tile) values.
+ *
+ * NOTES: these bignums do not round, so depthLimit never stops the
+ *          recursion above the tiles.
+ */
+static void strassen_planes_helper(PLANES* a, PLANES* b, PLANES* c, int n, PLANES* ws,
+                                   PLANES_SCRATCH* s, int depth, int product)
+{
+    trace_begin(productNames[product], depth, n, product);
+
+    // base case
+    if (n <= s->tile)
+    {
+        perf_begin(&basePhase);
+        planes_leaf(a, b, c, n, s);
+        perf_end(&basePhase);
+        trace_end(productNames[product]);
+        return;
+    }
+
+    int h = n / 2;
+    size_t q = (size_t) h * h;
+    PLANES a11 = *a, a12 = planes_view(a, q), a21 = planes_view(a, 2 * q), a22 = planes_view(a, 3 * q);
+    PLANES b11 = *b, b12 = planes_view(b, q), b21 = planes_view(b, 2 * q), b22 = planes_view(b, 3 * q);
+    PLANES c11 = *c, c12 = planes_view(c, q), c21 = planes_view(c, 2 * q), c22 = planes_view(c, 3 * q);
+    PLANES t1 = *ws, t2 = planes_view(ws, q), p = planes_view(ws, 2 * q), next = planes_view(ws, 3 * q);
+    unsigned char* carry = s->carry;
+
+    bool square = (a->digits == b->digits);
+    perf_begin(&sumPhase);
+    planes_add(&a11, &a22, &t1, q, false, carry);
+    if (!square)
+        planes_add(&b11, &b22, &t2, q, false, carry);
+    perf_end(&sumPhase);
+    strassen_planes_helper(&t1, square ? &t1 : &t2, &p, h, &next, s, depth + 1, 1);
+    perf_begin(&combinePhase);
+    planes_copy(&p, &c11, q);
+    planes_copy(&p, &c22, q);
+    perf_end(&combinePhase);
+
+    perf_begin(&sumPhase);
+    planes_add(&a21, &a22, &t1, q, false, carry);
+    perf_end(&sumPhase);
+    strassen_planes_helper(&t1, &b11, &p, h, &next, s, depth + 1, 2);
+    perf_begin(&combinePhase);
+    planes_copy(&p, &c21, q);
+    planes_add(&c22, &p, &c22, q, true, carry);
+    perf_end(&combinePhase);
+
+    perf_begin(&sumPhase);
+    planes_add(&b12, &b22, &t2, q, true, carry);
+    perf_end(&sumPhase);
+    strassen_planes_helper(&a11, &t2, &p, h, &next, s, depth + 1, 3);
+    perf_begin(&combinePhase);
+    planes_copy(&p, &c12, q);
+    planes_add(&c22, &p, &c22, q, false, carry);
+    perf_end(&combinePhase);
+
+    perf_begin(&sumPhase);
+    planes_add(&b21, &b11, &t2, q, true, carry);
+    perf_end(&sumPhase);
+    strassen_planes_helper(&a22, &t2, &p, h, &next, s, depth + 1, 4);
+    perf_begin(&combinePhase);
+    planes_add(&c11, &p, &c11, q, false, carry);
+    planes_add(&c21, &p, &c21, q, false, carry);
+    perf_end(&combinePhase);
+
+    perf_begin(&sumPhase);
+    planes_add(&a11, &a12, &t1, q, false, carry);
+    perf_end(&sumPhase);
+    strassen_planes_helper(&t1, &b22, &p, h, &next, s, depth + 1, 5);
+    perf_begin(&combinePhase);
+    planes_add(&c11, &p, &c11, q, true, carry);
+    planes_add(&c12, &p, &c12, q, false, carry);
+    perf_end(&combinePhase);
+
+    perf_begin(&sumPhase);
+    planes_add(&a21, &a11, &t1, q, true, carry);
+    planes_add(&b11, &b12, &t2, q, false, carry);
+    perf_end(&sumPhase);
+    strassen_planes_helper(&t1, &t2, &p, h, &next, s, depth + 1, 6);
+    perf_begin(&combinePhase);
+    planes_add(&c22, &p, &c22, q, false, carry);
+    perf_end(&combinePhase);
+
+    perf_begin(&sumPhase);
+    planes_add(&a12, &a22, &t1, q, true, carry);
+    planes_add(&b21, &b22, &t2, q, false, carry);
+    perf_end(&sumPhase);
+    strassen_planes_helper(&t1, &t2, &p, h, &next, s, depth + 1, 7);
+    perf_begin(&combinePhase);
+    planes_add(&c11, &p, &c11, q, false, carry);
+    perf_end(&combinePhase);
+
+    trace_end(productNames[product]);
+}
+
+/**
+ * NAME: planes_needed
+ * INPUT: MATRIX* m1, MATRIX* m2, int n
+ * OUTPUT: int
+ * USAGE: digit planes enough to hold, with a sign, every value
+ *          Strassen's algorithm forms multiplying m1 and m2 padded to
+ *          n by n, at most LIMIT.
+ *
+ * NOTES: by strassen_bound in bounds.c no value passes
+ *          4 n^2 max|a| max|b|. The arithmetic on planes is modulo
+ *          10^planes, so sums on the way may wrap as long as every
+ *          operand of a tile product and every entry of C fits.
+ */
+static int planes_needed(MATRIX* m1, MATRIX* m2, int n)
+{
+    int planes = planes_matrix_digits(m1) + planes_matrix_digits(m2) + 1;
+    for (double growth = 4.0 * n * n; growth >= 1; growth /= 10)
+        planes++;
+    return (planes < LIMIT) ? planes : LIMIT;
+}
+
+#endif
+
+/**
+ * NAME: strassen_planes_mult
+ * INPUT: MATRIX* mOrig1, MATRIX* mOrig2, MATRIX* res
+ * USAGE: Multiplies mOrig1 and mOrig2 using Strassen's algorithm on
+ *           Morton layout copies held in digit planes (see planes.h)
+ *           and stores the result in res. Bignums without digits are
+ *           multiplied by strassen_morton_mult instead.
+ *
+ * NOTES: mOrig1, mOrig2, res must all be malloced before using this function.
+ */
+void strassen_planes_mult(MATRIX* mOrig1, MATRIX* mOrig2, MATRIX* res)
+{
+#ifdef BIGNUM_DIGITS
+    if (mOrig1->numCols != mOrig2->numRows)
+    {
+        printf("Error: Matrices cannot be multiplied");
+        return;
+    }
+
+    int origDims = mOrig1->numRows;
+    if (mOrig1->numCols > origDims)
+        origDims = mOrig1->numCols;
+    if (mOrig2->numCols > origDims)
+        origDims = mOrig2->numCols;
+    int n = next_power(origDims);
+    int planes = planes_needed(mOrig1, mOrig2, n);
+    size_t cells = (size_t) n * n;
+
+    // Convert to Morton layout, padding on the way, and from there to
+    // digit planes in the same order.
+    MORTON z;
+    PLANES a, b, c;
+    perf_begin(&padPhase);
+    morton_from_matrix(mOrig1, n, &z);
+    planes_alloc(cells, planes, &a);
+    planes_encode(z.data, cells, &a);
+    morton_free(&z);
+    morton_from_matrix(mOrig2, n, &z);
+    planes_alloc(cells, planes, &b);
+    planes_encode(z.data, cells, &b);
+    planes_alloc(cells, planes, &c);
+    perf_end(&padPhase);
+
+    PLANES ws;
+    planes_alloc(strassen_workspace_size(n, z.tile), planes, &ws);
+    PLANES_SCRATCH s;
+    s.tile = z.tile;
+    s.carry = malloc(cells / 4);
+    s.leaf = malloc(3 * (size_t) z.tile * z.tile * sizeof(BIGNUM));
+
+    strassen_planes_helper(&a, &b, &c, n, &ws, &s, 0, 0);
+
+    perf_begin(&stripPhase);
+    planes_decode(&c, cells, z.data);
+    morton_to_matrix(&z, mOrig1->numRows, mOrig2->numCols, res);
+    perf_end(&stripPhase);
+
+    free(s.carry);
+    free(s.leaf);
+    planes_free(&ws);
+    planes_free(&a);
+    planes_free(&b);
+    planes_free(&c);
+    morton_free(&z);
+#else
+    strassen_morton_mult(mOrig1, mOrig2, res);
+#endif
+}
+
+/**
+ * NAME: strassen_mult
+ * INPUT: MATRIX* mOrig1, MATRIX* mOrig2, MATRIX* res
+ * USAGE: Multiplies mOrig1 and mOrig2 using Strassen's algorithm and
+ *           stores the result in res.
+ * 
+ * NOTES: mOrig1, mOrig2, res must all be malloced before using this function.
+ */
 void strassen_mult(MATRIX* mOrig1, MATRIX* mOrig2, MATRIX* res)
 {
-    
+    // STRASSEN_LAYOUT=morton runs on Morton layout copies instead, and
+    // STRASSEN_LAYOUT=planes on those held in digit planes.
+    const char* layout = getenv("STRASSEN_LAYOUT");
+    if (layout != NULL && strcmp(layout, "morton") == 0)
+    {
+        strassen_morton_mult(mOrig1, mOrig2, res);
+        return;
+    }
+    if (layout != NULL && strcmp(layout, "planes") == 0)
+    {
+        strassen_planes_mult(mOrig1, mOrig2, res);
+        return;
+    }
+
     // Preprocess original matrices for multiplication
     MATRIX* m1 = malloc(sizeof(MATRIX));
     MATRIX* m2 = malloc(sizeof(MATRIX));
+    perf_begin(&padPhase);
     strassen_preprocess(mOrig1,mOrig2,m1,m2);
+    perf_end(&padPhase);
     
     if(m1 == NULL || m2 == NULL)
         return;
@@ -301,14 +866,17 @@ void strassen_mult(MATRIX* mOrig1, MATRIX* mOrig2, MATRIX* res)
     MATRIX* m3 = malloc(sizeof(MATRIX));
     zero_matrix(m1->numRows, m2->numCols, m3);
 
-    strassen_helper(m1, m2, m3);
+    set_depth_limit(m1->numRows);
+    strassen_helper(m1, m2, m3, 0, 0);
     
     // Grab original dimensions.
     int origNumRows = mOrig1->numRows;
     int origNumCols = mOrig2->numCols;
     
     // Strip final result matrix.
-    strassen_postprocess(m3, res, origNumRows, origNumCols);
+    perf_begin(&stripPhase);
+    strassen_postprocess(m3, res, origNumCols, origNumRows);
+    perf_end(&stripPhase);
 
     // Free memory
     free_matrix(m1);
@@ -316,14 +884,110 @@ void strassen_mult(MATRIX* mOrig1, MATRIX* mOrig2, MATRIX* res)
     free_matrix(m3);
 }
 
+/* MATRIX POWERS */
+
+/**
+ * NAME: swap_morton
+ * INPUT: MORTON* x, MORTON* y
+ * USAGE: exchanges x and y.
+ */
+static void swap_morton(MORTON* x, MORTON* y)
+{
+    MORTON t = *x;
+    *x = *y;
+    *y = t;
+}
+
+/**
+ * NAME: matrix_pow
+ * INPUT: MATRIX* m, int k, MATRIX* res
+ * USAGE: Raises the square matrix m to the power k >= 0 by repeated
+ *           squaring and stores the result in res.
+ *
+ * NOTES: m and res must be malloced before using this function. m is
+ *          padded and converted to Morton layout once; every product
+ *          then runs on Morton matrices with one shared workspace, and
+ *          squarings take the squaring path of strassen_morton_helper.
+ */
+void matrix_pow(MATRIX* m, int k, MATRIX* res)
+{
+    if (m->numRows != m->numCols)
+    {
+        printf("Error: Only square matrices have powers");
+        return;
+    }
+    if (k < 0)
+    {
+        printf("Error: Negative powers are not supported");
+        return;
+    }
+
+    int size = m->numRows;
+    if (k == 0)
+    {
+        zero_matrix(size, size, res);
+        for (int i = 0; i < size; i++)
+            bignum_from_int(1, &res->matrix[i][i]);
+        return;
+    }
+
+    // Pad once. The padding stays zero in every power, so acc holds m^j
+    // (padded) throughout; tmp receives each product before the swap.
+    int n = next_power(size);
+    MORTON base, acc, tmp;
+    perf_begin(&padPhase);
+    morton_from_matrix(m, n, &base);
+    morton_alloc(n, &acc);
+    morton_alloc(n, &tmp);
+    memcpy(acc.data, base.data, (size_t) n * n * sizeof(BIGNUM));
+    perf_end(&padPhase);
+
+    size_t wsCells = strassen_workspace_size(n, base.tile);
+    BIGNUM* ws = malloc(wsCells * sizeof(BIGNUM));
+    memtrack_alloc(wsCells * sizeof(BIGNUM));
+
+    // Left to right over the bits of k, below the highest.
+    set_depth_limit(n);
+    int bit = 1;
+    while (bit <= k / 2)
+        bit *= 2;
+    for (bit /= 2; bit > 0; bit /= 2)
+    {
+        strassen_morton_helper(acc.data, acc.data, tmp.data, n, base.tile, ws, 0, 0);
+        swap_morton(&acc, &tmp);
+        if (k & bit)
+        {
+            strassen_morton_helper(acc.data, base.data, tmp.data, n, base.tile, ws, 0, 0);
+            swap_morton(&acc, &tmp);
+        }
+    }
+
+    perf_begin(&stripPhase);
+    morton_to_matrix(&acc, size, size, res);
+    perf_end(&stripPhase);
+
+    free(ws);
+    memtrack_release(wsCells * sizeof(BIGNUM));
+    morton_free(&base);
+    morton_free(&acc);
+    morton_free(&tmp);
+}
+
+#ifndef NO_MAIN
+
 int main(void)
 {   
     // Structs for timing data.
     struct rusage before, after;
     double ti_multiply=0.0;
     
-    // Seed random number generator.
+    // Open hardware counters if PERF_COUNTERS is set.
+    perf_init();
+    trace_open();
+    
+    // Seed random number generators. MATRIX_SEED overrides the seed.
 	srand(time(NULL));
+	gen_set_seed(time(NULL));
 	
 	// Initalize matrixes. Change values here for different size matrices.
     MATRIX* m1 = malloc(sizeof(MATRIX));
@@ -346,9 +1010,16 @@ int main(void)
     
     // Print out computation time.
     printf("\nTime Spent (in sec): %f\n", (ti_multiply));
+    trace_close();
+    perf_report();
+    memtrack_report();
+    
+    // Check the product if VERIFY_ROUNDS is set.
+    verify_from_env(m1, m2, m3);
     
     // Free matrices when done with them.
     free_matrix(m1);
     free_matrix(m2);
     free_matrix(m3);
 }
+#endif
@@ -0,0 +1,337 @@
+/*************************************************************************
+ * textio.c
+ *
+ * Implements text matrix input and output (see textio.h). Values are
+ * converted with bignum_to_string and bignum_from_string; both bignum
+ * types keep their values in base 10, so conversion is linear in the
+ * number of digits and needs no radix conversion.
+ ************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "parallel.h"
+#include "textio.h"
+
+// rows formatted together before being written
+#define BLOCK_ROWS 256
+
+// room reserved for a value before asking how long it really is
+#define VALUE_ROOM 32
+
+// A row of text being built.
+typedef struct
+{
+    char* text;
+    int length;
+    int capacity;
+}
+ROW_TEXT;
+
+// Arguments of the parallel formatting of a block of rows.
+typedef struct
+{
+    MATRIX* m;
+    int first;
+    TEXT_FORMAT format;
+    ROW_TEXT* rows;
+}
+FORMAT_ARGS;
+
+/**
+ * NAME: reserve
+ * INPUT: ROW_TEXT* r, int extra
+ * USAGE: makes room for extra more characters in r.
+ */
+static void reserve(ROW_TEXT* r, int extra)
+{
+    if (r->length + extra <= r->capacity)
+        return;
+    while (r->length + extra > r->capacity)
+        r->capacity = (r->capacity > 0) ? 2 * r->capacity : 256;
+    r->text = realloc(r->text, r->capacity);
+}
+
+/**
+ * NAME: format_row
+ * INPUT: MATRIX* m, int i, TEXT_FORMAT format, ROW_TEXT* r
+ * USAGE: writes row i of m to r in the given layout.
+ */
+static void format_row(MATRIX* m, int i, TEXT_FORMAT format, ROW_TEXT* r)
+{
+    char sep = (format == TEXT_CSV) ? ',' : '\t';
+    r->length = 0;
+    reserve(r, m->numCols * (VALUE_ROOM / 2));
+    if (format == TEXT_PRINT)
+        r->text[r->length++] = '\n';
+
+    for (int j = 0; j < m->numCols; j++)
+    {
+        // Grow until the value fits, plus its separator.
+        int len;
+        reserve(r, VALUE_ROOM);
+        while ((len = bignum_to_string(&m->matrix[i][j], r->text + r->length,
+                                       r->capacity - r->length - 1)) < 0)
+            reserve(r, r->capacity);
+        r->length += len;
+
+        if (format == TEXT_PRINT || j < m->numCols - 1)
+            r->text[r->length++] = sep;
+    }
+    if (format != TEXT_PRINT)
+    {
+        reserve(r, 1);
+        r->text[r->length++] = '\n';
+    }
+}
+
+/**
+ * NAME: format_rows
+ * INPUT: int begin, int end, void* arg
+ * USAGE: parallel_for body formatting rows [begin, end) of a block.
+ */
+static void format_rows(int begin, int end, void* arg)
+{
+    FORMAT_ARGS* args = arg;
+    for (int r = begin; r < end; r++)
+        format_row(args->m, args->first + r, args->format, &args->rows[r]);
+}
+
+/**
+ * NAME: textio_write_matrix
+ * INPUT: FILE* out, MATRIX* m, TEXT_FORMAT format
+ * OUTPUT: bool
+ * USAGE: writes m to out in the given layout. Returns false if writing
+ *          fails.
+ */
+bool textio_write_matrix(FILE* out, MATRIX* m, TEXT_FORMAT format)
+{
+    // Row buffers are kept from block to block, so they are allocated
+    // only while they grow.
+    ROW_TEXT* rows = calloc(BLOCK_ROWS, sizeof(ROW_TEXT));
+    FORMAT_ARGS args = {m, 0, format, rows};
+    bool ok = true;
+
+    for (args.first = 0; ok && args.first < m->numRows; args.first += BLOCK_ROWS)
+    {
+        int count = m->numRows - args.first;
+        if (count > BLOCK_ROWS)
+            count = BLOCK_ROWS;
+        parallel_for(count, format_rows, &args);
+
+        for (int r = 0; ok && r < count; r++)
+            ok = fwrite(rows[r].text, 1, rows[r].length, out) == (size_t) rows[r].length;
+    }
+    if (ok && format == TEXT_PRINT)
+        ok = fputc('\n', out) != EOF;
+
+    for (int r = 0; r < BLOCK_ROWS; r++)
+        free(rows[r].text);
+    free(rows);
+    return ok;
+}
+
+/**
+ * NAME: is_separator
+ * INPUT: char c
+ * OUTPUT: bool
+ * USAGE: whether c separates values.
+ */
+static bool is_separator(char c)
+{
+    return c == ',' || c == '\t' || c == ' ' || c == '\r';
+}
+
+/**
+ * NAME: next_field
+ * INPUT: const char** pos, const char* end, const char** field, int* len
+ * OUTPUT: bool
+ * USAGE: finds the next value between *pos and end, strips any quotes
+ *          around it and advances *pos past it. Returns false if there
+ *          are no more values.
+ */
+static bool next_field(const char** pos, const char* end, const char** field, int* len)
+{
+    const char* p = *pos;
+    while (p < end && is_separator(*p))
+        p++;
+    if (p == end)
+        return false;
+
+    const char* start = p;
+    if (*p == '"')
+    {
+        start = ++p;
+        while (p < end && *p != '"')
+            p++;
+        *len = (int) (p - start);
+        if (p < end)
+            p++;
+    }
+    else
+    {
+        while (p < end && !is_separator(*p))
+            p++;
+        *len = (int) (p - start);
+    }
+
+    *field = start;
+    *pos = p;
+    return true;
+}
+
+/**
+ * NAME: count_fields
+ * INPUT: const char* line, const char* end
+ * OUTPUT: int
+ * USAGE: number of values on a line.
+ */
+static int count_fields(const char* line, const char* end)
+{
+    const char* field;
+    int len, count = 0;
+    while (next_field(&line, end, &field, &len))
+        count++;
+    return count;
+}
+
+// Arguments of the parallel parse.
+typedef struct
+{
+    const char** starts;
+    const char** ends;
+    MATRIX* m;
+    bool* bad;
+}
+PARSE_ARGS;
+
+/**
+ * NAME: parse_rows
+ * INPUT: int begin, int end, void* arg
+ * USAGE: parallel_for body parsing lines [begin, end) into their rows,
+ *          marking the rows that do not parse.
+ */
+static void parse_rows(int begin, int end, void* arg)
+{
+    PARSE_ARGS* args = arg;
+    for (int i = begin; i < end; i++)
+    {
+        const char* pos = args->starts[i];
+        const char* field;
+        int len, j = 0;
+        while (next_field(&pos, args->ends[i], &field, &len))
+        {
+            if (j == args->m->numCols ||
+                !bignum_from_string(field, len, &args->m->matrix[i][j]))
+                break;
+            j++;
+        }
+        args->bad[i] = (j != args->m->numCols || next_field(&pos, args->ends[i], &field, &len));
+    }
+}
+
+/**
+ * NAME: textio_read_matrix
+ * INPUT: const char* path, MATRIX* m
+ * OUTPUT: bool
+ * USAGE: reads the text matrix at path into m. Values may be separated
+ *          by commas, tabs or spaces, and blank lines, separators at the
+ *          end of a line and quotes around values are ignored, so CSV,
+ *          TSV and print_matrix output can all be read. Every row must
+ *          have the same number of values.
+ *
+ * NOTES: assumes m is malloced. On failure m is left unallocated.
+ */
+bool textio_read_matrix(const char* path, MATRIX* m)
+{
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        printf("Error: cannot open %s\n", path);
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+    size_t length = st.st_size;
+    const char* text = (length > 0) ? mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+    close(fd);
+    if (text == MAP_FAILED)
+    {
+        printf("Error: cannot map %s\n", path);
+        return false;
+    }
+
+    // Index the lines that hold values. This pass only looks for
+    // newlines, so it is cheap next to the parse.
+    int rowSize = 0, capacity = 1024;
+    const char** starts = malloc(capacity * sizeof(char*));
+    const char** ends = malloc(capacity * sizeof(char*));
+    const char* end = text + length;
+    for (const char* line = text; line < end; )
+    {
+        const char* newline = memchr(line, '\n', end - line);
+        const char* lineEnd = (newline != NULL) ? newline : end;
+
+        const char* p = line;
+        while (p < lineEnd && is_separator(*p))
+            p++;
+        if (p < lineEnd)
+        {
+            if (rowSize == capacity)
+            {
+                capacity *= 2;
+                starts = realloc(starts, capacity * sizeof(char*));
+                ends = realloc(ends, capacity * sizeof(char*));
+            }
+            starts[rowSize] = line;
+            ends[rowSize] = lineEnd;
+            rowSize++;
+        }
+        line = lineEnd + 1;
+    }
+
+    bool ok = rowSize > 0;
+    if (!ok)
+        printf("Error: %s holds no values\n", path);
+    else
+    {
+        // Parse into a scratch matrix so a bad file leaves m untouched.
+        MATRIX* tmp = malloc(sizeof(MATRIX));
+        alloc_matrix(rowSize, count_fields(starts[0], ends[0]), tmp);
+        bool* bad = malloc(rowSize * sizeof(bool));
+        PARSE_ARGS args = {starts, ends, tmp, bad};
+        parallel_for(rowSize, parse_rows, &args);
+
+        for (int i = 0; ok && i < rowSize; i++)
+        {
+            if (bad[i])
+            {
+                printf("Error: row %d of %s does not hold %d numbers\n",
+                       i + 1, path, tmp->numCols);
+                ok = false;
+            }
+        }
+        free(bad);
+
+        if (ok)
+        {
+            *m = *tmp;
+            free(tmp);
+        }
+        else
+            free_matrix(tmp);
+    }
+
+    free(starts);
+    free(ends);
+    if (text != NULL)
+        munmap((void*) text, length);
+    return ok;
+}
@@ -0,0 +1,53 @@
+/****************************************************************************
+ * textio.h
+ *
+ * Computer Science 51
+ * Text Matrix Input and Output
+ *
+ * Fast reading and writing of matrices as text. Output is formatted a
+ * block of rows at a time, in parallel, and each row is written with a
+ * single call as soon as its block is done. Input is mapped whole,
+ * split into lines and parsed in parallel.
+ ***************************************************************************/
+#ifndef _TEXTIO_H
+#define _TEXTIO_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "matrix.h"
+
+// text layouts textio_write_matrix can produce
+typedef enum
+{
+    TEXT_PRINT,     // print_matrix's layout: each row starts with a newline
+                    // and every value is followed by a tab
+    TEXT_CSV,       // comma-separated values, one row per line
+    TEXT_TSV        // tab-separated values, one row per line
+}
+TEXT_FORMAT;
+
+/**
+ * NAME: textio_write_matrix
+ * INPUT: FILE* out, MATRIX* m, TEXT_FORMAT format
+ * OUTPUT: bool
+ * USAGE: writes m to out in the given layout. Returns false if writing
+ *          fails.
+ */
+bool textio_write_matrix(FILE* out, MATRIX* m, TEXT_FORMAT format);
+
+/**
+ * NAME: textio_read_matrix
+ * INPUT: const char* path, MATRIX* m
+ * OUTPUT: bool
+ * USAGE: reads the text matrix at path into m. Values may be separated
+ *          by commas, tabs or spaces, and blank lines, separators at the
+ *          end of a line and quotes around values are ignored, so CSV,
+ *          TSV and print_matrix output can all be read. Every row must
+ *          have the same number of values.
+ *
+ * NOTES: assumes m is malloced. On failure m is left unallocated.
+ */
+bool textio_read_matrix(const char* path, MATRIX* m);
+
+#endif
@@ -0,0 +1,121 @@
+/*************************************************************************
+ * trace.c
+ *
+ * Implements the Chrome trace writer. Events are appended to the file as
+ * they happen under a mutex, so nodes running on different threads show
+ * up on their own tracks.
+ ************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "trace.h"
+
+static FILE* out = NULL;
+static bool first = true;
+static double start = 0.0;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * NAME: micros
+ * OUTPUT: double
+ * USAGE: microseconds since trace_open.
+ */
+static double micros(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1e6 + ts.tv_nsec / 1e3) - start;
+}
+
+/**
+ * NAME: thread_id
+ * OUTPUT: long
+ * USAGE: the kernel thread ID of the caller.
+ */
+static long thread_id(void)
+{
+    return syscall(SYS_gettid);
+}
+
+/**
+ * NAME: trace_open
+ * USAGE: opens the file named by STRASSEN_TRACE and starts the trace.
+ */
+void trace_open(void)
+{
+    const char* path = getenv("STRASSEN_TRACE");
+    if (path == NULL || path[0] == '\0')
+        return;
+
+    out = fopen(path, "w");
+    if (out == NULL)
+    {
+        printf("Error: cannot open trace file %s\n", path);
+        return;
+    }
+
+    start = 0.0;
+    start = micros();
+    first = true;
+    fprintf(out, "{\"traceEvents\":[\n");
+}
+
+/**
+ * NAME: trace_begin
+ * INPUT: const char* name, int depth, int size, int product
+ * USAGE: emits a begin event on the calling thread. product is which
+ *          of Strassen's products x1..x7 the node computes, 0 for none.
+ */
+void trace_begin(const char* name, int depth, int size, int product)
+{
+    if (out == NULL)
+        return;
+
+    pthread_mutex_lock(&lock);
+    fprintf(out, "%s{\"name\":\"%s\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":%d,\"tid\":%ld,"
+            "\"args\":{\"depth\":%d,\"size\":%d,\"product\":%d}}",
+            first ? "" : ",\n", name, micros(), (int) getpid(), thread_id(),
+            depth, size, product);
+    first = false;
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * NAME: trace_end
+ * INPUT: const char* name
+ * USAGE: emits the end event matching the last trace_begin of name on
+ *          the calling thread.
+ */
+void trace_end(const char* name)
+{
+    if (out == NULL)
+        return;
+
+    pthread_mutex_lock(&lock);
+    fprintf(out, "%s{\"name\":\"%s\",\"ph\":\"E\",\"ts\":%.3f,\"pid\":%d,\"tid\":%ld}",
+            first ? "" : ",\n", name, micros(), (int) getpid(), thread_id());
+    first = false;
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * NAME: trace_close
+ * USAGE: finishes the JSON and closes the trace file.
+ */
+void trace_close(void)
+{
+    if (out == NULL)
+        return;
+
+    fprintf(out, "\n]}\n");
+    fclose(out);
+    out = NULL;
+}
@@ -0,0 +1,42 @@
+/****************************************************************************
+ * trace.h
+ *
+ * Computer Science 51
+ * Recursion Tracing
+ *
+ * Writes begin/end events in the Chrome trace JSON format (viewable in
+ * chrome://tracing or Perfetto). Enabled by setting STRASSEN_TRACE to
+ * the output path; otherwise every call here is a no-op.
+ ***************************************************************************/
+#ifndef _TRACE_H
+#define _TRACE_H
+
+/**
+ * NAME: trace_open
+ * USAGE: opens the file named by STRASSEN_TRACE and starts the trace.
+ */
+void trace_open(void);
+
+/**
+ * NAME: trace_begin
+ * INPUT: const char* name, int depth, int size, int product
+ * USAGE: emits a begin event on the calling thread. product is which
+ *          of Strassen's products x1..x7 the node computes, 0 for none.
+ */
+void trace_begin(const char* name, int depth, int size, int product);
+
+/**
+ * NAME: trace_end
+ * INPUT: const char* name
+ * USAGE: emits the end event matching the last trace_begin of name on
+ *          the calling thread.
+ */
+void trace_end(const char* name);
+
+/**
+ * NAME: trace_close
+ * USAGE: finishes the JSON and closes the trace file.
+ */
+void trace_close(void);
+
+#endif
@@ -0,0 +1,362 @@
+/*************************************************************************
+ * verify.c
+ *
+ * Implements Freivalds' probabilistic check of a matrix product. Every
+ * entry is reduced mod FREIVALDS_PRIME once, after which each round is
+ * three matrix-vector products on plain residues, so the check
+ * costs O(n^2) per round for either bignum representation; a chain of
+ * products is checked by passing r through every factor in turn. Floating-
+ * point bignums round, so for them the products are compared in double
+ * precision to within the rounding error bounds of rounding.h instead.
+ ************************************************************************/
+
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "gen.h"
+#include "matrix.h"
+#include "rounding.h"
+#include "verify.h"
+
+// stream the random vectors are drawn from, and how much of it is used
+static unsigned long long verifySeed;
+static unsigned long long draws = 0;
+
+/**
+ * NAME: next_random
+ * OUTPUT: unsigned long long
+ * USAGE: the next uniformly random 64-bit value for a check's vectors.
+ *          The stream is seeded on first use from VERIFY_SEED, or else
+ *          the time, so separate runs check with different vectors.
+ */
+static unsigned long long next_random(void)
+{
+    if (draws == 0)
+    {
+        const char* env = getenv("VERIFY_SEED");
+        verifySeed = (env != NULL) ? strtoull(env, NULL, 10) : (unsigned long long) time(NULL);
+    }
+    return gen_random(verifySeed, draws++);
+}
+
+#ifdef BIGNUM_UNIT_ROUNDOFF
+
+/**
+ * NAME: real_mat_vec
+ * INPUT: MATRIX* m, double* v, double* out
+ * USAGE: out = m * v in double precision.
+ */
+static void real_mat_vec(MATRIX* m, double* v, double* out)
+{
+    for (int i = 0; i < m->numRows; i++)
+    {
+        double sum = 0;
+        for (int j = 0; j < m->numCols; j++)
+            sum += bignum_to_double(&m->matrix[i][j]) * v[j];
+        out[i] = sum;
+    }
+}
+
+/**
+ * NAME: max_magnitude
+ * INPUT: MATRIX* m
+ * OUTPUT: double
+ * USAGE: max|m|, the largest magnitude of an entry of m.
+ */
+static double max_magnitude(MATRIX* m)
+{
+    double largest = 0;
+    for (int i = 0; i < m->numRows; i++)
+        for (int j = 0; j < m->numCols; j++)
+            if (fabs(bignum_to_double(&m->matrix[i][j])) > largest)
+                largest = fabs(bignum_to_double(&m->matrix[i][j]));
+    return largest;
+}
+
+/**
+ * NAME: real_tolerance
+ * INPUT: int n, int count
+ * OUTPUT: double
+ * USAGE: how far M1(M2(...r)) and Cr may be apart, relative to the
+ *          largest magnitude either can have, when C is the rounded
+ *          product of count factors of at most n rows and columns.
+ *
+ * NOTES: each of the count - 1 products is off by at most the larger
+ *          of Higham's bound for the deepest recursion Strassen's
+ *          algorithm takes on n (see strassen_depth_limit), which the
+ *          classical algorithms, at depth 0, are within, and
+ *          winograd_error_bound. Winograd's bound holds only because
+ *          winograd_mult balances its operands first; without that it
+ *          grows with max|a| / max|b| and no tolerance in terms of
+ *          max|a| max|b| covers it. The check itself rounds too, by at
+ *          most n u in double precision per factor and for C.
+ */
+static double real_tolerance(int n, int count)
+{
+    int size = 1;
+    while (size < n)
+        size *= 2;
+    int products = (count > 1) ? count - 1 : 0;
+    double bound = strassen_error_bound(size, strassen_depth_limit(size));
+    if (winograd_error_bound(size) > bound)
+        bound = winograd_error_bound(size);
+    return products * bound + (count + 1) * size * (DBL_EPSILON / 2);
+}
+
+/**
+ * NAME: real_freivalds_verify
+ * INPUT: MATRIX** ms, int count, MATRIX* c, int rounds
+ * OUTPUT: bool
+ * USAGE: freivalds_verify_chain for floating-point bignums, which
+ *          round, so M1(M2(...r)) and Cr need only agree to within
+ *          real_tolerance of max|M1| max|M2| ... times the inner
+ *          dimensions and the sum of r, r having entries in [0, 1).
+ *
+ * NOTES: Higham's bounds are normwise, as Strassen's algorithm spreads
+ *          the rounding of large entries over the whole product, so
+ *          the scale is too.
+ */
+static bool real_freivalds_verify(MATRIX** ms, int count, MATRIX* c, int rounds)
+{
+    int n = c->numCols;
+    int longest = (c->numRows > n) ? c->numRows : n;
+    double scale = 1;
+    for (int i = 0; i < count; i++)
+    {
+        if (ms[i]->numRows > longest)
+            longest = ms[i]->numRows;
+        scale *= max_magnitude(ms[i]);
+        if (i + 1 < count)
+            scale *= ms[i]->numCols;
+    }
+    double tolerance = real_tolerance(longest, count);
+
+    double* r = malloc(n * sizeof(double));
+    double* v = malloc(longest * sizeof(double));
+    double* next = malloc(longest * sizeof(double));
+    double* cr = malloc(c->numRows * sizeof(double));
+
+    bool ok = true;
+    for (int round = 0; round < rounds && ok; round++)
+    {
+        double sum = 0;
+        for (int j = 0; j < n; j++)
+        {
+            r[j] = (next_random() >> 11) * 0x1p-53;
+            v[j] = r[j];
+            sum += r[j];
+        }
+
+        // Multiply r by the factors from the last to the first.
+        for (int i = count - 1; i >= 0; i--)
+        {
+            real_mat_vec(ms[i], v, next);
+            memcpy(v, next, ms[i]->numRows * sizeof(double));
+        }
+        real_mat_vec(c, r, cr);
+
+        for (int i = 0; i < c->numRows && ok; i++)
+            ok = fabs(v[i] - cr[i]) <= tolerance * scale * sum;
+    }
+
+    free(r);
+    free(v);
+    free(next);
+    free(cr);
+    return ok;
+}
+
+#else
+
+/**
+ * NAME: random_residue
+ * INPUT: unsigned long long p
+ * OUTPUT: long long
+ * USAGE: a uniformly random residue mod p. Draws at or above the
+ *          largest multiple of p that fits in 64 bits are redrawn, so
+ *          no residue is likelier than another, whatever the size of p.
+ */
+static long long random_residue(unsigned long long p)
+{
+    unsigned long long excess = (ULLONG_MAX % p + 1) % p;
+    unsigned long long x;
+    do
+        x = next_random();
+    while (excess != 0 && x > ULLONG_MAX - excess);
+    return (long long) (x % p);
+}
+
+/**
+ * NAME: reduce_matrix
+ * INPUT: MATRIX* m
+ * OUTPUT: long long*
+ * USAGE: returns a malloced row-major array of the entries of m mod
+ *          FREIVALDS_PRIME.
+ */
+static long long* reduce_matrix(MATRIX* m)
+{
+    long long* r = malloc((size_t) m->numRows * m->numCols * sizeof(long long));
+    for (int i = 0; i < m->numRows; i++)
+        for (int j = 0; j < m->numCols; j++)
+            r[(size_t) i * m->numCols + j] = bignum_mod(&m->matrix[i][j], FREIVALDS_PRIME);
+    return r;
+}
+
+/**
+ * NAME: mat_vec
+ * INPUT: long long* m, int rows, int cols, long long* v, long long* out
+ * USAGE: out = m * v mod FREIVALDS_PRIME.
+ */
+static void mat_vec(long long* m, int rows, int cols, long long* v, long long* out)
+{
+    for (int i = 0; i < rows; i++)
+    {
+        // A GF(p) prime may be up to 2^62, so form each product in 128
+        // bits and reduce after every addition.
+        long long sum = 0;
+        for (int j = 0; j < cols; j++)
+            sum = (long long) ((sum + (unsigned __int128) m[(size_t) i * cols + j] * v[j]) % FREIVALDS_PRIME);
+        out[i] = sum;
+    }
+}
+
+#endif
+
+/**
+ * NAME: freivalds_verify_chain
+ * INPUT: MATRIX** ms, int count, MATRIX* c, int rounds
+ * OUTPUT: bool
+ * USAGE: checks M1(M2(...(Mcount r))) == Cr mod FREIVALDS_PRIME for
+ *          rounds random vectors r, so C is the product of the count
+ *          matrices at ms (the identity if count is 0). Returns false
+ *          if any round fails or the dimensions do not match.
+ *
+ * NOTES: a matrix appearing several times in a row, as in a power, is
+ *          reduced only once.
+ */
+bool freivalds_verify_chain(MATRIX** ms, int count, MATRIX* c, int rounds)
+{
+    int rows = (count > 0) ? ms[0]->numRows : c->numCols;
+    for (int i = 0; i + 1 < count; i++)
+        if (ms[i]->numCols != ms[i + 1]->numRows)
+            return false;
+    if (c->numRows != rows || (count > 0 && ms[count - 1]->numCols != c->numCols))
+        return false;
+
+#ifdef BIGNUM_UNIT_ROUNDOFF
+    return real_freivalds_verify(ms, count, c, rounds);
+#else
+
+    int n = c->numCols;
+    int longest = (c->numRows > n) ? c->numRows : n;
+    long long** reduced = malloc((count + 1) * sizeof(long long*));
+    for (int i = 0; i < count; i++)
+    {
+        if (ms[i]->numRows > longest)
+            longest = ms[i]->numRows;
+        reduced[i] = (i > 0 && ms[i] == ms[i - 1]) ? reduced[i - 1] : reduce_matrix(ms[i]);
+    }
+    long long* rc = reduce_matrix(c);
+
+    long long* r = malloc(n * sizeof(long long));
+    long long* v = malloc(longest * sizeof(long long));
+    long long* next = malloc(longest * sizeof(long long));
+    long long* cr = malloc(c->numRows * sizeof(long long));
+
+    bool ok = true;
+    for (int round = 0; round < rounds && ok; round++)
+    {
+        // Random vector with entries uniform in [0, FREIVALDS_PRIME).
+        for (int j = 0; j < n; j++)
+            v[j] = r[j] = random_residue(FREIVALDS_PRIME);
+
+        // Multiply r by the factors from the last to the first.
+        for (int i = count - 1; i >= 0; i--)
+        {
+            mat_vec(reduced[i], ms[i]->numRows, ms[i]->numCols, v, next);
+            memcpy(v, next, ms[i]->numRows * sizeof(long long));
+        }
+        mat_vec(rc, c->numRows, n, r, cr);
+
+        ok = (memcmp(v, cr, c->numRows * sizeof(long long)) == 0);
+    }
+
+    for (int i = 0; i < count; i++)
+        if (i + 1 == count || reduced[i + 1] != reduced[i])
+            free(reduced[i]);
+    free(reduced);
+    free(rc);
+    free(r);
+    free(v);
+    free(next);
+    free(cr);
+    return ok;
+#endif
+}
+
+/**
+ * NAME: freivalds_verify
+ * INPUT: MATRIX* a, MATRIX* b, MATRIX* c, int rounds
+ * OUTPUT: bool
+ * USAGE: checks A(Br) == Cr mod FREIVALDS_PRIME for rounds random
+ *          vectors r. Returns false if any round fails or the dimensions
+ *          do not match.
+ *
+ * NOTES: a product that is wrong mod FREIVALDS_PRIME passes a round
+ *          with probability at most 1/FREIVALDS_PRIME, as r is uniform.
+ *          One that is off only by multiples of it in every entry
+ *          always passes.
+ */
+bool freivalds_verify(MATRIX* a, MATRIX* b, MATRIX* c, int rounds)
+{
+    MATRIX* ms[2] = {a, b};
+    return freivalds_verify_chain(ms, 2, c, rounds);
+}
+
+/**
+ * NAME: verify_rounds
+ * OUTPUT: int
+ * USAGE: the rounds VERIFY_ROUNDS asks for, 0 if it is unset.
+ */
+int verify_rounds(void)
+{
+    const char* env = getenv("VERIFY_ROUNDS");
+    int rounds = (env == NULL) ? 0 : atoi(env);
+    return (rounds > 0) ? rounds : 0;
+}
+
+/**
+ * NAME: verify_chain_from_env
+ * INPUT: MATRIX** ms, int count, MATRIX* c
+ * USAGE: runs freivalds_verify_chain with VERIFY_ROUNDS rounds and
+ *          prints the outcome. Does nothing if VERIFY_ROUNDS is unset
+ *          or 0.
+ */
+void verify_chain_from_env(MATRIX** ms, int count, MATRIX* c)
+{
+    int rounds = verify_rounds();
+    if (rounds == 0)
+        return;
+
+    bool ok = freivalds_verify_chain(ms, count, c, rounds);
+    printf("Freivalds verification (%d rounds): %s\n", rounds,
+           ok ? "passed" : "FAILED");
+}
+
+/**
+ * NAME: verify_from_env
+ * INPUT: MATRIX* a, MATRIX* b, MATRIX* c
+ * USAGE: runs freivalds_verify with VERIFY_ROUNDS rounds and prints the
+ *          outcome. Does nothing if VERIFY_ROUNDS is unset or 0.
+ */
+void verify_from_env(MATRIX* a, MATRIX* b, MATRIX* c)
+{
+    MATRIX* ms[2] = {a, b};
+    verify_chain_from_env(ms, 2, c);
+}
@@ -0,0 +1,80 @@
+/****************************************************************************
+ * verify.h
+ *
+ * Computer Science 51
+ * Product Verification
+ *
+ * Freivalds' randomized check that C == A * B in O(n^2) per round.
+ ***************************************************************************/
+#ifndef _VERIFY_H
+#define _VERIFY_H
+
+#include "matrix.h"
+
+// Prime the check works modulo (2^31 - 1). Working mod a prime that is
+// not a power of two also catches 64-bit wraparound in int_bignums.
+// GF(p) products are only right mod p, so they are checked mod p.
+#ifdef MODP_BIGNUMS
+#define FREIVALDS_PRIME bignum_modulus()
+#else
+#define FREIVALDS_PRIME 2147483647LL
+#endif
+
+/**
+ * NAME: freivalds_verify
+ * INPUT: MATRIX* a, MATRIX* b, MATRIX* c, int rounds
+ * OUTPUT: bool
+ * USAGE: checks A(Br) == Cr mod FREIVALDS_PRIME for rounds random
+ *          vectors r. Returns false if any round fails or the dimensions
+ *          do not match.
+ *
+ * NOTES: a product that is wrong mod FREIVALDS_PRIME passes a round
+ *          with probability at most 1/FREIVALDS_PRIME, so a single
+ *          round is usually enough. One that is off only by multiples
+ *          of it in every entry always passes. r is drawn from a stream
+ *          seeded with VERIFY_SEED, or else the time.
+ */
+bool freivalds_verify(MATRIX* a, MATRIX* b, MATRIX* c, int rounds);
+
+/**
+ * NAME: freivalds_verify_chain
+ * INPUT: MATRIX** ms, int count, MATRIX* c, int rounds
+ * OUTPUT: bool
+ * USAGE: checks M1(M2(...(Mcount r))) == Cr mod FREIVALDS_PRIME for
+ *          rounds random vectors r, so C is the product of the count
+ *          matrices at ms (the identity if count is 0). Returns false
+ *          if any round fails or the dimensions do not match.
+ *
+ * NOTES: costs O(n^2) per factor and round; a power A^k can be checked
+ *          by passing A k times. Floating-point bignums round, so for
+ *          them each round passes if the two vectors agree to within
+ *          the rounding error bounds of rounding.h for the products
+ *          and for the check itself.
+ */
+bool freivalds_verify_chain(MATRIX** ms, int count, MATRIX* c, int rounds);
+
+/**
+ * NAME: verify_rounds
+ * OUTPUT: int
+ * USAGE: the rounds VERIFY_ROUNDS asks for, 0 if it is unset.
+ */
+int verify_rounds(void);
+
+/**
+ * NAME: verify_chain_from_env
+ * INPUT: MATRIX** ms, int count, MATRIX* c
+ * USAGE: runs freivalds_verify_chain with VERIFY_ROUNDS rounds and
+ *          prints the outcome. Does nothing if VERIFY_ROUNDS is unset
+ *          or 0.
+ */
+void verify_chain_from_env(MATRIX** ms, int count, MATRIX* c);
+
+/**
+ * NAME: verify_from_env
+ * INPUT: MATRIX* a, MATRIX* b, MATRIX* c
+ * USAGE: runs freivalds_verify with VERIFY_ROUNDS rounds and prints the
+ *          outcome. Does nothing if VERIFY_ROUNDS is unset or 0.
+ */
+void verify_from_env(MATRIX* a, MATRIX* b, MATRIX* c);
+
+#endif
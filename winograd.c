@@ -9,6 +9,7 @@
  ************************************************************************/
  
 #include <assert.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -17,7 +18,16 @@
 
 #include "matrix.h"
 #include "bignum.h"
+#include "gen.h"
+#include "memtrack.h"
+#include "mult.h"
+#include "perfcount.h"
+#include "verify.h"
 
+// Instrumented phases, see perfcount.h.
+static PERF_PHASE preprocessPhase = PERF_PHASE_INIT("winograd preprocess");
+static PERF_PHASE multiplyPhase = PERF_PHASE_INIT("winograd multiply");
+static PERF_PHASE oddPhase = PERF_PHASE_INIT("winograd odd column");
 
 /* WINOGRAD HELPER FUNCTIONS */
 
@@ -38,10 +48,11 @@ void winograd_preprocess(MATRIX* m1, MATRIX* m2, BIGNUM* row, BIGNUM* col)
     int d = b/2;
 
     // get row factors from m1
+    // (they start at zero, so matrices with a single column work too)
     for (int i = 0; i < a; i++)
     {
-        mult_bignums (&m1->matrix[i][0], &m1->matrix[i][1], &row[i]);
-        for (int j = 1; j < d; j++)
+        bignum_from_int(0, &row[i]);
+        for (int j = 0; j < d; j++)
 	    {
 	        // We must initialize temporary variables whenever we use bignums.
 	        BIGNUM* temp1 = malloc(sizeof(BIGNUM));
@@ -63,8 +74,8 @@ void winograd_preprocess(MATRIX* m1, MATRIX* m2, BIGNUM* row, BIGNUM* col)
     // get column factors from m2
     for (int i = 0; i < c; i++)
     {
-        mult_bignums(&m2->matrix[0][i], &m2->matrix[1][i], &col[i]);
-        for (int j = 1; j < d; j++)
+        bignum_from_int(0, &col[i]);
+        for (int j = 0; j < d; j++)
 	    {
 	        // We must initialize temporary variables whenever we use bignums.	    
 	        BIGNUM* temp1 = malloc(sizeof(BIGNUM));
@@ -84,6 +95,51 @@ void winograd_preprocess(MATRIX* m1, MATRIX* m2, BIGNUM* row, BIGNUM* col)
     }
 }
 
+#ifdef BIGNUM_UNIT_ROUNDOFF
+
+/**
+ * NAME: balance_exponent
+ * INPUT: MATRIX* m1, MATRIX* m2
+ * OUTPUT: int
+ * USAGE: the power of 2, e, for which 2^e max|m1| and 2^-e max|m2| are
+ *          within a factor of 4 of each other. 0 if either is zero.
+ */
+static int balance_exponent(MATRIX* m1, MATRIX* m2)
+{
+    double largest[2] = {0, 0};
+    MATRIX* ms[2] = {m1, m2};
+    for (int t = 0; t < 2; t++)
+        for (int i = 0; i < ms[t]->numRows; i++)
+            for (int j = 0; j < ms[t]->numCols; j++)
+                if (fabs(bignum_to_double(&ms[t]->matrix[i][j])) > largest[t])
+                    largest[t] = fabs(bignum_to_double(&ms[t]->matrix[i][j]));
+    if (largest[0] == 0 || largest[1] == 0)
+        return 0;
+    return (ilogb(largest[1]) - ilogb(largest[0])) / 2;
+}
+
+/**
+ * NAME: scaled_copy
+ * INPUT: MATRIX* m, int e, MATRIX* res
+ * USAGE: res = 2^e m.
+ *
+ * NOTES: res must be malloced before using this function.
+ */
+static void scaled_copy(MATRIX* m, int e, MATRIX* res)
+{
+    alloc_matrix(m->numRows, m->numCols, res);
+    for (int i = 0; i < m->numRows; i++)
+    {
+        for (int j = 0; j < m->numCols; j++)
+        {
+            res->matrix[i][j] = m->matrix[i][j];
+            bignum_scale(&res->matrix[i][j], e);
+        }
+    }
+}
+
+#endif
+
 /* WINOGRAD ALGORITHM */
 
 /**
@@ -93,6 +149,8 @@ void winograd_preprocess(MATRIX* m1, MATRIX* m2, BIGNUM* row, BIGNUM* col)
  *           the result in res
  * 
  * NOTES: m1, m2, m3 must all be malloced before using this function.
+ *          For bignums that round, m1 and m2 are first scaled by
+ *          powers of 2 to balance their magnitudes, on copies.
  */
 void winograd_mult(MATRIX* m1, MATRIX* m2, MATRIX* res)
 {
@@ -108,25 +166,41 @@ void winograd_mult(MATRIX* m1, MATRIX* m2, MATRIX* res)
         printf("Error: Matrices cannot be multiplied");
         return;
     }
+
+#ifdef BIGNUM_UNIT_ROUNDOFF
+    // Winograd's algorithm adds entries of m1 to entries of m2, so when
+    // their magnitudes differ widely the smaller ones are lost in the
+    // sums. Multiplying m1 by 2^e and m2 by 2^-e leaves the product as
+    // it is, exactly, and balances them (see winograd_error_bound).
+    int e = balance_exponent(m1, m2);
+    if (e != 0)
+    {
+        MATRIX* scaled1 = malloc(sizeof(MATRIX));
+        MATRIX* scaled2 = malloc(sizeof(MATRIX));
+        scaled_copy(m1, e, scaled1);
+        scaled_copy(m2, -e, scaled2);
+        winograd_mult(scaled1, scaled2, res);
+        free_matrix(scaled1);
+        free_matrix(scaled2);
+        return;
+    }
+#endif
     
     // Prepocess the matrices
     BIGNUM* rowFactor = malloc(m1RowSize * sizeof(BIGNUM));
     BIGNUM* columnFactor = malloc(m2ColSize * sizeof(BIGNUM));    
+    memtrack_alloc((m1RowSize + m2ColSize) * sizeof(BIGNUM));
+    perf_begin(&preprocessPhase);
     winograd_preprocess(m1, m2, rowFactor, columnFactor);
+    perf_end(&preprocessPhase);
 
-    // Fill in matrix information
-    res->numRows = m1RowSize;
-    res->numCols = m2ColSize;
-
-    // Allocate memory for the rows of the matrix.
-    res->matrix = (BIGNUM**) malloc(m1RowSize * sizeof(BIGNUM*));
+    // Allocate memory for the matrix.
+    alloc_matrix(m1RowSize, m2ColSize, res);
     
     // Apply winograd's algorithm
+    perf_begin(&multiplyPhase);
     for (int i = 0; i < m1RowSize; i++)
     {
-        // Allocate memory for each entry in the matrix.
-        res->matrix[i] = (BIGNUM*) malloc(m2ColSize * sizeof(BIGNUM));
-            
         for (int j = 0; j < m2ColSize; j++)
         {
             // Note we must negate the bignums first.
@@ -136,29 +210,19 @@ void winograd_mult(MATRIX* m1, MATRIX* m2, MATRIX* res)
             add_bignums(&rowFactor[i], &columnFactor[j], &res->matrix[i][j]);
             for (int k = 0; k < d; k++)
             {
-                // Initialize temp variables for bignum operations.
-                BIGNUM* temp1 = malloc(sizeof(BIGNUM));
-                bignum_from_int(0, temp1);
-	            add_bignums(&m1->matrix[i][(2*k)], &m2->matrix[(2*k+1)][j], temp1);
-	            
-                BIGNUM* temp2 = malloc(sizeof(BIGNUM));
-                bignum_from_int(0, temp2);	            
-	            add_bignums(&m1->matrix[i][(2*k+1)], &m2->matrix[(2*k)][j], temp2);
-	            
-	            BIGNUM* temp3 = malloc(sizeof(BIGNUM));
-                bignum_from_int(0, temp3);
-	            mult_bignums(temp1, temp2, temp3);
-	            
-  	            BIGNUM* temp4 = malloc(sizeof(BIGNUM));
-                bignum_from_int(0, temp4);
-                add_bignums(&res->matrix[i][j], temp3, temp4);
-                res->matrix[i][j] = *temp4;
+                // The temporaries live on the stack: a malloc for each
+                // of them would cost more than the arithmetic for the
+                // word-sized bignum types.
+                BIGNUM temp1, temp2, temp3, temp4;
+                add_bignums(&m1->matrix[i][(2*k)], &m2->matrix[(2*k+1)][j], &temp1);
+                add_bignums(&m1->matrix[i][(2*k+1)], &m2->matrix[(2*k)][j], &temp2);
+                
+                // mult_bignums adds into its result, so start from zero.
+                bignum_from_int(0, &temp3);
+                mult_bignums(&temp1, &temp2, &temp3);
                 
-                // Free temp variables when done.
-                free(temp1);
-                free(temp2);
-                free(temp3);
-                free(temp4);
+                add_bignums(&res->matrix[i][j], &temp3, &temp4);
+                res->matrix[i][j] = temp4;
             }
             
             // We renegate the bignums to return them back to their original sign.
@@ -166,44 +230,44 @@ void winograd_mult(MATRIX* m1, MATRIX* m2, MATRIX* res)
             negate_bignums(&columnFactor[j]);
         }
     }
+    perf_end(&multiplyPhase);
 
-    // make room for odd shared values
+    // make room for odd shared values: the last column of m1 times the
+    // last row of m2, added in by multiply_accumulate (through
+    // bignum_axpy for the types that have it)
     if (m1ColSize%2 != 0)
     {
-        for (int i = 0; i < m1RowSize; i++)
-	    {
-	        for (int j = 0; j < m2ColSize; j++)
-	        {
-	            // Initialize temp variables for bignum operations.
-	            BIGNUM* temp1 = malloc(sizeof(BIGNUM));
-	            bignum_from_int(0,temp1);
-	            mult_bignums(&m1->matrix[i][m1ColSize-1], &m2->matrix[m1ColSize-1][j], temp1);
-	            
-	            BIGNUM* temp2 = malloc(sizeof(BIGNUM));
-	            bignum_from_int(0,temp2);	            
-	            add_bignums(&res->matrix[i][j], temp1, temp2);
-	            res->matrix[i][j] = *temp2;
-	            
-	            // Free temporary variables.
-	            free(temp1);
-	            free(temp2);
-	        }
-	    }
+        perf_begin(&oddPhase);
+        MATRIX* lastColumn = malloc(sizeof(MATRIX));
+        MATRIX* lastRow = malloc(sizeof(MATRIX));
+        view_matrix(m1, 0, m1ColSize-1, m1RowSize, 1, lastColumn);
+        view_matrix(m2, m1ColSize-1, 0, 1, m2ColSize, lastRow);
+        multiply_accumulate(lastColumn, lastRow, res);
+        free_view(lastColumn);
+        free_view(lastRow);
+        perf_end(&oddPhase);
     }
     
     // Free row and column factors.
     free(rowFactor);
     free(columnFactor);    
+    memtrack_release((m1RowSize + m2ColSize) * sizeof(BIGNUM));
 }
 
+#ifndef NO_MAIN
+
 int main(void)
 {
    // Structs for timing data.
     struct rusage before, after;
     double ti_multiply=0.0;
     
-    // Seed random number generator.
+    // Open hardware counters if PERF_COUNTERS is set.
+    perf_init();
+    
+    // Seed random number generators. MATRIX_SEED overrides the seed.
 	srand(time(NULL));
+	gen_set_seed(time(NULL));
 	
 	// Initalize matrixes. Change values here for different size matrices.
 	// Note that for winograd, m1->numCols and m2->numRows have to be > 1
@@ -227,9 +291,15 @@ int main(void)
     
     // Print out computation time.
     printf("\nTime Spent (in sec): %f\n", (ti_multiply));
+    perf_report();
+    memtrack_report();
+    
+    // Check the product if VERIFY_ROUNDS is set.
+    verify_from_env(m1, m2, m3);
     
     // Free matrices when done with them.
     free_matrix(m1);
     free_matrix(m2);
     free_matrix(m3);
 }
+#endif